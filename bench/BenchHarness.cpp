@@ -0,0 +1,229 @@
+#include "BenchHarness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+std::atomic<std::uint64_t> optimizationSink{0};
+
+double medianOf(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const std::size_t middle = values.size() / 2;
+    return values.size() % 2 == 1 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+// Case names are generated from fixed parts, but quote and backslash would
+// still break the file.
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            escaped += '\\';
+        }
+        escaped += ch;
+    }
+    return escaped;
+}
+
+// Value of "key": "..." on a line written by writeBenchJson.
+bool findStringField(const std::string& line, const char* key, std::string& value) {
+    const std::string pattern = std::string("\"") + key + "\": \"";
+    const std::size_t start = line.find(pattern);
+    if (start == std::string::npos) {
+        return false;
+    }
+
+    value.clear();
+    for (std::size_t index = start + pattern.size(); index < line.size(); ++index) {
+        if (line[index] == '\\' && index + 1 < line.size()) {
+            value += line[++index];
+        } else if (line[index] == '"') {
+            return true;
+        } else {
+            value += line[index];
+        }
+    }
+    return false;
+}
+
+bool findNumberField(const std::string& line, const char* key, double& value) {
+    const std::string pattern = std::string("\"") + key + "\": ";
+    const std::size_t start = line.find(pattern);
+    if (start == std::string::npos) {
+        return false;
+    }
+
+    const char* begin = line.c_str() + start + pattern.size();
+    char* end = nullptr;
+    value = std::strtod(begin, &end);
+    return end != begin;
+}
+} // namespace
+
+void BenchRegistry::add(BenchCase benchCase) {
+    cases_.push_back(std::move(benchCase));
+}
+
+BenchResult runBenchCase(const BenchCase& benchCase, const BenchOptions& options) {
+    using Clock = std::chrono::steady_clock;
+
+    BenchResult result;
+    result.name = benchCase.name;
+    result.group = benchCase.group;
+    result.unit = benchCase.unit;
+    result.isMacro = benchCase.isMacro;
+    result.bytesPerOp = benchCase.bytesPerOp;
+
+    // Warms caches, the thread pool and any lazily built input.
+    doNotOptimize(benchCase.run());
+    if (benchCase.measureBytesPerOp) {
+        result.bytesPerOp = benchCase.measureBytesPerOp();
+    }
+
+    std::vector<double> nsPerOp;
+    nsPerOp.reserve(static_cast<std::size_t>(options.sampleCount));
+    for (int sample = 0; sample < options.sampleCount; ++sample) {
+        std::uint64_t ops = 0;
+        const Clock::time_point start = Clock::now();
+        double elapsedSeconds = 0.0;
+        do {
+            ops += benchCase.run();
+            elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsedSeconds < options.minSampleSeconds);
+
+        result.totalOps += ops;
+        nsPerOp.push_back(elapsedSeconds * 1e9 / static_cast<double>(std::max<std::uint64_t>(ops, 1)));
+    }
+
+    result.sampleCount = options.sampleCount;
+    result.medianNsPerOp = medianOf(nsPerOp);
+    result.minNsPerOp = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+    result.maxNsPerOp = *std::max_element(nsPerOp.begin(), nsPerOp.end());
+    return result;
+}
+
+bool writeBenchJson(const std::vector<BenchResult>& results, const BenchEnvironment& environment, const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"schema\": 1,\n");
+    std::fprintf(file, "  \"simd_level\": \"%s\",\n", escapeJson(environment.simdLevel).c_str());
+    std::fprintf(file, "  \"hardware_threads\": %d,\n", environment.hardwareThreads);
+    std::fprintf(file, "  \"build_type\": \"%s\",\n", escapeJson(environment.buildType).c_str());
+    std::fprintf(file, "  \"metrics_enabled\": %s,\n", environment.metricsEnabled ? "true" : "false");
+    std::fprintf(file, "  \"quick\": %s,\n", environment.quick ? "true" : "false");
+    std::fprintf(file, "  \"frame_build_available\": %s,\n", environment.frameBuildAvailable ? "true" : "false");
+    std::fprintf(file, "  \"benchmarks\": [\n");
+    // One case per line, which is all readBenchBaseline relies on.
+    for (std::size_t index = 0; index < results.size(); ++index) {
+        const BenchResult& result = results[index];
+        std::fprintf(
+            file,
+            "    {\"name\": \"%s\", \"group\": \"%s\", \"kind\": \"%s\", \"unit\": \"%s\", \"samples\": %d, \"ops\": %llu, "
+            "\"median_ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f, \"ops_per_second\": %.1f, "
+            "\"bytes_per_second\": %.1f}%s\n",
+            escapeJson(result.name).c_str(),
+            escapeJson(result.group).c_str(),
+            result.isMacro ? "macro" : "micro",
+            escapeJson(result.unit).c_str(),
+            result.sampleCount,
+            static_cast<unsigned long long>(result.totalOps),
+            result.medianNsPerOp,
+            result.minNsPerOp,
+            result.maxNsPerOp,
+            result.opsPerSecond(),
+            result.bytesPerOp * result.opsPerSecond(),
+            index + 1 < results.size() ? "," : ""
+        );
+    }
+    std::fprintf(file, "  ]\n");
+    std::fprintf(file, "}\n");
+    return std::fclose(file) == 0;
+}
+
+bool readBenchBaseline(const std::string& path, std::vector<BenchBaselineEntry>& entries, std::string& error) {
+    std::ifstream input(path);
+    if (!input) {
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+
+    entries.clear();
+    std::string line;
+    while (std::getline(input, line)) {
+        BenchBaselineEntry entry;
+        if (findStringField(line, "name", entry.name) && findNumberField(line, "median_ns_per_op", entry.medianNsPerOp)) {
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    if (entries.empty()) {
+        error = "'" + path + "' holds no benchmark results";
+        return false;
+    }
+    return true;
+}
+
+BenchComparison compareWithBaseline(
+    const std::vector<BenchBaselineEntry>& baseline,
+    const std::vector<BenchBaselineEntry>& current,
+    double thresholdPercent
+) {
+    std::unordered_map<std::string, double> baselineByName;
+    for (const BenchBaselineEntry& entry : baseline) {
+        baselineByName[entry.name] = entry.medianNsPerOp;
+    }
+
+    BenchComparison comparison;
+    std::printf("\n%-64s %14s %14s %9s\n", "case", "baseline ns", "current ns", "change");
+    for (const BenchBaselineEntry& entry : current) {
+        const auto found = baselineByName.find(entry.name);
+        if (found == baselineByName.end() || found->second <= 0.0) {
+            ++comparison.missingCount;
+            continue;
+        }
+
+        ++comparison.comparedCount;
+        const double changePercent = (entry.medianNsPerOp / found->second - 1.0) * 100.0;
+        const char* flag = "";
+        if (changePercent > thresholdPercent) {
+            ++comparison.regressionCount;
+            flag = "  [REGRESSION]";
+        } else if (changePercent < -thresholdPercent) {
+            ++comparison.improvementCount;
+            flag = "  [faster]";
+        }
+        std::printf(
+            "%-64s %14.2f %14.2f %+8.1f%%%s\n",
+            entry.name.c_str(),
+            found->second,
+            entry.medianNsPerOp,
+            changePercent,
+            flag
+        );
+    }
+
+    std::printf(
+        "\n%d case(s) compared: %d regression(s), %d improvement(s) beyond %.1f%%; %d case(s) not in the baseline.\n",
+        comparison.comparedCount,
+        comparison.regressionCount,
+        comparison.improvementCount,
+        thresholdPercent,
+        comparison.missingCount
+    );
+    return comparison;
+}
+
+void doNotOptimize(std::uint64_t value) {
+    optimizationSink.fetch_xor(value, std::memory_order_relaxed);
+}
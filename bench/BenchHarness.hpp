@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One measured case. run() does a fixed amount of work and returns how many
+// operations (maps, stages, frames, ...) that was; the harness calls it until
+// a sample has lasted long enough and reports nanoseconds per operation.
+struct BenchCase {
+    // Unique key such as "generate/batch/6x8/single/stages=20000/threads=4";
+    // baselines are matched by it.
+    std::string name;
+    std::string group;
+    // What one operation is, for the report.
+    std::string unit;
+    bool isMacro = false;
+    // Bytes one operation reads or writes, 0 if throughput in bytes means nothing.
+    double bytesPerOp = 0.0;
+    // Replaces bytesPerOp after the warm-up call, for sizes only known once
+    // the case has produced its file.
+    std::function<double()> measureBytesPerOp;
+    std::function<std::uint64_t()> run;
+};
+
+struct BenchOptions {
+    int sampleCount = 5;
+    double minSampleSeconds = 0.05;
+    // Smaller matrix and shorter samples, for a smoke run.
+    bool quick = false;
+    // Only cases whose name contains this run.
+    std::string filter;
+    // Worker thread counts of the macro matrix.
+    std::vector<int> threadCounts;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string group;
+    std::string unit;
+    bool isMacro = false;
+    int sampleCount = 0;
+    std::uint64_t totalOps = 0;
+    double medianNsPerOp = 0.0;
+    double minNsPerOp = 0.0;
+    double maxNsPerOp = 0.0;
+    double bytesPerOp = 0.0;
+
+    double opsPerSecond() const {
+        return medianNsPerOp > 0.0 ? 1e9 / medianNsPerOp : 0.0;
+    }
+};
+
+class BenchRegistry {
+public:
+    void add(BenchCase benchCase);
+
+    std::vector<BenchCase>& cases() {
+        return cases_;
+    }
+
+private:
+    std::vector<BenchCase> cases_;
+};
+
+// One warm-up call, then sampleCount samples of at least minSampleSeconds.
+BenchResult runBenchCase(const BenchCase& benchCase, const BenchOptions& options);
+
+struct BenchEnvironment {
+    std::string simdLevel;
+    int hardwareThreads = 0;
+    std::string buildType;
+    bool metricsEnabled = false;
+    bool quick = false;
+    bool frameBuildAvailable = false;
+};
+
+bool writeBenchJson(const std::vector<BenchResult>& results, const BenchEnvironment& environment, const std::string& path);
+
+struct BenchBaselineEntry {
+    std::string name;
+    double medianNsPerOp = 0.0;
+};
+
+// Reads a file written by writeBenchJson. Only the name and median of every
+// case are used; anything else in the file is ignored.
+bool readBenchBaseline(const std::string& path, std::vector<BenchBaselineEntry>& entries, std::string& error);
+
+struct BenchComparison {
+    int comparedCount = 0;
+    int regressionCount = 0;
+    int improvementCount = 0;
+    int missingCount = 0;
+};
+
+// Prints one line per case found in both, flagging a case as a regression
+// when its median is more than thresholdPercent slower than the baseline.
+BenchComparison compareWithBaseline(
+    const std::vector<BenchBaselineEntry>& baseline,
+    const std::vector<BenchBaselineEntry>& current,
+    double thresholdPercent
+);
+
+// Mixes value into a sink the optimizer cannot see through.
+void doNotOptimize(std::uint64_t value);
+
+void registerValidatorBenchmarks(BenchRegistry& registry, const BenchOptions& options);
+void registerPipelineBenchmarks(BenchRegistry& registry, const BenchOptions& options);
+// False when tile_bench was built without Dear ImGui (TILE_MATCHING_BUILD_UI=OFF).
+bool registerFrameBuildBenchmarks(BenchRegistry& registry, const BenchOptions& options);
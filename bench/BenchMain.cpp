@@ -0,0 +1,277 @@
+#include "BenchHarness.hpp"
+
+#include "core/GenerationMetrics.hpp"
+#include "core/VerticalMatchValidator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef TILE_BENCH_BUILD_TYPE
+#define TILE_BENCH_BUILD_TYPE ""
+#endif
+
+namespace {
+struct BenchCliOptions {
+    BenchOptions bench;
+    std::string jsonPath;
+    std::string baselinePath;
+    double thresholdPercent = 10.0;
+    bool listOnly = false;
+};
+
+void printUsage(std::FILE* stream) {
+    std::fprintf(
+        stream,
+        "Usage: tile_bench [options]\n"
+        "       tile_bench compare BASELINE CURRENT [--threshold PCT]\n"
+        "\n"
+        "  --json PATH          write the results as JSON\n"
+        "  --baseline PATH      compare with an earlier --json file and exit with 1\n"
+        "                       if any case got slower than --threshold\n"
+        "  --threshold PCT      slowdown of the median that counts as a regression\n"
+        "                       (default 10)\n"
+        "  --filter TEXT        only run cases whose name contains TEXT\n"
+        "  --threads LIST       comma-separated worker counts of the generation and\n"
+        "                       import cases (default: 1 and one per hardware thread)\n"
+        "  --samples N          samples per case, the median is reported (default 5)\n"
+        "  --min-time SECONDS   shortest sample (default 0.05)\n"
+        "  --quick              smaller matrix and shorter samples, for a smoke run\n"
+        "  --list               print the case names and exit\n"
+        "  --help               show this message\n"
+        "\n"
+        "Every case is fixed-seed, so two runs of the same build do the same work.\n"
+        "compare checks two --json files without running anything.\n"
+    );
+}
+
+template <typename T>
+bool parseNumber(const char* text, T& value) {
+    const char* end = text + std::strlen(text);
+    const auto [parsedEnd, error] = std::from_chars(text, end, value);
+    return error == std::errc() && parsedEnd == end;
+}
+
+bool parseThreadCounts(const std::string& text, std::vector<int>& threadCounts) {
+    threadCounts.clear();
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        const std::size_t comma = std::min(text.find(',', start), text.size());
+        const std::string item = text.substr(start, comma - start);
+        int threadCount = 0;
+        if (!parseNumber(item.c_str(), threadCount) || threadCount < 1) {
+            return false;
+        }
+        threadCounts.push_back(threadCount);
+        start = comma + 1;
+    }
+    return !threadCounts.empty();
+}
+
+bool parseArguments(int argc, char** argv, BenchCliOptions& options) {
+    for (int argIndex = 1; argIndex < argc; ++argIndex) {
+        const std::string name = argv[argIndex];
+        if (name == "--help" || name == "-h") {
+            printUsage(stdout);
+            std::exit(0);
+        }
+        if (name == "--quick") {
+            options.bench.quick = true;
+            continue;
+        }
+        if (name == "--list") {
+            options.listOnly = true;
+            continue;
+        }
+
+        if (argIndex + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for '%s'.\n", name.c_str());
+            return false;
+        }
+        const char* value = argv[++argIndex];
+
+        bool parsed = true;
+        if (name == "--json") {
+            options.jsonPath = value;
+            parsed = !options.jsonPath.empty();
+        } else if (name == "--baseline") {
+            options.baselinePath = value;
+            parsed = !options.baselinePath.empty();
+        } else if (name == "--threshold") {
+            parsed = parseNumber(value, options.thresholdPercent) && options.thresholdPercent >= 0.0;
+        } else if (name == "--filter") {
+            options.bench.filter = value;
+        } else if (name == "--threads") {
+            parsed = parseThreadCounts(value, options.bench.threadCounts);
+        } else if (name == "--samples") {
+            parsed = parseNumber(value, options.bench.sampleCount) && options.bench.sampleCount >= 1;
+        } else if (name == "--min-time") {
+            parsed = parseNumber(value, options.bench.minSampleSeconds) && options.bench.minSampleSeconds >= 0.0;
+        } else {
+            std::fprintf(stderr, "Unknown option '%s'.\n", name.c_str());
+            return false;
+        }
+
+        if (!parsed) {
+            std::fprintf(stderr, "Invalid value '%s' for '%s'.\n", value, name.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<BenchBaselineEntry> toBaselineEntries(const std::vector<BenchResult>& results) {
+    std::vector<BenchBaselineEntry> entries;
+    entries.reserve(results.size());
+    for (const BenchResult& result : results) {
+        entries.push_back(BenchBaselineEntry{result.name, result.medianNsPerOp});
+    }
+    return entries;
+}
+
+int runCompare(int argc, char** argv) {
+    double thresholdPercent = 10.0;
+    std::vector<std::string> paths;
+    for (int argIndex = 2; argIndex < argc; ++argIndex) {
+        const std::string name = argv[argIndex];
+        if (name == "--threshold" && argIndex + 1 < argc) {
+            if (!parseNumber(argv[++argIndex], thresholdPercent) || thresholdPercent < 0.0) {
+                std::fprintf(stderr, "Invalid value '%s' for '--threshold'.\n", argv[argIndex]);
+                return 2;
+            }
+        } else {
+            paths.push_back(name);
+        }
+    }
+    if (paths.size() != 2) {
+        std::fprintf(stderr, "compare needs a baseline and a current JSON file.\n");
+        printUsage(stderr);
+        return 2;
+    }
+
+    std::vector<BenchBaselineEntry> baseline;
+    std::vector<BenchBaselineEntry> current;
+    std::string error;
+    if (!readBenchBaseline(paths[0], baseline, error) || !readBenchBaseline(paths[1], current, error)) {
+        std::fprintf(stderr, "[ERROR] %s\n", error.c_str());
+        return 2;
+    }
+    return compareWithBaseline(baseline, current, thresholdPercent).regressionCount > 0 ? 1 : 0;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::strcmp(argv[1], "compare") == 0) {
+        return runCompare(argc, argv);
+    }
+
+    BenchCliOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(stderr);
+        return 2;
+    }
+
+    const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (options.bench.threadCounts.empty()) {
+        options.bench.threadCounts.push_back(1);
+        if (hardwareThreads > 1) {
+            options.bench.threadCounts.push_back(hardwareThreads);
+        }
+    }
+    if (options.bench.quick) {
+        options.bench.sampleCount = std::min(options.bench.sampleCount, 3);
+        options.bench.minSampleSeconds = std::min(options.bench.minSampleSeconds, 0.01);
+    }
+
+    // Read before running, so a wrong path does not cost a whole run.
+    std::vector<BenchBaselineEntry> baseline;
+    if (!options.baselinePath.empty()) {
+        std::string error;
+        if (!readBenchBaseline(options.baselinePath, baseline, error)) {
+            std::fprintf(stderr, "[ERROR] %s\n", error.c_str());
+            return 2;
+        }
+    }
+
+    BenchRegistry registry;
+    registerValidatorBenchmarks(registry, options.bench);
+    registerPipelineBenchmarks(registry, options.bench);
+    BenchEnvironment environment;
+    environment.frameBuildAvailable = registerFrameBuildBenchmarks(registry, options.bench);
+    environment.simdLevel = getSimdLevelName(detectSimdLevel());
+    environment.hardwareThreads = hardwareThreads;
+    environment.buildType = TILE_BENCH_BUILD_TYPE;
+    environment.metricsEnabled = TILE_MATCHING_METRICS != 0;
+    environment.quick = options.bench.quick;
+
+    std::vector<BenchCase>& cases = registry.cases();
+    if (!options.bench.filter.empty()) {
+        std::erase_if(cases, [&](const BenchCase& benchCase) {
+            return benchCase.name.find(options.bench.filter) == std::string::npos;
+        });
+    }
+    if (options.listOnly) {
+        for (const BenchCase& benchCase : cases) {
+            std::printf("%s\n", benchCase.name.c_str());
+        }
+        return 0;
+    }
+
+    std::printf(
+        "[INFO] %zu case(s), SIMD level %s, %d hardware thread(s), %s build%s.\n",
+        cases.size(),
+        environment.simdLevel.c_str(),
+        hardwareThreads,
+        environment.buildType.empty() ? "unknown" : environment.buildType.c_str(),
+        environment.frameBuildAvailable ? "" : ", frame cases skipped (built without Dear ImGui)"
+    );
+    if (environment.metricsEnabled) {
+        std::printf(
+            "[INFO] Generation metrics are compiled in; "
+            "configure with TILE_MATCHING_ENABLE_METRICS=OFF for final numbers.\n"
+        );
+    }
+
+    std::vector<BenchResult> results;
+    results.reserve(cases.size());
+    for (BenchCase& benchCase : cases) {
+        const BenchResult result = runBenchCase(benchCase, options.bench);
+        std::printf(
+            "%-64s %12.1f ns/%s %14.0f %s/s",
+            result.name.c_str(),
+            result.medianNsPerOp,
+            result.unit.c_str(),
+            result.opsPerSecond(),
+            result.unit.c_str()
+        );
+        if (result.bytesPerOp > 0.0) {
+            std::printf(" %9.1f MB/s", result.bytesPerOp * result.opsPerSecond() / (1024.0 * 1024.0));
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+        results.push_back(result);
+        // Drops the batches and temporary files the case built.
+        benchCase = BenchCase{};
+    }
+
+    if (!options.jsonPath.empty()) {
+        if (!writeBenchJson(results, environment, options.jsonPath)) {
+            std::fprintf(stderr, "[ERROR] Failed to write '%s'.\n", options.jsonPath.c_str());
+            return 2;
+        }
+        std::printf("[INFO] Wrote '%s'.\n", options.jsonPath.c_str());
+    }
+
+    if (!baseline.empty()) {
+        const BenchComparison comparison =
+            compareWithBaseline(baseline, toBaselineEntries(results), options.thresholdPercent);
+        return comparison.regressionCount > 0 ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "BenchHarness.hpp"
+
+#if TILE_BENCH_WITH_IMGUI
+
+#include "core/StageGenerator.hpp"
+#include "core/StageStore.hpp"
+#include "ui/LogBuffer.hpp"
+#include "ui/TileGridRenderer.hpp"
+
+#include <imgui.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// Same window size as the app, so clipping behaves as it does on screen.
+constexpr float kDisplayWidth = 1500.0f;
+constexpr float kDisplayHeight = 950.0f;
+constexpr int kFramesPerRun = 16;
+
+// One ImGui context for every frame case, without a platform or renderer
+// backend: the font atlas is built once on the CPU and the draw data of each
+// frame is only walked, never uploaded.
+ImGuiContext* getHeadlessContext() {
+    static ImGuiContext* context = [] {
+        IMGUI_CHECKVERSION();
+        ImGuiContext* created = ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(kDisplayWidth, kDisplayHeight);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.Fonts->AddFontDefault();
+        unsigned char* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+        return created;
+    }();
+    ImGui::SetCurrentContext(context);
+    return context;
+}
+
+// Stands in for RenderDrawData: touches what a renderer would read so the
+// vertex and index counts stay observable.
+std::uint64_t consumeDrawData(const ImDrawData* drawData) {
+    std::uint64_t consumed = 0;
+    if (drawData == nullptr) {
+        return consumed;
+    }
+    for (const ImDrawList* drawList : drawData->CmdLists) {
+        consumed += static_cast<std::uint64_t>(drawList->VtxBuffer.Size) + drawList->IdxBuffer.Size;
+        for (const ImDrawCmd& command : drawList->CmdBuffer) {
+            consumed += command.ElemCount;
+        }
+    }
+    return consumed;
+}
+
+template <typename BuildWindows>
+std::uint64_t buildFrames(BuildWindows&& buildWindows) {
+    getHeadlessContext();
+    std::uint64_t consumed = 0;
+    for (int frame = 0; frame < kFramesPerRun; ++frame) {
+        ImGui::NewFrame();
+        buildWindows();
+        ImGui::Render();
+        consumed += consumeDrawData(ImGui::GetDrawData());
+    }
+    doNotOptimize(consumed);
+    return static_cast<std::uint64_t>(kFramesPerRun);
+}
+
+void addViewerCase(BenchRegistry& registry, int width, int height) {
+    struct ViewerState {
+        StageStore stages;
+        TileLabelCache labelCache;
+    };
+    auto state = std::make_shared<ViewerState>();
+
+    BenchCase benchCase;
+    benchCase.name = "frame/viewer/" + std::to_string(width) + "x" + std::to_string(height);
+    benchCase.group = "frame";
+    benchCase.unit = "frame";
+    benchCase.run = [state, width, height] {
+        if (state->stages.empty()) {
+            state->stages = createStages(1, width, height, false);
+        }
+        return buildFrames([&] {
+            ImGui::SetNextWindowPos(ImVec2(470.0f, 10.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(1020.0f, 930.0f), ImGuiCond_Always);
+            ImGui::Begin("Viewer");
+            const MapView map = state->stages.map(0, 0);
+            ImGui::Text("Tile Map (%d x %d)", map.width, map.height);
+            ImGui::Separator();
+            ImGui::BeginChild("TileGrid", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+            doNotOptimize(static_cast<std::uint64_t>(drawTileGrid("##Tiles", map, state->labelCache) + 1));
+            ImGui::EndChild();
+            ImGui::End();
+        });
+    };
+    registry.add(std::move(benchCase));
+}
+
+void addGenerationLogsCase(BenchRegistry& registry, int lineCount) {
+    struct LogsState {
+        LogBuffer logs;
+        LogFilter filter;
+        bool filled = false;
+    };
+    auto state = std::make_shared<LogsState>();
+
+    BenchCase benchCase;
+    benchCase.name = "frame/logs/lines=" + std::to_string(lineCount);
+    benchCase.group = "frame";
+    benchCase.unit = "frame";
+    benchCase.run = [state, lineCount] {
+        if (!state->filled) {
+            char line[96];
+            for (int lineIndex = 0; lineIndex < lineCount; ++lineIndex) {
+                std::snprintf(
+                    line,
+                    sizeof(line),
+                    "[INFO] Stage %d: map shuffled and arranged without vertical matches.",
+                    lineIndex + 1
+                );
+                state->logs.append(line);
+            }
+            state->filled = true;
+        }
+        return buildFrames([&] {
+            ImGui::SetNextWindowPos(ImVec2(10.0f, 480.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(450.0f, 460.0f), ImGuiCond_Always);
+            ImGui::Begin("Generation Logs");
+            const std::vector<std::uint64_t>& visibleLogs = state->filter.update(state->logs);
+            ImGui::Text("%zu / %zu line(s)", visibleLogs.size(), state->logs.size());
+            ImGui::Separator();
+            ImGui::BeginChild("LogLines", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+            ImGuiListClipper logClipper;
+            logClipper.Begin(static_cast<int>(visibleLogs.size()));
+            while (logClipper.Step()) {
+                for (int lineIndex = logClipper.DisplayStart; lineIndex < logClipper.DisplayEnd; ++lineIndex) {
+                    const LogRecord& record = state->logs.record(visibleLogs[lineIndex]);
+                    const std::string_view text = state->logs.text(record);
+                    char timestamp[16];
+                    formatLogTimestamp(record.timestampMs, timestamp, sizeof(timestamp));
+                    ImGui::Text(
+                        "%s [%s] %.*s",
+                        timestamp,
+                        getLogSeverityTag(record.severity),
+                        static_cast<int>(text.size()),
+                        text.data()
+                    );
+                }
+            }
+            logClipper.End();
+            ImGui::EndChild();
+            ImGui::End();
+        });
+    };
+    registry.add(std::move(benchCase));
+}
+} // namespace
+
+bool registerFrameBuildBenchmarks(BenchRegistry& registry, const BenchOptions& options) {
+    const std::vector<int> gridSizes = options.quick ? std::vector<int>{8, 512} : std::vector<int>{8, 64, 512};
+    for (const int gridSize : gridSizes) {
+        addViewerCase(registry, gridSize, gridSize);
+    }
+    addGenerationLogsCase(registry, 10000);
+    return true;
+}
+
+#else
+
+bool registerFrameBuildBenchmarks(BenchRegistry&, const BenchOptions&) {
+    return false;
+}
+
+#endif
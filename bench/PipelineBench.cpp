@@ -0,0 +1,339 @@
+#include "BenchHarness.hpp"
+
+#include "core/StageCsvExporter.hpp"
+#include "core/StageCsvImporter.hpp"
+#include "core/StageFingerprint.hpp"
+#include "core/StageGenerator.hpp"
+#include "core/StagePack.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+constexpr std::uint64_t kBenchMasterSeed = 0x5EED'0000'0000'0001ull;
+
+struct MapSize {
+    int width;
+    int height;
+};
+
+std::string describeSize(MapSize size) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+const char* describeMode(bool isMultiplayerMode) {
+    return isMultiplayerMode ? "multi" : "single";
+}
+
+// Removes its file when the case that wrote it is released.
+class TempFile {
+public:
+    explicit TempFile(const std::string& stem) {
+        std::string fileName = "tile_bench_" + stem;
+        for (char& ch : fileName) {
+            const bool keep = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '.';
+            if (!keep) {
+                ch = '_';
+            }
+        }
+        std::error_code error;
+        path_ = (std::filesystem::temp_directory_path(error) / fileName).string();
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    ~TempFile() {
+        std::error_code error;
+        std::filesystem::remove(path_, error);
+    }
+
+    const std::string& path() const {
+        return path_;
+    }
+
+private:
+    std::string path_;
+};
+
+// One pool per thread count, created on first use, so registering the whole
+// matrix does not start its threads up front.
+WorkStealingPool& getSharedPool(int threadCount) {
+    static std::map<int, std::unique_ptr<WorkStealingPool>> pools;
+    std::unique_ptr<WorkStealingPool>& pool = pools[threadCount];
+    if (!pool) {
+        pool = std::make_unique<WorkStealingPool>(threadCount);
+    }
+    return *pool;
+}
+
+StageStore generateBatch(int stageCount, MapSize size, bool isMultiplayerMode, WorkStealingPool& pool) {
+    StageStore stages = createStages(stageCount, size.width, size.height, isMultiplayerMode);
+    shuffleStageMaps(stages, ShuffleSettings{}, isMultiplayerMode, kBenchMasterSeed, pool, GenerationControl{});
+    return stages;
+}
+
+double fileBytes(const std::string& path) {
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(path, error);
+    return error ? 0.0 : static_cast<double>(size);
+}
+
+void addStageMicroCases(BenchRegistry& registry, MapSize size, bool isMultiplayerMode) {
+    static constexpr int kStagesPerRun = 256;
+
+    const std::string suffix = describeSize(size) + "/" + describeMode(isMultiplayerMode);
+    const bool arrangementPossible = checkStageConfigurationFeasibility(size.width, size.height, isMultiplayerMode).isPossible;
+    const std::size_t stageTileCount =
+        static_cast<std::size_t>(size.width) * size.height * getMapCountPerStage(isMultiplayerMode);
+
+    for (const RngBackend rngBackend : {RngBackend::Mt19937, RngBackend::Xoshiro256StarStar}) {
+        ShuffleSettings shuffleSettings;
+        shuffleSettings.rngBackend = rngBackend;
+
+        BenchCase benchCase;
+        benchCase.name = "shuffle/stage/" + suffix + (rngBackend == RngBackend::Mt19937 ? "/mt19937" : "/xoshiro");
+        benchCase.group = "shuffle";
+        benchCase.unit = "stage";
+        auto tiles = std::make_shared<std::vector<Tile>>(stageTileCount);
+        auto nextStageIndex = std::make_shared<int>(0);
+        benchCase.run = [=] {
+            for (int stage = 0; stage < kStagesPerRun; ++stage) {
+                generateStageTiles(
+                    tiles->data(),
+                    size.width,
+                    size.height,
+                    isMultiplayerMode,
+                    (*nextStageIndex)++,
+                    shuffleSettings,
+                    kBenchMasterSeed,
+                    arrangementPossible
+                );
+            }
+            doNotOptimize((*tiles)[0]);
+            return static_cast<std::uint64_t>(kStagesPerRun);
+        };
+        registry.add(std::move(benchCase));
+    }
+
+    // Both read a small batch generated on first use.
+    auto batch = std::make_shared<StageStore>();
+    auto ensureBatch = [batch, size, isMultiplayerMode] {
+        if (batch->empty()) {
+            *batch = generateBatch(kStagesPerRun, size, isMultiplayerMode, getSharedPool(1));
+        }
+    };
+
+    BenchCase fingerprintCase;
+    fingerprintCase.name = "fingerprint/stage/" + suffix;
+    fingerprintCase.group = "fingerprint";
+    fingerprintCase.unit = "stage";
+    fingerprintCase.bytesPerOp = static_cast<double>(
+        stageTileCount * static_cast<std::size_t>(getStageTileBytes(size.width, getMapCountPerStage(isMultiplayerMode)))
+    );
+    fingerprintCase.run = [batch, ensureBatch] {
+        ensureBatch();
+        std::uint64_t combined = 0;
+        for (int stageIndex = 0; stageIndex < batch->stageCount(); ++stageIndex) {
+            combined ^= batch->visitStageTiles(stageIndex, [&](const auto* stageTiles) {
+                return computeStageFingerprint(stageTiles, batch->stageTileCount(stageIndex));
+            });
+        }
+        doNotOptimize(combined);
+        return static_cast<std::uint64_t>(batch->stageCount());
+    };
+    registry.add(std::move(fingerprintCase));
+
+    if (isMultiplayerMode) {
+        return;
+    }
+
+    BenchCase serializeCase;
+    serializeCase.name = "csv/serialize-map/" + describeSize(size);
+    serializeCase.group = "csv";
+    serializeCase.unit = "map";
+    serializeCase.run = [batch, ensureBatch] {
+        ensureBatch();
+        std::uint64_t characters = 0;
+        for (int stageIndex = 0; stageIndex < batch->stageCount(); ++stageIndex) {
+            characters += serializeMapForCsv(batch->map(stageIndex, 0)).size();
+        }
+        doNotOptimize(characters);
+        return static_cast<std::uint64_t>(batch->stageCount());
+    };
+    registry.add(std::move(serializeCase));
+}
+
+void addBatchGenerationCase(
+    BenchRegistry& registry,
+    MapSize size,
+    bool isMultiplayerMode,
+    int stageCount,
+    int threadCount,
+    bool rejectDuplicates
+) {
+    BenchCase benchCase;
+    benchCase.name = std::string(rejectDuplicates ? "generate/dedup/" : "generate/batch/") + describeSize(size) + "/" +
+        describeMode(isMultiplayerMode) + "/stages=" + std::to_string(stageCount) + "/threads=" + std::to_string(threadCount);
+    benchCase.group = "generate";
+    benchCase.unit = "stage";
+    benchCase.isMacro = true;
+
+    const DistinctArrangementCount distinctStages = countDistinctStageArrangements(
+        size.width,
+        size.height,
+        isMultiplayerMode,
+        static_cast<std::uint64_t>(stageCount)
+    );
+    benchCase.run = [=] {
+        StageStore stages = createStages(stageCount, size.width, size.height, isMultiplayerMode);
+        std::unique_ptr<DuplicateStageFilter> duplicateFilter;
+        if (rejectDuplicates) {
+            duplicateFilter = std::make_unique<DuplicateStageFilter>(stageCount);
+            duplicateFilter->distinctStages = distinctStages;
+        }
+        const int invalidMapCount = shuffleStageMaps(
+            stages,
+            ShuffleSettings{},
+            isMultiplayerMode,
+            kBenchMasterSeed,
+            getSharedPool(threadCount),
+            GenerationControl{},
+            0,
+            duplicateFilter.get()
+        );
+        doNotOptimize(static_cast<std::uint64_t>(invalidMapCount));
+        return static_cast<std::uint64_t>(stageCount);
+    };
+    registry.add(std::move(benchCase));
+}
+
+// Export and import share one generated batch and one file per configuration.
+void addFileCases(
+    BenchRegistry& registry,
+    MapSize size,
+    bool isMultiplayerMode,
+    int stageCount,
+    const std::vector<int>& threadCounts
+) {
+    const std::string suffix =
+        describeSize(size) + "/" + describeMode(isMultiplayerMode) + "/stages=" + std::to_string(stageCount);
+
+    struct FileState {
+        StageStore stages;
+        std::unique_ptr<TempFile> csvFile;
+        std::unique_ptr<TempFile> packFile;
+        bool csvWritten = false;
+    };
+    auto state = std::make_shared<FileState>();
+    state->csvFile = std::make_unique<TempFile>(suffix + ".csv");
+    state->packFile = std::make_unique<TempFile>(suffix + ".tmpack");
+    auto ensureStages = [state, size, isMultiplayerMode, stageCount] {
+        if (state->stages.empty()) {
+            state->stages = generateBatch(stageCount, size, isMultiplayerMode, getSharedPool(0));
+        }
+    };
+    auto ensureCsv = [state, ensureStages, isMultiplayerMode] {
+        if (!state->csvWritten) {
+            ensureStages();
+            state->csvWritten = writeStagesCsv(state->stages, isMultiplayerMode, kBenchMasterSeed, state->csvFile->path());
+        }
+    };
+
+    auto csvBytesPerStage = [state, stageCount] {
+        return fileBytes(state->csvFile->path()) / stageCount;
+    };
+
+    {
+        BenchCase benchCase;
+        benchCase.name = "export/csv/" + suffix;
+        benchCase.group = "export";
+        benchCase.unit = "stage";
+        benchCase.isMacro = true;
+        benchCase.measureBytesPerOp = csvBytesPerStage;
+        benchCase.run = [state, ensureStages, isMultiplayerMode, stageCount] {
+            ensureStages();
+            if (!writeStagesCsv(state->stages, isMultiplayerMode, kBenchMasterSeed, state->csvFile->path())) {
+                std::fprintf(stderr, "failed to write '%s'\n", state->csvFile->path().c_str());
+            }
+            return static_cast<std::uint64_t>(stageCount);
+        };
+        registry.add(std::move(benchCase));
+    }
+
+    {
+        BenchCase benchCase;
+        benchCase.name = "export/pack/" + suffix;
+        benchCase.group = "export";
+        benchCase.unit = "stage";
+        benchCase.isMacro = true;
+        benchCase.measureBytesPerOp = [state, stageCount] {
+            return fileBytes(state->packFile->path()) / stageCount;
+        };
+        benchCase.run = [state, ensureStages, isMultiplayerMode, stageCount] {
+            ensureStages();
+            if (!writeStagePack(state->stages, isMultiplayerMode, kBenchMasterSeed, state->packFile->path())) {
+                std::fprintf(stderr, "failed to write '%s'\n", state->packFile->path().c_str());
+            }
+            return static_cast<std::uint64_t>(stageCount);
+        };
+        registry.add(std::move(benchCase));
+    }
+
+    for (const int threadCount : threadCounts) {
+        BenchCase benchCase;
+        benchCase.name = "import/csv/" + suffix + "/threads=" + std::to_string(threadCount);
+        benchCase.group = "import";
+        benchCase.unit = "stage";
+        benchCase.isMacro = true;
+        benchCase.measureBytesPerOp = csvBytesPerStage;
+        benchCase.run = [state, ensureCsv, threadCount] {
+            ensureCsv();
+            const StageCsvImportResult imported =
+                importStagesCsv(state->csvFile->path(), getSharedPool(threadCount), StageCsvImportOptions{});
+            if (imported.violationCount != 0 || imported.parseErrorCount != 0) {
+                std::fprintf(stderr, "unexpected problems importing '%s'\n", state->csvFile->path().c_str());
+            }
+            return static_cast<std::uint64_t>(imported.stageCount);
+        };
+        registry.add(std::move(benchCase));
+    }
+}
+} // namespace
+
+void registerPipelineBenchmarks(BenchRegistry& registry, const BenchOptions& options) {
+    const std::vector<MapSize> microSizes = options.quick
+        ? std::vector<MapSize>{{6, 8}, {32, 32}}
+        : std::vector<MapSize>{{3, 2}, {6, 8}, {12, 16}, {32, 32}};
+    const std::vector<MapSize> macroSizes = options.quick
+        ? std::vector<MapSize>{{6, 8}}
+        : std::vector<MapSize>{{3, 2}, {6, 8}, {16, 16}};
+    const std::vector<int> stageCounts = options.quick ? std::vector<int>{1000} : std::vector<int>{1000, 20000};
+    const int fileStageCount = stageCounts.back();
+
+    for (const bool isMultiplayerMode : {false, true}) {
+        for (const MapSize size : microSizes) {
+            addStageMicroCases(registry, size, isMultiplayerMode);
+        }
+    }
+
+    for (const bool isMultiplayerMode : {false, true}) {
+        for (const MapSize size : macroSizes) {
+            for (const int stageCount : stageCounts) {
+                for (const int threadCount : options.threadCounts) {
+                    addBatchGenerationCase(registry, size, isMultiplayerMode, stageCount, threadCount, false);
+                }
+            }
+            // Duplicate rejection only at the largest batch and thread count.
+            addBatchGenerationCase(registry, size, isMultiplayerMode, fileStageCount, options.threadCounts.back(), true);
+            addFileCases(registry, size, isMultiplayerMode, fileStageCount, options.threadCounts);
+        }
+    }
+}
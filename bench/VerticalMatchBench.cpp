@@ -0,0 +1,85 @@
+#include "BenchHarness.hpp"
+
+#include "core/VerticalMatchValidator.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+// Builds a map without vertical matches (the common case after arranging and
+// the worst case for the validator, since every pair must be compared).
+template <typename Tile>
+std::vector<Tile> createMatchFreeMap(int width, int height, std::mt19937& rng) {
+    std::vector<Tile> tiles(static_cast<std::size_t>(width) * height);
+    std::uniform_int_distribution<int> anyTile(1, 100);
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            Tile tile = static_cast<Tile>(anyTile(rng));
+            while (row > 0 && tile == tiles[(row - 1) * width + col]) {
+                tile = static_cast<Tile>(anyTile(rng));
+            }
+            tiles[row * width + col] = tile;
+        }
+    }
+    return tiles;
+}
+
+template <typename Tile>
+void addValidatorCases(BenchRegistry& registry, const char* tileTypeName, const BenchOptions& options) {
+    static constexpr int kWidths[] = {3, 8, 16, 32, 64};
+    static constexpr int kQuickWidths[] = {8, 32};
+    static constexpr int kHeights[] = {2, 8, 32};
+    static constexpr int kMapsPerSize = 64;
+    static constexpr SimdLevel kLevels[] = {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2};
+
+    const SimdLevel supportedLevel = detectSimdLevel();
+    std::mt19937 rng(12345);
+    for (const int height : kHeights) {
+        const int* widths = options.quick ? kQuickWidths : kWidths;
+        const int widthCount = options.quick ? static_cast<int>(std::size(kQuickWidths)) : static_cast<int>(std::size(kWidths));
+        for (int widthIndex = 0; widthIndex < widthCount; ++widthIndex) {
+            const int width = widths[widthIndex];
+            auto maps = std::make_shared<std::vector<std::vector<Tile>>>();
+            for (int mapIndex = 0; mapIndex < kMapsPerSize; ++mapIndex) {
+                maps->push_back(createMatchFreeMap<Tile>(width, height, rng));
+            }
+
+            for (const SimdLevel level : kLevels) {
+                if (level > supportedLevel) {
+                    continue;
+                }
+
+                BenchCase benchCase;
+                benchCase.name = std::string("validator/") + tileTypeName + "/" + getSimdLevelName(level) + "/" +
+                    std::to_string(width) + "x" + std::to_string(height);
+                benchCase.group = "validator";
+                benchCase.unit = "map";
+                benchCase.bytesPerOp = static_cast<double>(sizeof(Tile)) * width * height;
+                benchCase.run = [maps, level, width, height] {
+                    std::uint64_t matchCount = 0;
+                    for (const std::vector<Tile>& map : *maps) {
+                        matchCount += hasVerticalMatchWithLevel(level, map.data(), width, height) ? 1 : 0;
+                    }
+                    if (matchCount != 0) {
+                        std::printf("unexpected vertical match\n");
+                    }
+                    return static_cast<std::uint64_t>(maps->size());
+                };
+                registry.add(std::move(benchCase));
+            }
+        }
+    }
+}
+} // namespace
+
+void registerValidatorBenchmarks(BenchRegistry& registry, const BenchOptions& options) {
+    addValidatorCases<std::uint16_t>(registry, "uint16", options);
+    if (!options.quick) {
+        addValidatorCases<std::int32_t>(registry, "int32", options);
+        addValidatorCases<std::uint8_t>(registry, "uint8", options);
+    }
+}
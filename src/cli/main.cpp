@@ -0,0 +1,1161 @@
+#include "core/GenerationMetrics.hpp"
+#include "core/LazyStageSource.hpp"
+#include "core/ParameterSweep.hpp"
+#include "core/StageCsvExporter.hpp"
+#include "core/StageCsvImporter.hpp"
+#include "core/StageGenerator.hpp"
+#include "core/StagePack.hpp"
+#include "core/StageRandom.hpp"
+#include "core/StageShard.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+struct CliOptions {
+    int stageCount = 1;
+    int mapWidth = 3;
+    int mapHeight = 2;
+    bool isMultiplayerMode = false;
+    ShuffleSettings shuffleSettings;
+    bool hasMasterSeed = false;
+    std::uint64_t masterSeed = 0;
+    int threadCount = 0;
+    bool lazyGeneration = false;
+    bool allowDuplicateStages = false;
+    bool writeStagePack = false;
+    bool writeMetrics = false;
+    std::string outputPath;
+    // --shard I/N, shardIndex -1 when the whole batch is generated.
+    int shardIndex = -1;
+    int shardCount = 0;
+    int localShardCount = 0;
+    bool verifyMerge = false;
+};
+
+void printUsage(std::FILE* stream) {
+    std::fprintf(
+        stream,
+        "Usage: tile_gen_cli [options]\n"
+        "       tile_gen_cli validate PATH [--threads N] [--max-report N] [--metrics]\n"
+        "       tile_gen_cli merge SHARD... [--output PATH] [--format csv|pack] [--verify]\n"
+        "                    [--allow-duplicates] [--shuffle-count N] [--kernel K] [--rng R]\n"
+        "                    [--threads N]\n"
+        "       tile_gen_cli sweep [--widths A-B] [--heights A-B] [--modes single|multi|both]\n"
+        "                    [--samples N] [--shuffle-count N] [--kernel K] [--rng R] [--seed N]\n"
+        "                    [--threads N] [--output PATH]\n"
+        "\n"
+        "  --stages N           number of stages to generate (default 1)\n"
+        "  --width N            map width (default 3)\n"
+        "  --height N           map height (default 2)\n"
+        "  --mode single|multi  one map per stage, or two maps sharing numbers (default single)\n"
+        "  --shuffle-count N    shuffle passes per map (default 1)\n"
+        "  --kernel fast|legacy shuffle kernel (default fast)\n"
+        "  --rng mt19937|xoshiro\n"
+        "                       random generator of the fast kernel (default mt19937)\n"
+        "  --seed N             master seed (default: random)\n"
+        "  --threads N          worker threads, 0 = one per hardware thread (default 0)\n"
+        "  --format csv|pack    output format: CSV text or binary stage pack (default csv)\n"
+        "  --output PATH        file to write (default: stages_<mode>_mode.csv or .tmpack)\n"
+        "  --lazy               generate and write one window of stages at a time, so\n"
+        "                       memory stays constant however many stages are requested\n"
+        "  --allow-duplicates   keep stages that repeat an earlier stage instead of\n"
+        "                       regenerating them (always the case with --lazy)\n"
+        "  --metrics            print per-phase timings and generator counters, and\n"
+        "                       write them to OUTPUT.metrics.json\n"
+        "  --shard I/N          generate only shard I (0-based) of N of the batch and\n"
+        "                       write it as a stage pack (default: OUTPUT.shard-I-of-N.tmpack);\n"
+        "                       needs --seed\n"
+        "  --local-shards N     run N --shard processes of this program, then merge their\n"
+        "                       packs into --output\n"
+        "  --verify             with --local-shards or merge: also generate the batch in\n"
+        "                       this process and check the merged stages are identical\n"
+        "  --help               show this message\n"
+        "\n"
+        "validate reads a CSV written by this tool and reports every pair of vertically\n"
+        "adjacent equal numbers by stage, map, row and column. --max-report caps the\n"
+        "lines printed per kind of problem (default 100). Exits with 1 if any is found.\n"
+        "--metrics writes PATH.metrics.json.\n"
+        "\n"
+        "merge joins the shard packs of one batch, in any order, into the file a single\n"
+        "process would write. Duplicates are rejected at this step, so pass the shuffle\n"
+        "options the shards were generated with. Exits with 1 if --verify finds a\n"
+        "difference.\n"
+        "\n"
+        "sweep samples stages 1..N (default 1000) of every width, height and mode in the\n"
+        "given ranges (default 2-8, 2-8, both) and prints, per mode, the share accepted\n"
+        "by the arranger as shuffled and the time per stage. The full table is written\n"
+        "to --output (default parameter_sweep.csv).\n"
+    );
+}
+
+template <typename T>
+bool parseNumber(const char* text, T& value) {
+    const char* end = text + std::strlen(text);
+    const auto [parsedEnd, error] = std::from_chars(text, end, value);
+    return error == std::errc() && parsedEnd == end;
+}
+
+// Options that decide how stages are shuffled, shared by generation and
+// merge. Returns false if name is not one of them.
+bool parseShuffleOption(const std::string& name, const char* value, ShuffleSettings& settings, bool& parsed) {
+    if (name == "--shuffle-count") {
+        parsed = parseNumber(value, settings.shuffleCount) && settings.shuffleCount >= 1;
+    } else if (name == "--kernel") {
+        const std::string kernel = value;
+        parsed = kernel == "fast" || kernel == "legacy";
+        settings.kernel = kernel == "legacy" ? ShuffleKernel::LegacyExact : ShuffleKernel::Fast;
+    } else if (name == "--rng") {
+        const std::string rng = value;
+        parsed = rng == "mt19937" || rng == "xoshiro";
+        settings.rngBackend = rng == "xoshiro" ? RngBackend::Xoshiro256StarStar : RngBackend::Mt19937;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// "I/N" with 0 <= I < N.
+bool parseShard(const char* text, int& shardIndex, int& shardCount) {
+    const char* slash = std::strchr(text, '/');
+    if (slash == nullptr) {
+        return false;
+    }
+    const std::string index(text, slash);
+    return parseNumber(index.c_str(), shardIndex) && parseNumber(slash + 1, shardCount) &&
+        shardCount >= 1 && shardIndex >= 0 && shardIndex < shardCount;
+}
+
+bool parseArguments(int argc, char** argv, CliOptions& options) {
+    for (int argIndex = 1; argIndex < argc; ++argIndex) {
+        const std::string name = argv[argIndex];
+        if (name == "--help" || name == "-h") {
+            printUsage(stdout);
+            std::exit(0);
+        }
+        if (name == "--lazy") {
+            options.lazyGeneration = true;
+            continue;
+        }
+        if (name == "--allow-duplicates") {
+            options.allowDuplicateStages = true;
+            continue;
+        }
+        if (name == "--metrics") {
+            options.writeMetrics = true;
+            continue;
+        }
+        if (name == "--verify") {
+            options.verifyMerge = true;
+            continue;
+        }
+
+        if (argIndex + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for '%s'.\n", name.c_str());
+            return false;
+        }
+        const char* value = argv[++argIndex];
+
+        bool parsed = true;
+        if (name == "--stages") {
+            parsed = parseNumber(value, options.stageCount) && options.stageCount >= 1;
+        } else if (name == "--width") {
+            parsed = parseNumber(value, options.mapWidth) && options.mapWidth >= 1 && options.mapWidth <= kMaxMapWidth;
+        } else if (name == "--height") {
+            parsed = parseNumber(value, options.mapHeight) && options.mapHeight >= 1;
+        } else if (name == "--mode") {
+            const std::string mode = value;
+            parsed = mode == "single" || mode == "multi";
+            options.isMultiplayerMode = mode == "multi";
+        } else if (name == "--seed") {
+            parsed = parseNumber(value, options.masterSeed);
+            options.hasMasterSeed = true;
+        } else if (name == "--threads") {
+            parsed = parseNumber(value, options.threadCount) && options.threadCount >= 0;
+        } else if (name == "--format") {
+            const std::string format = value;
+            parsed = format == "csv" || format == "pack";
+            options.writeStagePack = format == "pack";
+        } else if (name == "--output") {
+            options.outputPath = value;
+            parsed = !options.outputPath.empty();
+        } else if (name == "--shard") {
+            parsed = parseShard(value, options.shardIndex, options.shardCount);
+        } else if (name == "--local-shards") {
+            parsed = parseNumber(value, options.localShardCount) && options.localShardCount >= 1;
+        } else if (!parseShuffleOption(name, value, options.shuffleSettings, parsed)) {
+            std::fprintf(stderr, "Unknown option '%s'.\n", name.c_str());
+            return false;
+        }
+
+        if (!parsed) {
+            std::fprintf(stderr, "Invalid value '%s' for '%s'.\n", value, name.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Width, height and mode are checked together: the tiles of one stage are
+// counted in an int.
+bool checkMapSizeArguments(const CliOptions& options) {
+    if (options.mapHeight > getMaxMapHeight(options.mapWidth, getMapCountPerStage(options.isMultiplayerMode))) {
+        std::fprintf(stderr, "A stage of this size has more than %d tiles.\n", std::numeric_limits<int>::max());
+        return false;
+    }
+    return true;
+}
+
+// Combinations parseArguments cannot reject one option at a time.
+bool checkShardArguments(const CliOptions& options) {
+    const bool sharded = options.shardIndex >= 0 || options.localShardCount > 0;
+    if (options.shardIndex >= 0 && options.localShardCount > 0) {
+        std::fprintf(stderr, "--shard and --local-shards cannot be combined.\n");
+        return false;
+    }
+    if (sharded && options.lazyGeneration) {
+        std::fprintf(stderr, "--lazy cannot be combined with sharding.\n");
+        return false;
+    }
+    if (options.shardIndex >= 0 && !options.hasMasterSeed) {
+        std::fprintf(stderr, "--shard needs --seed, so that every shard belongs to the same batch.\n");
+        return false;
+    }
+    if (std::max(options.shardCount, options.localShardCount) > options.stageCount) {
+        std::fprintf(stderr, "There are more shards than stages.\n");
+        return false;
+    }
+    if (options.verifyMerge && options.localShardCount == 0) {
+        std::fprintf(stderr, "--verify needs --local-shards.\n");
+        return false;
+    }
+    return true;
+}
+
+struct MergeOptions {
+    std::vector<std::string> shardPaths;
+    std::string outputPath;
+    bool writeStagePack = true;
+    ShuffleSettings shuffleSettings;
+    bool allowDuplicateStages = false;
+    int threadCount = 0;
+    bool verify = false;
+};
+
+bool parseMergeArguments(int argc, char** argv, MergeOptions& options) {
+    for (int argIndex = 2; argIndex < argc; ++argIndex) {
+        const std::string name = argv[argIndex];
+        if (name.rfind("--", 0) != 0) {
+            options.shardPaths.push_back(name);
+            continue;
+        }
+        if (name == "--allow-duplicates") {
+            options.allowDuplicateStages = true;
+            continue;
+        }
+        if (name == "--verify") {
+            options.verify = true;
+            continue;
+        }
+
+        if (argIndex + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for '%s'.\n", name.c_str());
+            return false;
+        }
+        const char* value = argv[++argIndex];
+
+        bool parsed = true;
+        if (name == "--output") {
+            options.outputPath = value;
+            parsed = !options.outputPath.empty();
+        } else if (name == "--format") {
+            const std::string format = value;
+            parsed = format == "csv" || format == "pack";
+            options.writeStagePack = format == "pack";
+        } else if (name == "--threads") {
+            parsed = parseNumber(value, options.threadCount) && options.threadCount >= 0;
+        } else if (!parseShuffleOption(name, value, options.shuffleSettings, parsed)) {
+            std::fprintf(stderr, "Unknown option '%s'.\n", name.c_str());
+            return false;
+        }
+
+        if (!parsed) {
+            std::fprintf(stderr, "Invalid value '%s' for '%s'.\n", value, name.c_str());
+            return false;
+        }
+    }
+
+    if (options.shardPaths.empty()) {
+        std::fprintf(stderr, "merge needs the paths of the shard packs.\n");
+        return false;
+    }
+    return true;
+}
+
+struct ValidateOptions {
+    std::string inputPath;
+    int threadCount = 0;
+    std::size_t maxReportedIssues = 100;
+    bool writeMetrics = false;
+};
+
+bool parseValidateArguments(int argc, char** argv, ValidateOptions& options) {
+    for (int argIndex = 2; argIndex < argc; ++argIndex) {
+        const std::string name = argv[argIndex];
+        if (name.rfind("--", 0) != 0) {
+            if (!options.inputPath.empty()) {
+                std::fprintf(stderr, "Unexpected argument '%s'.\n", name.c_str());
+                return false;
+            }
+            options.inputPath = name;
+            continue;
+        }
+        if (name == "--metrics") {
+            options.writeMetrics = true;
+            continue;
+        }
+
+        if (argIndex + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for '%s'.\n", name.c_str());
+            return false;
+        }
+        const char* value = argv[++argIndex];
+
+        bool parsed = true;
+        if (name == "--threads") {
+            parsed = parseNumber(value, options.threadCount) && options.threadCount >= 0;
+        } else if (name == "--max-report") {
+            parsed = parseNumber(value, options.maxReportedIssues);
+        } else {
+            std::fprintf(stderr, "Unknown option '%s'.\n", name.c_str());
+            return false;
+        }
+
+        if (!parsed) {
+            std::fprintf(stderr, "Invalid value '%s' for '%s'.\n", value, name.c_str());
+            return false;
+        }
+    }
+
+    if (options.inputPath.empty()) {
+        std::fprintf(stderr, "validate needs the path of a CSV file.\n");
+        return false;
+    }
+    return true;
+}
+
+struct SweepOptions {
+    ParameterSweepSettings settings;
+    bool hasMasterSeed = false;
+    int threadCount = 0;
+    std::string outputPath;
+};
+
+// "A-B" with 1 <= A <= B, or a single "A".
+bool parseRange(const char* text, int& minValue, int& maxValue) {
+    const char* dash = std::strchr(text, '-');
+    if (dash == nullptr) {
+        if (!parseNumber(text, minValue)) {
+            return false;
+        }
+        maxValue = minValue;
+    } else {
+        const std::string first(text, dash);
+        if (!parseNumber(first.c_str(), minValue) || !parseNumber(dash + 1, maxValue)) {
+            return false;
+        }
+    }
+    return minValue >= 1 && minValue <= maxValue;
+}
+
+bool parseSweepArguments(int argc, char** argv, SweepOptions& options) {
+    ParameterSweepSettings& settings = options.settings;
+    for (int argIndex = 2; argIndex < argc; ++argIndex) {
+        const std::string name = argv[argIndex];
+        if (argIndex + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for '%s'.\n", name.c_str());
+            return false;
+        }
+        const char* value = argv[++argIndex];
+
+        bool parsed = true;
+        if (name == "--widths") {
+            parsed = parseRange(value, settings.minMapWidth, settings.maxMapWidth) && settings.maxMapWidth <= kMaxMapWidth;
+        } else if (name == "--heights") {
+            parsed = parseRange(value, settings.minMapHeight, settings.maxMapHeight);
+        } else if (name == "--modes") {
+            const std::string modes = value;
+            parsed = modes == "single" || modes == "multi" || modes == "both";
+            settings.includeSingleMode = modes != "multi";
+            settings.includeMultiMode = modes != "single";
+        } else if (name == "--samples") {
+            parsed = parseNumber(value, settings.samplesPerCell) && settings.samplesPerCell >= 1;
+        } else if (name == "--seed") {
+            parsed = parseNumber(value, settings.masterSeed);
+            options.hasMasterSeed = true;
+        } else if (name == "--threads") {
+            parsed = parseNumber(value, options.threadCount) && options.threadCount >= 0;
+        } else if (name == "--output") {
+            options.outputPath = value;
+            parsed = !options.outputPath.empty();
+        } else if (!parseShuffleOption(name, value, settings.shuffleSettings, parsed)) {
+            std::fprintf(stderr, "Unknown option '%s'.\n", name.c_str());
+            return false;
+        }
+
+        if (!parsed) {
+            std::fprintf(stderr, "Invalid value '%s' for '%s'.\n", value, name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printInvalidMapWarning(int invalidMapCount) {
+    if (invalidMapCount > 0) {
+        std::fprintf(
+            stderr,
+            "[WARN] %d map(s) could not avoid vertically adjacent equal numbers.\n",
+            invalidMapCount
+        );
+    }
+}
+
+// Prints the metrics gathered since main reset them and writes them next to
+// the file the run produced or read.
+void reportMetrics(const GenerationRunInfo& run, const std::string& dataPath) {
+    const GenerationMetricsSnapshot metrics = snapshotGenerationMetrics();
+    for (const std::string& line : formatGenerationMetrics(metrics, run)) {
+        std::printf("%s\n", line.c_str());
+    }
+
+    const std::string metricsPath = getMetricsFileName(dataPath);
+    if (!writeGenerationMetricsJson(metrics, run, metricsPath)) {
+        std::fprintf(stderr, "[WARN] Failed to write '%s'.\n", metricsPath.c_str());
+        return;
+    }
+    std::printf("[INFO] Metrics written to '%s'.\n", metricsPath.c_str());
+}
+
+void reportGenerationMetrics(const CliOptions& options, const char* label, int workerThreadCount, double wallSeconds) {
+    if (!options.writeMetrics) {
+        return;
+    }
+
+    GenerationRunInfo run;
+    run.label = label;
+    run.stageCount = options.stageCount;
+    run.mapWidth = options.mapWidth;
+    run.mapHeight = options.mapHeight;
+    run.isMultiplayerMode = options.isMultiplayerMode;
+    run.masterSeed = options.masterSeed;
+    run.workerThreadCount = workerThreadCount;
+    run.wallSeconds = wallSeconds;
+    reportMetrics(run, options.outputPath);
+}
+
+void printDuplicateStageReport(const DuplicateStageFilter* duplicateFilter, int stageCount) {
+    if (duplicateFilter == nullptr) {
+        return;
+    }
+    std::fprintf(
+        duplicateFilter->unresolvedDuplicateCount > 0 ? stderr : stdout,
+        "%s %s\n",
+        duplicateFilter->unresolvedDuplicateCount > 0 ? "[WARN]" : "[INFO]",
+        describeDuplicateStages(*duplicateFilter, stageCount).c_str()
+    );
+}
+
+// Same CSV as the default path, without the whole batch in memory. Generation
+// and writing alternate per window, so only the combined time is reported.
+int runLazyGeneration(const CliOptions& options, WorkStealingPool& pool) {
+    StageSourceSettings settings;
+    settings.stageCount = options.stageCount;
+    settings.mapWidth = options.mapWidth;
+    settings.mapHeight = options.mapHeight;
+    settings.isMultiplayerMode = options.isMultiplayerMode;
+    settings.shuffleSettings = options.shuffleSettings;
+    settings.masterSeed = options.masterSeed;
+
+    const auto start = std::chrono::steady_clock::now();
+    int invalidMapCount = 0;
+    const bool written = options.writeStagePack
+        ? writeLazyStagesPack(settings, options.outputPath, pool, GenerationControl{}, invalidMapCount)
+        : writeLazyStagesCsv(settings, options.outputPath, pool, GenerationControl{}, invalidMapCount);
+    if (!written) {
+        std::fprintf(stderr, "[ERROR] Failed to write '%s'.\n", options.outputPath.c_str());
+        return 1;
+    }
+    const double totalSeconds = secondsSince(start);
+
+    std::error_code sizeError;
+    const std::uintmax_t outputBytes = std::filesystem::file_size(options.outputPath, sizeError);
+
+    printInvalidMapWarning(invalidMapCount);
+    std::printf(
+        "[INFO] Generated and wrote %llu bytes to '%s' in %.3f s: %.0f stages/s, %.1f MB/s.\n",
+        static_cast<unsigned long long>(sizeError ? 0 : outputBytes),
+        options.outputPath.c_str(),
+        totalSeconds,
+        options.stageCount / totalSeconds,
+        static_cast<double>(sizeError ? 0 : outputBytes) / (1024.0 * 1024.0) / totalSeconds
+    );
+    reportGenerationMetrics(options, "lazy", pool.threadCount(), totalSeconds);
+    return 0;
+}
+
+// The pack is written after generation: its stage table needs every stage's
+// checksum, and packing is a fraction of the CSV formatting cost anyway.
+int runPackGeneration(const CliOptions& options, WorkStealingPool& pool, DuplicateStageFilter* duplicateFilter) {
+    const auto generationStart = std::chrono::steady_clock::now();
+    StageStore stages = createStages(
+        options.stageCount,
+        options.mapWidth,
+        options.mapHeight,
+        options.isMultiplayerMode
+    );
+    const int invalidMapCount = shuffleStageMaps(
+        stages,
+        options.shuffleSettings,
+        options.isMultiplayerMode,
+        options.masterSeed,
+        pool,
+        GenerationControl{},
+        0,
+        duplicateFilter
+    );
+    const double generationSeconds = secondsSince(generationStart);
+
+    const auto writeStart = std::chrono::steady_clock::now();
+    if (!writeStagePack(stages, options.isMultiplayerMode, options.masterSeed, options.outputPath)) {
+        std::fprintf(stderr, "[ERROR] Failed to write '%s'.\n", options.outputPath.c_str());
+        return 1;
+    }
+    const double writeSeconds = secondsSince(writeStart);
+
+    std::error_code sizeError;
+    const std::uintmax_t outputBytes = std::filesystem::file_size(options.outputPath, sizeError);
+
+    printInvalidMapWarning(invalidMapCount);
+    printDuplicateStageReport(duplicateFilter, options.stageCount);
+    std::printf(
+        "[INFO] Generated in %.3f s: %.0f stages/s.\n",
+        generationSeconds,
+        options.stageCount / generationSeconds
+    );
+    std::printf(
+        "[INFO] Wrote %llu bytes to '%s' in %.3f s (%.1f MB/s).\n",
+        static_cast<unsigned long long>(sizeError ? 0 : outputBytes),
+        options.outputPath.c_str(),
+        writeSeconds,
+        static_cast<double>(sizeError ? 0 : outputBytes) / (1024.0 * 1024.0) / writeSeconds
+    );
+    reportGenerationMetrics(options, "pack", pool.threadCount(), secondsSince(generationStart));
+    return 0;
+}
+// One shard of a batch: the stages of its range, generated from their batch
+// indices and written to a pack that records where the range starts.
+// Duplicates are left to the merge, which sees the whole batch.
+int runShardGeneration(const CliOptions& options, WorkStealingPool& pool) {
+    const StageShardRange range = getStageShardRange(options.stageCount, options.shardIndex, options.shardCount);
+
+    const auto generationStart = std::chrono::steady_clock::now();
+    StageStore stages = createStages(
+        range.stageCount,
+        options.mapWidth,
+        options.mapHeight,
+        options.isMultiplayerMode
+    );
+    const int invalidMapCount = shuffleStageMaps(
+        stages,
+        options.shuffleSettings,
+        options.isMultiplayerMode,
+        options.masterSeed,
+        pool,
+        GenerationControl{},
+        range.firstStageIndex
+    );
+    const double generationSeconds = secondsSince(generationStart);
+
+    if (!writeStagePack(stages, options.isMultiplayerMode, options.masterSeed, options.outputPath, range.firstStageIndex)) {
+        std::fprintf(stderr, "[ERROR] Failed to write '%s'.\n", options.outputPath.c_str());
+        return 1;
+    }
+
+    printInvalidMapWarning(invalidMapCount);
+    std::printf(
+        "[INFO] Shard %d of %d: stages %d to %d generated in %.3f s and written to '%s'.\n",
+        options.shardIndex,
+        options.shardCount,
+        range.firstStageIndex + 1,
+        range.firstStageIndex + range.stageCount,
+        generationSeconds,
+        options.outputPath.c_str()
+    );
+    reportGenerationMetrics(options, "shard", pool.threadCount(), secondsSince(generationStart));
+    return 0;
+}
+
+// Merges shards into outputPath and, with verify, compares every merged
+// stage with the batch generated here in one piece.
+int mergeShardsAndReport(
+    const StageShardSet& shards,
+    const std::string& outputPath,
+    bool writeStagePack,
+    const ShuffleSettings& shuffleSettings,
+    bool allowDuplicateStages,
+    bool verify,
+    WorkStealingPool& pool
+) {
+    StageStore reference;
+    if (verify) {
+        reference = createStages(shards.stageCount(), shards.mapWidth(), shards.mapHeight(), shards.isMultiplayerMode());
+        DuplicateStageFilter referenceFilter(shards.stageCount());
+        referenceFilter.distinctStages = countDistinctStageArrangements(
+            shards.mapWidth(),
+            shards.mapHeight(),
+            shards.isMultiplayerMode(),
+            static_cast<std::uint64_t>(shards.stageCount())
+        );
+        shuffleStageMaps(
+            reference,
+            shuffleSettings,
+            shards.isMultiplayerMode(),
+            shards.masterSeed(),
+            pool,
+            GenerationControl{},
+            0,
+            allowDuplicateStages ? nullptr : &referenceFilter
+        );
+    }
+
+    StageShardMergeOptions mergeOptions;
+    mergeOptions.shuffleSettings = shuffleSettings;
+    mergeOptions.rejectDuplicates = !allowDuplicateStages;
+    mergeOptions.writeCsv = !writeStagePack;
+    int mismatchedStageCount = 0;
+    int firstMismatchedStageIndex = -1;
+    if (verify) {
+        mergeOptions.onStageMerged = [&](int stageIndex, const Tile* tiles, std::size_t tileCount) {
+            const bool matches = reference.visitStageTiles(stageIndex, [&](const auto* referenceTiles) {
+                return std::equal(tiles, tiles + tileCount, referenceTiles);
+            });
+            if (!matches) {
+                if (mismatchedStageCount++ == 0) {
+                    firstMismatchedStageIndex = stageIndex;
+                }
+            }
+        };
+    }
+
+    const auto mergeStart = std::chrono::steady_clock::now();
+    const StageShardMergeResult merged = mergeStageShards(shards, outputPath, mergeOptions);
+    if (!merged.succeeded) {
+        std::fprintf(stderr, "[ERROR] Merge failed: %s.\n", merged.error.c_str());
+        return 1;
+    }
+    const double mergeSeconds = secondsSince(mergeStart);
+
+    printInvalidMapWarning(merged.invalidStageCount);
+    printDuplicateStageReport(merged.duplicateFilter.get(), shards.stageCount());
+    std::printf(
+        "[INFO] Merged %d stage(s) from %d shard(s) into '%s' in %.3f s.\n",
+        shards.stageCount(),
+        shards.shardCount(),
+        outputPath.c_str(),
+        mergeSeconds
+    );
+
+    if (verify) {
+        if (mismatchedStageCount > 0) {
+            std::fprintf(
+                stderr,
+                "[ERROR] %d merged stage(s) differ from a single-process run, the first is stage %d.\n",
+                mismatchedStageCount,
+                firstMismatchedStageIndex + 1
+            );
+            return 1;
+        }
+        std::printf("[INFO] Every merged stage matches a single-process run.\n");
+    }
+    return 0;
+}
+
+int runMerge(MergeOptions& options) {
+    StageShardSet shards;
+    std::string error;
+    if (!shards.open(options.shardPaths, error)) {
+        std::fprintf(stderr, "[ERROR] %s.\n", error.c_str());
+        return 1;
+    }
+    if (options.outputPath.empty()) {
+        options.outputPath = options.writeStagePack
+            ? getStagePackFileName(shards.isMultiplayerMode(), "")
+            : getStageCsvFileName(shards.isMultiplayerMode(), "");
+    }
+
+    WorkStealingPool pool(options.threadCount);
+    std::printf(
+        "[INFO] %d shard(s) of %d %s-mode stage(s) of %d x %d, master seed %llu.\n",
+        shards.shardCount(),
+        shards.stageCount(),
+        shards.isMultiplayerMode() ? "multi" : "single",
+        shards.mapWidth(),
+        shards.mapHeight(),
+        static_cast<unsigned long long>(shards.masterSeed())
+    );
+    return mergeShardsAndReport(
+        shards,
+        options.outputPath,
+        options.writeStagePack,
+        options.shuffleSettings,
+        options.allowDuplicateStages,
+        options.verify,
+        pool
+    );
+}
+
+// Quotes one argument for the shell std::system runs.
+std::string quoteShellArgument(const std::string& argument) {
+#if defined(_WIN32)
+    return "\"" + argument + "\"";
+#else
+    std::string quoted = "'";
+    for (const char ch : argument) {
+        quoted += ch == '\'' ? std::string("'\\''") : std::string(1, ch);
+    }
+    return quoted + "'";
+#endif
+}
+
+// Stands in for a cluster: every shard runs as a separate process of this
+// executable, exactly as on a remote node, and the parent merges their packs.
+// The hardware threads are split between the shards unless --threads is given.
+int runLocalShards(const CliOptions& options, const char* executablePath, WorkStealingPool& pool) {
+    const int shardCount = options.localShardCount;
+    const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int threadsPerShard = options.threadCount > 0 ? options.threadCount : std::max(1, hardwareThreads / shardCount);
+
+    std::vector<std::string> shardPaths;
+    std::vector<std::string> commands;
+    for (int shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+        shardPaths.push_back(getStageShardFileName(options.outputPath, shardIndex, shardCount));
+        const std::vector<std::string> arguments = {
+            executablePath,
+            "--stages", std::to_string(options.stageCount),
+            "--width", std::to_string(options.mapWidth),
+            "--height", std::to_string(options.mapHeight),
+            "--mode", options.isMultiplayerMode ? "multi" : "single",
+            "--shuffle-count", std::to_string(options.shuffleSettings.shuffleCount),
+            "--kernel", options.shuffleSettings.kernel == ShuffleKernel::LegacyExact ? "legacy" : "fast",
+            "--rng", options.shuffleSettings.rngBackend == RngBackend::Xoshiro256StarStar ? "xoshiro" : "mt19937",
+            "--seed", std::to_string(options.masterSeed),
+            "--threads", std::to_string(threadsPerShard),
+            "--shard", std::to_string(shardIndex) + "/" + std::to_string(shardCount),
+            "--output", shardPaths.back(),
+        };
+
+        std::string command;
+        for (const std::string& argument : arguments) {
+            command += (command.empty() ? "" : " ") + quoteShellArgument(argument);
+        }
+#if defined(_WIN32)
+        // cmd /c drops the outermost pair of quotes.
+        command = "\"" + command + "\"";
+#endif
+        commands.push_back(std::move(command));
+    }
+
+    std::printf("[INFO] Running %d shard process(es) with %d worker thread(s) each.\n", shardCount, threadsPerShard);
+    std::fflush(stdout);
+    const auto shardStart = std::chrono::steady_clock::now();
+    std::vector<int> exitStatuses(static_cast<std::size_t>(shardCount), 0);
+    std::vector<std::thread> processes;
+    for (int shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+        processes.emplace_back([&, shardIndex] {
+            const std::size_t slot = static_cast<std::size_t>(shardIndex);
+            exitStatuses[slot] = std::system(commands[slot].c_str());
+        });
+    }
+    for (std::thread& process : processes) {
+        process.join();
+    }
+
+    bool failed = false;
+    for (int shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+        if (exitStatuses[static_cast<std::size_t>(shardIndex)] != 0) {
+            std::fprintf(
+                stderr,
+                "[ERROR] Shard %d of %d failed with status %d.\n",
+                shardIndex,
+                shardCount,
+                exitStatuses[static_cast<std::size_t>(shardIndex)]
+            );
+            failed = true;
+        }
+    }
+    if (failed) {
+        return 1;
+    }
+    std::printf("[INFO] %d shard process(es) finished in %.3f s.\n", shardCount, secondsSince(shardStart));
+
+    StageShardSet shards;
+    std::string error;
+    if (!shards.open(shardPaths, error)) {
+        std::fprintf(stderr, "[ERROR] %s.\n", error.c_str());
+        return 1;
+    }
+    const int status = mergeShardsAndReport(
+        shards,
+        options.outputPath,
+        options.writeStagePack,
+        options.shuffleSettings,
+        options.allowDuplicateStages,
+        options.verifyMerge,
+        pool
+    );
+
+    // Kept after a failure, for inspection.
+    if (status == 0) {
+        shards = StageShardSet{};
+        for (const std::string& shardPath : shardPaths) {
+            std::error_code removeError;
+            std::filesystem::remove(shardPath, removeError);
+        }
+    }
+    return status;
+}
+
+// Imports without keeping the stages: only the report is needed.
+int runValidation(const ValidateOptions& options) {
+    WorkStealingPool pool(options.threadCount);
+
+    StageCsvImportOptions importOptions;
+    importOptions.keepStages = false;
+    importOptions.maxReportedIssues = options.maxReportedIssues;
+
+    const auto start = std::chrono::steady_clock::now();
+    const StageCsvImportResult imported = importStagesCsv(options.inputPath, pool, importOptions);
+    const double seconds = secondsSince(start);
+
+    if (!imported.opened) {
+        std::fprintf(stderr, "[ERROR] Cannot read '%s': %s\n", options.inputPath.c_str(), imported.error.c_str());
+        return 1;
+    }
+
+    for (const StageCsvParseError& error : imported.parseErrors) {
+        std::printf("[ERROR] line %llu: %s\n", static_cast<unsigned long long>(error.lineNumber), error.message.c_str());
+    }
+    for (const StageCellViolation& violation : imported.violations) {
+        std::printf(
+            "[VIOLATION] stage %d map %d: rows %d and %d of column %d both hold %d\n",
+            violation.stageNumber,
+            violation.mapNumber,
+            violation.row,
+            violation.row + 1,
+            violation.column,
+            violation.tile
+        );
+    }
+
+    std::printf(
+        "[INFO] %d %s-mode stage(s) of %d x %d%s in '%s'.\n",
+        imported.stageCount,
+        imported.isMultiplayerMode ? "multi" : "single",
+        imported.mapWidth,
+        imported.mapHeight,
+        imported.hasMasterSeed ? (", master seed " + std::to_string(imported.masterSeed)).c_str() : "",
+        options.inputPath.c_str()
+    );
+    std::printf(
+        "[INFO] %llu violation(s) in %llu map(s), %llu unreadable row(s).\n",
+        static_cast<unsigned long long>(imported.violationCount),
+        static_cast<unsigned long long>(imported.violatingMapCount),
+        static_cast<unsigned long long>(imported.parseErrorCount)
+    );
+    std::printf(
+        "[INFO] Read %llu bytes in %.3f s with %d worker thread(s) (%.1f MB/s).\n",
+        static_cast<unsigned long long>(imported.fileBytes),
+        seconds,
+        pool.threadCount(),
+        static_cast<double>(imported.fileBytes) / (1024.0 * 1024.0) / seconds
+    );
+    if (options.writeMetrics) {
+        GenerationRunInfo run;
+        run.label = "validate";
+        run.stageCount = imported.stageCount;
+        run.mapWidth = imported.mapWidth;
+        run.mapHeight = imported.mapHeight;
+        run.isMultiplayerMode = imported.isMultiplayerMode;
+        run.masterSeed = imported.masterSeed;
+        run.workerThreadCount = pool.threadCount();
+        run.wallSeconds = seconds;
+        reportMetrics(run, options.inputPath);
+    }
+
+    return imported.violationCount == 0 && imported.parseErrorCount == 0 ? 0 : 1;
+}
+
+// One grid per mode: acceptance in percent, then microseconds per stage.
+// Impossible layouts are marked with '*'.
+void printSweepHeatmaps(const ParameterSweepResult& result) {
+    const ParameterSweepSettings& settings = result.settings;
+    for (const bool isMultiplayerMode : {false, true}) {
+        if (!(isMultiplayerMode ? settings.includeMultiMode : settings.includeSingleMode)) {
+            continue;
+        }
+
+        for (const bool showTime : {false, true}) {
+            std::printf(
+                "\n%s mode, %s (rows: height, columns: width)\n     ",
+                isMultiplayerMode ? "Multi" : "Single",
+                showTime ? "us per stage" : "accepted as shuffled (%)"
+            );
+            for (int mapWidth = settings.minMapWidth; mapWidth <= settings.maxMapWidth; ++mapWidth) {
+                std::printf("%8d", mapWidth);
+            }
+            std::printf("\n");
+
+            for (int mapHeight = settings.minMapHeight; mapHeight <= settings.maxMapHeight; ++mapHeight) {
+                std::printf("%5d", mapHeight);
+                for (int mapWidth = settings.minMapWidth; mapWidth <= settings.maxMapWidth; ++mapWidth) {
+                    const ParameterSweepCell* cell = result.findCell(mapWidth, mapHeight, isMultiplayerMode);
+                    if (cell == nullptr || cell->sampledStageCount == 0) {
+                        std::printf("%8s", "-");
+                        continue;
+                    }
+                    std::printf(
+                        "%7.*f%c",
+                        showTime ? 2 : 1,
+                        showTime ? cell->secondsPerStage * 1'000'000.0 : cell->acceptanceRate() * 100.0,
+                        cell->arrangementPossible ? ' ' : '*'
+                    );
+                }
+                std::printf("\n");
+            }
+        }
+    }
+}
+
+int runSweep(SweepOptions& options) {
+    if (!options.hasMasterSeed) {
+        options.settings.masterSeed = generateMasterSeed();
+    }
+    if (options.outputPath.empty()) {
+        options.outputPath = getParameterSweepFileName("");
+    }
+
+    WorkStealingPool pool(options.threadCount);
+    const ParameterSweepSettings& settings = options.settings;
+    std::printf(
+        "[INFO] Sweeping widths %d-%d, heights %d-%d, %d stage(s) per cell, master seed %llu, %d worker thread(s).\n",
+        settings.minMapWidth,
+        settings.maxMapWidth,
+        settings.minMapHeight,
+        settings.maxMapHeight,
+        settings.samplesPerCell,
+        static_cast<unsigned long long>(settings.masterSeed),
+        pool.threadCount()
+    );
+
+    const ParameterSweepResult result = runParameterSweep(settings, pool, GenerationControl{});
+    printSweepHeatmaps(result);
+    std::printf("\n[INFO] Sampled %zu cell(s) in %.3f s.\n", result.cells.size(), result.wallSeconds);
+
+    if (!writeParameterSweepCsv(result, options.outputPath)) {
+        std::fprintf(stderr, "[ERROR] Failed to write '%s'.\n", options.outputPath.c_str());
+        return 1;
+    }
+    std::printf("[INFO] Wrote the sweep to '%s'.\n", options.outputPath.c_str());
+    return 0;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::strcmp(argv[1], "validate") == 0) {
+        ValidateOptions validateOptions;
+        if (!parseValidateArguments(argc, argv, validateOptions)) {
+            printUsage(stderr);
+            return 2;
+        }
+        return runValidation(validateOptions);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "merge") == 0) {
+        MergeOptions mergeOptions;
+        if (!parseMergeArguments(argc, argv, mergeOptions)) {
+            printUsage(stderr);
+            return 2;
+        }
+        return runMerge(mergeOptions);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "sweep") == 0) {
+        SweepOptions sweepOptions;
+        if (!parseSweepArguments(argc, argv, sweepOptions)) {
+            printUsage(stderr);
+            return 2;
+        }
+        return runSweep(sweepOptions);
+    }
+
+    CliOptions options;
+    if (!parseArguments(argc, argv, options) || !checkMapSizeArguments(options) || !checkShardArguments(options)) {
+        printUsage(stderr);
+        return 2;
+    }
+
+    if (!options.hasMasterSeed) {
+        options.masterSeed = generateMasterSeed();
+    }
+    if (options.shardIndex >= 0) {
+        options.writeStagePack = true;
+        if (options.outputPath.empty()) {
+            options.outputPath = getStageShardFileName(
+                getStagePackFileName(options.isMultiplayerMode, ""),
+                options.shardIndex,
+                options.shardCount
+            );
+        }
+    }
+    if (options.outputPath.empty()) {
+        options.outputPath = options.writeStagePack
+            ? getStagePackFileName(options.isMultiplayerMode, "")
+            : getStageCsvFileName(options.isMultiplayerMode, "");
+    }
+
+    const ArrangementFeasibility feasibility = checkStageConfigurationFeasibility(
+        options.mapWidth,
+        options.mapHeight,
+        options.isMultiplayerMode
+    );
+    if (!feasibility.isPossible) {
+        std::fprintf(
+            stderr,
+            "[WARN] %s Maps are shuffled without avoiding vertical matches.\n",
+            describeImpossibleArrangement(feasibility).c_str()
+        );
+    }
+
+    WorkStealingPool pool(options.threadCount);
+    std::printf(
+        "[INFO] %d %s-mode stage(s) of %d x %d, master seed %llu, %d worker thread(s).\n",
+        options.stageCount,
+        options.isMultiplayerMode ? "multi" : "single",
+        options.mapWidth,
+        options.mapHeight,
+        static_cast<unsigned long long>(options.masterSeed),
+        pool.threadCount()
+    );
+    if (options.shardIndex >= 0) {
+        return runShardGeneration(options, pool);
+    }
+
+    // On-demand stages depend on their index alone, so they cannot be
+    // checked against the rest of the batch.
+    const bool rejectDuplicateStages = !options.allowDuplicateStages && !options.lazyGeneration;
+    const DistinctArrangementCount distinctStages = countDistinctStageArrangements(
+        options.mapWidth,
+        options.mapHeight,
+        options.isMultiplayerMode,
+        static_cast<std::uint64_t>(options.stageCount)
+    );
+    if (distinctStages.isExact) {
+        std::fprintf(stderr, "[WARN] %s\n", describeStageShortage(distinctStages, options.stageCount).c_str());
+    }
+    std::unique_ptr<DuplicateStageFilter> duplicateFilter;
+    if (rejectDuplicateStages) {
+        duplicateFilter = std::make_unique<DuplicateStageFilter>(options.stageCount);
+        duplicateFilter->distinctStages = distinctStages;
+    }
+
+    if (options.localShardCount > 0) {
+        return runLocalShards(options, argv[0], pool);
+    }
+    if (options.lazyGeneration) {
+        return runLazyGeneration(options, pool);
+    }
+    if (options.writeStagePack) {
+        return runPackGeneration(options, pool, duplicateFilter.get());
+    }
+
+    const auto generationStart = std::chrono::steady_clock::now();
+    StageStore stages = createStages(
+        options.stageCount,
+        options.mapWidth,
+        options.mapHeight,
+        options.isMultiplayerMode
+    );
+
+    StreamingCsvExporter csvExporter;
+    if (!csvExporter.start(stages, options.isMultiplayerMode, options.masterSeed, options.outputPath)) {
+        std::fprintf(stderr, "[ERROR] Failed to open '%s'.\n", options.outputPath.c_str());
+        return 1;
+    }
+
+    GenerationControl control;
+    control.onStageGenerated = [&csvExporter](int stageIndex) {
+        csvExporter.markStageReady(stageIndex);
+    };
+    const int invalidMapCount = shuffleStageMaps(
+        stages,
+        options.shuffleSettings,
+        options.isMultiplayerMode,
+        options.masterSeed,
+        pool,
+        control,
+        0,
+        duplicateFilter.get()
+    );
+    const double generationSeconds = secondsSince(generationStart);
+
+    // Rows have been written while the pool was generating; only the tail is left.
+    const auto drainStart = std::chrono::steady_clock::now();
+    if (!csvExporter.finish()) {
+        std::fprintf(stderr, "[ERROR] Failed to write '%s'.\n", options.outputPath.c_str());
+        return 1;
+    }
+    const double drainSeconds = secondsSince(drainStart);
+    const double totalSeconds = secondsSince(generationStart);
+
+    const std::uint64_t outputBytes = csvExporter.bytesWritten();
+    const double tileCount = static_cast<double>(options.stageCount) *
+        getMapCountPerStage(options.isMultiplayerMode) * options.mapWidth * options.mapHeight;
+
+    printInvalidMapWarning(invalidMapCount);
+    printDuplicateStageReport(duplicateFilter.get(), options.stageCount);
+    std::printf(
+        "[INFO] Generated in %.3f s: %.0f stages/s, %.0f tiles/s.\n",
+        generationSeconds,
+        options.stageCount / generationSeconds,
+        tileCount / generationSeconds
+    );
+    std::printf(
+        "[INFO] Wrote %llu bytes to '%s', %.3f s after generation finished (%.3f s total, %.1f MB/s).\n",
+        static_cast<unsigned long long>(outputBytes),
+        options.outputPath.c_str(),
+        drainSeconds,
+        totalSeconds,
+        static_cast<double>(outputBytes) / (1024.0 * 1024.0) / totalSeconds
+    );
+    reportGenerationMetrics(options, "generate", pool.threadCount(), totalSeconds);
+
+    return 0;
+}
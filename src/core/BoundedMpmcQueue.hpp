@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free queue (Vyukov). Any thread may push or pop; the generation
+// worker pushes events and the render thread drains them once per frame.
+template <typename T, std::size_t Capacity>
+class BoundedMpmcQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    BoundedMpmcQueue()
+        : cells_(std::make_unique<Cell[]>(Capacity)) {
+        for (std::size_t index = 0; index < Capacity; ++index) {
+            cells_[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(T value) {
+        Cell* cell = nullptr;
+        std::size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[position & kIndexMask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        Cell* cell = nullptr;
+        std::size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[position & kIndexMask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+            if (difference == 0) {
+                if (dequeuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->value);
+        cell->sequence.store(position + Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr std::size_t kIndexMask = Capacity - 1;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> enqueuePosition_{0};
+    alignas(64) std::atomic<std::size_t> dequeuePosition_{0};
+};
@@ -0,0 +1,429 @@
+#include "core/GenerationMetrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+#if TILE_MATCHING_METRICS && !defined(_WIN32)
+#include <ctime>
+#elif TILE_MATCHING_METRICS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+double toSeconds(std::uint64_t nanos) {
+    return static_cast<double>(nanos) * 1e-9;
+}
+
+std::uint64_t getStageAttemptBucketMin(int bucket) {
+    return bucket == 0 ? 1 : (std::uint64_t{1} << (bucket - 1)) + 1;
+}
+
+std::string formatStageAttemptBucket(int bucket) {
+    const std::uint64_t minAttempts = getStageAttemptBucketMin(bucket);
+    if (bucket + 1 == kStageAttemptBucketCount) {
+        return std::to_string(minAttempts) + "+";
+    }
+    const std::uint64_t maxAttempts = getStageAttemptBucketMin(bucket + 1) - 1;
+    if (minAttempts == maxAttempts) {
+        return std::to_string(minAttempts);
+    }
+    return std::to_string(minAttempts) + "-" + std::to_string(maxAttempts);
+}
+
+double percentOf(std::uint64_t part, std::uint64_t whole) {
+    return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+}
+
+double countGeneratedTiles(std::uint64_t generatedStages, const GenerationRunInfo& run) {
+    return static_cast<double>(generatedStages) * (run.isMultiplayerMode ? 2 : 1) * run.mapWidth * run.mapHeight;
+}
+
+#if TILE_MATCHING_METRICS
+using metrics_detail::ThreadMetrics;
+
+// Blocks outlive their threads so a run's totals survive its workers; a
+// finished thread's block goes back to a free list for the next thread.
+struct MetricsRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+    std::vector<ThreadMetrics*> freeBlocks;
+};
+
+MetricsRegistry& getMetricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+class ThreadMetricsLease {
+public:
+    ThreadMetricsLease() {
+        MetricsRegistry& registry = getMetricsRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (!registry.freeBlocks.empty()) {
+            block_ = registry.freeBlocks.back();
+            registry.freeBlocks.pop_back();
+        } else {
+            registry.blocks.push_back(std::make_unique<ThreadMetrics>());
+            block_ = registry.blocks.back().get();
+        }
+    }
+
+    ThreadMetricsLease(const ThreadMetricsLease&) = delete;
+    ThreadMetricsLease& operator=(const ThreadMetricsLease&) = delete;
+
+    ~ThreadMetricsLease() {
+        metrics_detail::threadMetrics = nullptr;
+        MetricsRegistry& registry = getMetricsRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.freeBlocks.push_back(block_);
+    }
+
+    ThreadMetrics& block() {
+        return *block_;
+    }
+
+private:
+    ThreadMetrics* block_ = nullptr;
+};
+#endif
+} // namespace
+
+double MetricPhaseTotals::estimatedWallSeconds() const {
+    if (timedCalls == 0) {
+        return 0.0;
+    }
+    return toSeconds(wallNanos) * static_cast<double>(calls) / static_cast<double>(timedCalls);
+}
+
+const char* getMetricCounterName(MetricCounter metric) {
+    switch (metric) {
+    case MetricCounter::StagesGenerated:
+        return "stages_generated";
+    case MetricCounter::ArrangementsValidAfterShuffle:
+        return "arrangements_valid_after_shuffle";
+    case MetricCounter::ArrangementsRepaired:
+        return "arrangements_repaired";
+    case MetricCounter::ArrangementsPlaced:
+        return "arrangements_placed";
+    case MetricCounter::ArrangementsFailed:
+        return "arrangements_failed";
+    case MetricCounter::ArrangementsSkipped:
+        return "arrangements_skipped";
+    case MetricCounter::RepairSwaps:
+        return "repair_swaps";
+    case MetricCounter::DuplicateCandidatesRejected:
+        return "duplicate_candidates_rejected";
+    case MetricCounter::BytesWritten:
+        return "bytes_written";
+    case MetricCounter::BytesRead:
+        return "bytes_read";
+    case MetricCounter::Count:
+        break;
+    }
+    return "unknown";
+}
+
+const char* getMetricPhaseName(MetricPhase metric) {
+    switch (metric) {
+    case MetricPhase::Generate:
+        return "generate";
+    case MetricPhase::Shuffle:
+        return "shuffle";
+    case MetricPhase::Arrange:
+        return "arrange";
+    case MetricPhase::Fingerprint:
+        return "fingerprint";
+    case MetricPhase::Export:
+        return "export";
+    case MetricPhase::Import:
+        return "import";
+    case MetricPhase::Count:
+        break;
+    }
+    return "unknown";
+}
+
+void resetGenerationMetrics() {
+#if TILE_MATCHING_METRICS
+    MetricsRegistry& registry = getMetricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const std::unique_ptr<ThreadMetrics>& block : registry.blocks) {
+        for (std::atomic<std::uint64_t>& counter : block->counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        for (ThreadMetrics::Phase& phase : block->phases) {
+            phase.calls.store(0, std::memory_order_relaxed);
+            phase.timedCalls.store(0, std::memory_order_relaxed);
+            phase.wallNanos.store(0, std::memory_order_relaxed);
+            phase.cpuNanos.store(0, std::memory_order_relaxed);
+        }
+        for (std::atomic<std::uint64_t>& bucket : block->stageAttempts) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+#endif
+}
+
+GenerationMetricsSnapshot snapshotGenerationMetrics() {
+    GenerationMetricsSnapshot snapshot;
+#if TILE_MATCHING_METRICS
+    MetricsRegistry& registry = getMetricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const std::unique_ptr<ThreadMetrics>& block : registry.blocks) {
+        bool recorded = false;
+        for (int index = 0; index < kMetricCounterCount; ++index) {
+            const std::uint64_t value = block->counters[static_cast<std::size_t>(index)].load(std::memory_order_relaxed);
+            snapshot.counters[static_cast<std::size_t>(index)] += value;
+            recorded = recorded || value != 0;
+        }
+        for (int index = 0; index < kMetricPhaseCount; ++index) {
+            const ThreadMetrics::Phase& phase = block->phases[static_cast<std::size_t>(index)];
+            MetricPhaseTotals& totals = snapshot.phases[static_cast<std::size_t>(index)];
+            const std::uint64_t calls = phase.calls.load(std::memory_order_relaxed);
+            totals.calls += calls;
+            totals.timedCalls += phase.timedCalls.load(std::memory_order_relaxed);
+            totals.wallNanos += phase.wallNanos.load(std::memory_order_relaxed);
+            totals.cpuNanos += phase.cpuNanos.load(std::memory_order_relaxed);
+            recorded = recorded || calls != 0;
+        }
+        for (int index = 0; index < kStageAttemptBucketCount; ++index) {
+            snapshot.stageAttempts[static_cast<std::size_t>(index)] +=
+                block->stageAttempts[static_cast<std::size_t>(index)].load(std::memory_order_relaxed);
+        }
+        if (recorded) {
+            ++snapshot.threadCount;
+        }
+    }
+#endif
+    return snapshot;
+}
+
+std::vector<std::string> formatGenerationMetrics(const GenerationMetricsSnapshot& metrics, const GenerationRunInfo& run) {
+    std::vector<std::string> lines;
+    if (!isGenerationMetricsEnabled()) {
+        lines.push_back("[INFO] Metrics were disabled at build time (TILE_MATCHING_METRICS=0).");
+        return lines;
+    }
+
+    char line[256];
+    const double wallSeconds = std::max(run.wallSeconds, 1e-9);
+    const std::uint64_t generatedStages = metrics.counter(MetricCounter::StagesGenerated);
+    if (generatedStages > 0) {
+        const double tileCount = countGeneratedTiles(generatedStages, run);
+        std::snprintf(
+            line,
+            sizeof(line),
+            "[INFO] Metrics (%s): %llu stage(s) generated in %.3f s wall, %.0f stages/s, %.0f tiles/s, %d thread(s) recorded.",
+            run.label.c_str(),
+            static_cast<unsigned long long>(generatedStages),
+            run.wallSeconds,
+            static_cast<double>(generatedStages) / wallSeconds,
+            tileCount / wallSeconds,
+            metrics.threadCount
+        );
+        lines.emplace_back(line);
+
+        const std::uint64_t arrangements = metrics.counter(MetricCounter::ArrangementsValidAfterShuffle) +
+            metrics.counter(MetricCounter::ArrangementsRepaired) + metrics.counter(MetricCounter::ArrangementsPlaced) +
+            metrics.counter(MetricCounter::ArrangementsFailed) + metrics.counter(MetricCounter::ArrangementsSkipped);
+        std::snprintf(
+            line,
+            sizeof(line),
+            "[INFO] Arrangements: %.1f%% valid after shuffle, %.1f%% repaired (%llu swap(s)), "
+            "%.1f%% placed, %llu failed, %llu skipped.",
+            percentOf(metrics.counter(MetricCounter::ArrangementsValidAfterShuffle), arrangements),
+            percentOf(metrics.counter(MetricCounter::ArrangementsRepaired), arrangements),
+            static_cast<unsigned long long>(metrics.counter(MetricCounter::RepairSwaps)),
+            percentOf(metrics.counter(MetricCounter::ArrangementsPlaced), arrangements),
+            static_cast<unsigned long long>(metrics.counter(MetricCounter::ArrangementsFailed)),
+            static_cast<unsigned long long>(metrics.counter(MetricCounter::ArrangementsSkipped))
+        );
+        lines.emplace_back(line);
+
+        std::string histogram = "[INFO] Attempts per stage:";
+        for (int bucket = 0; bucket < kStageAttemptBucketCount; ++bucket) {
+            const std::uint64_t count = metrics.stageAttempts[static_cast<std::size_t>(bucket)];
+            if (count > 0) {
+                histogram += " " + formatStageAttemptBucket(bucket) + ": " + std::to_string(count) + ",";
+            }
+        }
+        histogram.back() = '.';
+        lines.push_back(std::move(histogram));
+    }
+
+    for (int index = 0; index < kMetricPhaseCount; ++index) {
+        const MetricPhase metric = static_cast<MetricPhase>(index);
+        const MetricPhaseTotals& phase = metrics.phase(metric);
+        if (phase.calls == 0) {
+            continue;
+        }
+
+        if (phase.timedCalls == phase.calls) {
+            std::snprintf(
+                line,
+                sizeof(line),
+                "[INFO] Phase %s: %.3f s wall, %.3f s CPU over %llu call(s).",
+                getMetricPhaseName(metric),
+                toSeconds(phase.wallNanos),
+                toSeconds(phase.cpuNanos),
+                static_cast<unsigned long long>(phase.calls)
+            );
+        } else {
+            std::snprintf(
+                line,
+                sizeof(line),
+                "[INFO] Phase %s: about %.3f s wall, sampled on %llu of %llu call(s).",
+                getMetricPhaseName(metric),
+                phase.estimatedWallSeconds(),
+                static_cast<unsigned long long>(phase.timedCalls),
+                static_cast<unsigned long long>(phase.calls)
+            );
+        }
+        lines.emplace_back(line);
+    }
+
+    const std::uint64_t bytesWritten = metrics.counter(MetricCounter::BytesWritten);
+    const std::uint64_t bytesRead = metrics.counter(MetricCounter::BytesRead);
+    if (bytesWritten > 0 || bytesRead > 0) {
+        std::snprintf(
+            line,
+            sizeof(line),
+            "[INFO] I/O: %.1f MB written, %.1f MB read, %.1f MB/s over the run.",
+            static_cast<double>(bytesWritten) / (1024.0 * 1024.0),
+            static_cast<double>(bytesRead) / (1024.0 * 1024.0),
+            static_cast<double>(bytesWritten + bytesRead) / (1024.0 * 1024.0) / wallSeconds
+        );
+        lines.emplace_back(line);
+    }
+    return lines;
+}
+
+bool writeGenerationMetricsJson(
+    const GenerationMetricsSnapshot& metrics,
+    const GenerationRunInfo& run,
+    const std::string& outputPath
+) {
+    std::FILE* file = std::fopen(outputPath.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    const double wallSeconds = std::max(run.wallSeconds, 1e-9);
+    const std::uint64_t generatedStages = metrics.counter(MetricCounter::StagesGenerated);
+    const double tileCount = countGeneratedTiles(generatedStages, run);
+
+    // The label comes from code, never from user input, so it needs no escaping.
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"label\": \"%s\",\n", run.label.c_str());
+    std::fprintf(file, "  \"metrics_enabled\": %s,\n", isGenerationMetricsEnabled() ? "true" : "false");
+    std::fprintf(file, "  \"stage_count\": %d,\n", run.stageCount);
+    std::fprintf(file, "  \"map_width\": %d,\n", run.mapWidth);
+    std::fprintf(file, "  \"map_height\": %d,\n", run.mapHeight);
+    std::fprintf(file, "  \"mode\": \"%s\",\n", run.isMultiplayerMode ? "multi" : "single");
+    std::fprintf(file, "  \"master_seed\": %llu,\n", static_cast<unsigned long long>(run.masterSeed));
+    std::fprintf(file, "  \"worker_threads\": %d,\n", run.workerThreadCount);
+    std::fprintf(file, "  \"recording_threads\": %d,\n", metrics.threadCount);
+    std::fprintf(file, "  \"wall_seconds\": %.6f,\n", run.wallSeconds);
+    std::fprintf(file, "  \"throughput\": {\n");
+    std::fprintf(file, "    \"stages_per_second\": %.1f,\n", static_cast<double>(generatedStages) / wallSeconds);
+    std::fprintf(file, "    \"tiles_per_second\": %.1f,\n", tileCount / wallSeconds);
+    const std::uint64_t ioBytes = metrics.counter(MetricCounter::BytesWritten) + metrics.counter(MetricCounter::BytesRead);
+    std::fprintf(file, "    \"io_bytes_per_second\": %.1f\n", static_cast<double>(ioBytes) / wallSeconds);
+    std::fprintf(file, "  },\n");
+
+    std::fprintf(file, "  \"counters\": {\n");
+    for (int index = 0; index < kMetricCounterCount; ++index) {
+        const MetricCounter metric = static_cast<MetricCounter>(index);
+        std::fprintf(
+            file,
+            "    \"%s\": %llu%s\n",
+            getMetricCounterName(metric),
+            static_cast<unsigned long long>(metrics.counter(metric)),
+            index + 1 < kMetricCounterCount ? "," : ""
+        );
+    }
+    std::fprintf(file, "  },\n");
+
+    std::fprintf(file, "  \"stage_attempt_histogram\": [\n");
+    for (int bucket = 0; bucket < kStageAttemptBucketCount; ++bucket) {
+        const bool last = bucket + 1 == kStageAttemptBucketCount;
+        char maxAttempts[24] = "null";
+        if (!last) {
+            std::snprintf(
+                maxAttempts,
+                sizeof(maxAttempts),
+                "%llu",
+                static_cast<unsigned long long>(getStageAttemptBucketMin(bucket + 1) - 1)
+            );
+        }
+        std::fprintf(
+            file,
+            "    {\"min_attempts\": %llu, \"max_attempts\": %s, \"stages\": %llu}%s\n",
+            static_cast<unsigned long long>(getStageAttemptBucketMin(bucket)),
+            maxAttempts,
+            static_cast<unsigned long long>(metrics.stageAttempts[static_cast<std::size_t>(bucket)]),
+            last ? "" : ","
+        );
+    }
+    std::fprintf(file, "  ],\n");
+
+    std::fprintf(file, "  \"phases\": {\n");
+    for (int index = 0; index < kMetricPhaseCount; ++index) {
+        const MetricPhase metric = static_cast<MetricPhase>(index);
+        const MetricPhaseTotals& phase = metrics.phase(metric);
+        std::fprintf(
+            file,
+            "    \"%s\": {\"calls\": %llu, \"timed_calls\": %llu, \"wall_seconds\": %.6f, "
+            "\"cpu_seconds\": %.6f, \"estimated_wall_seconds\": %.6f}%s\n",
+            getMetricPhaseName(metric),
+            static_cast<unsigned long long>(phase.calls),
+            static_cast<unsigned long long>(phase.timedCalls),
+            toSeconds(phase.wallNanos),
+            toSeconds(phase.cpuNanos),
+            phase.estimatedWallSeconds(),
+            index + 1 < kMetricPhaseCount ? "," : ""
+        );
+    }
+    std::fprintf(file, "  }\n");
+    std::fprintf(file, "}\n");
+
+    return std::fclose(file) == 0;
+}
+
+std::string getMetricsFileName(const std::string& outputPath) {
+    return outputPath + ".metrics.json";
+}
+
+#if TILE_MATCHING_METRICS
+namespace metrics_detail {
+ThreadMetrics& registerThreadMetrics() {
+    thread_local ThreadMetricsLease lease;
+    threadMetrics = &lease.block();
+    return *threadMetrics;
+}
+
+std::uint64_t threadCpuNanos() {
+#if defined(_WIN32)
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    const std::uint64_t kernel = (static_cast<std::uint64_t>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    const std::uint64_t user = (static_cast<std::uint64_t>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return (kernel + user) * 100;
+#else
+    timespec now = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1'000'000'000ull + static_cast<std::uint64_t>(now.tv_nsec);
+#endif
+}
+} // namespace metrics_detail
+#endif
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Low-overhead instrumentation of generation, import and export. Every thread
+// adds to its own block of relaxed atomics, so recording never contends; a
+// snapshot sums the blocks of every thread that ever recorded anything.
+//
+// Built with TILE_MATCHING_METRICS=0, the TILE_METRICS_* macros expand to
+// nothing and snapshots stay empty.
+#ifndef TILE_MATCHING_METRICS
+#define TILE_MATCHING_METRICS 1
+#endif
+
+enum class MetricCounter {
+    StagesGenerated,
+    // How the arranger finished each shuffled map (a stage in multi mode).
+    ArrangementsValidAfterShuffle,
+    ArrangementsRepaired,
+    ArrangementsPlaced,
+    ArrangementsFailed,
+    ArrangementsSkipped,  // impossible layouts, shuffled only
+    RepairSwaps,
+    DuplicateCandidatesRejected,
+    BytesWritten,
+    BytesRead,
+    Count,
+};
+
+// Shuffle, Arrange and Fingerprint run per stage and are timed on one stage in
+// kMetricsSampleInterval (wall time only); the others are timed on every call,
+// with the CPU time of the thread that ran the call as well. Phases can nest: Generate contains the sampled
+// ones, and Export contains the generation of windowed batches.
+enum class MetricPhase {
+    Generate,
+    Shuffle,
+    Arrange,
+    Fingerprint,
+    Export,
+    Import,
+    Count,
+};
+
+inline constexpr int kMetricCounterCount = static_cast<int>(MetricCounter::Count);
+inline constexpr int kMetricPhaseCount = static_cast<int>(MetricPhase::Count);
+inline constexpr std::uint32_t kMetricsSampleInterval = 32;
+
+// Generation attempts per stage (1 plus duplicate retries), bucketed as
+// 1, 2, 3-4, 5-8, ..., with the last bucket open-ended.
+inline constexpr int kStageAttemptBucketCount = 8;
+
+struct MetricPhaseTotals {
+    std::uint64_t calls = 0;
+    std::uint64_t timedCalls = 0;
+    std::uint64_t wallNanos = 0;  // over timedCalls only
+    std::uint64_t cpuNanos = 0;   // 0 for sampled phases
+
+    // wallNanos scaled up to every call.
+    double estimatedWallSeconds() const;
+};
+
+struct GenerationMetricsSnapshot {
+    std::array<std::uint64_t, kMetricCounterCount> counters = {};
+    std::array<MetricPhaseTotals, kMetricPhaseCount> phases = {};
+    std::array<std::uint64_t, kStageAttemptBucketCount> stageAttempts = {};
+    int threadCount = 0;
+
+    std::uint64_t counter(MetricCounter metric) const {
+        return counters[static_cast<std::size_t>(metric)];
+    }
+
+    const MetricPhaseTotals& phase(MetricPhase metric) const {
+        return phases[static_cast<std::size_t>(metric)];
+    }
+};
+
+// What the caller knows about the run, for throughput and the JSON file.
+struct GenerationRunInfo {
+    std::string label;  // "generate", "export", ...
+    int stageCount = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    bool isMultiplayerMode = false;
+    std::uint64_t masterSeed = 0;
+    int workerThreadCount = 0;
+    double wallSeconds = 0.0;
+};
+
+constexpr bool isGenerationMetricsEnabled() {
+    return TILE_MATCHING_METRICS != 0;
+}
+
+const char* getMetricCounterName(MetricCounter metric);
+const char* getMetricPhaseName(MetricPhase metric);
+
+// Zeroes every thread's block. Call between runs, never during one.
+void resetGenerationMetrics();
+GenerationMetricsSnapshot snapshotGenerationMetrics();
+
+// Log lines ("[INFO] ...") summarizing a run.
+std::vector<std::string> formatGenerationMetrics(const GenerationMetricsSnapshot& metrics, const GenerationRunInfo& run);
+bool writeGenerationMetricsJson(
+    const GenerationMetricsSnapshot& metrics,
+    const GenerationRunInfo& run,
+    const std::string& outputPath
+);
+// "<outputPath>.metrics.json", next to the CSV or pack it describes.
+std::string getMetricsFileName(const std::string& outputPath);
+
+#if TILE_MATCHING_METRICS
+namespace metrics_detail {
+// One per thread that records. Only the owning thread writes (a plain load
+// and store, no locked instruction); snapshots read with relaxed loads.
+struct ThreadMetrics {
+    struct Phase {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> timedCalls{0};
+        std::atomic<std::uint64_t> wallNanos{0};
+        std::atomic<std::uint64_t> cpuNanos{0};
+    };
+
+    std::array<std::atomic<std::uint64_t>, kMetricCounterCount> counters{};
+    std::array<Phase, kMetricPhaseCount> phases{};
+    std::array<std::atomic<std::uint64_t>, kStageAttemptBucketCount> stageAttempts{};
+
+    // Owner only.
+    std::uint32_t sampleClock = 0;
+    bool stageSampled = false;
+};
+
+// Constant-initialized, so the hot path reads it without a TLS guard.
+inline thread_local ThreadMetrics* threadMetrics = nullptr;
+
+ThreadMetrics& registerThreadMetrics();
+std::uint64_t threadCpuNanos();
+
+inline ThreadMetrics& getThreadMetrics() {
+    ThreadMetrics* metrics = threadMetrics;
+    return metrics != nullptr ? *metrics : registerThreadMetrics();
+}
+
+inline void addRelaxed(std::atomic<std::uint64_t>& value, std::uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline void addCounter(MetricCounter metric, std::uint64_t amount) {
+    addRelaxed(getThreadMetrics().counters[static_cast<std::size_t>(metric)], amount);
+}
+
+inline void recordStageAttempts(int attemptCount) {
+    int bucket = 0;
+    while (bucket + 1 < kStageAttemptBucketCount && attemptCount > (1 << bucket)) {
+        ++bucket;
+    }
+    addRelaxed(getThreadMetrics().stageAttempts[static_cast<std::size_t>(bucket)], 1);
+}
+
+inline void recordPhase(MetricPhase metric, bool timed, std::uint64_t wallNanos, std::uint64_t cpuNanos) {
+    ThreadMetrics::Phase& phase = getThreadMetrics().phases[static_cast<std::size_t>(metric)];
+    addRelaxed(phase.calls, 1);
+    if (timed) {
+        addRelaxed(phase.timedCalls, 1);
+        addRelaxed(phase.wallNanos, wallNanos);
+        addRelaxed(phase.cpuNanos, cpuNanos);
+    }
+}
+
+// Advances this thread's sample clock; true once every kMetricsSampleInterval stages.
+inline bool beginStageSample() {
+    ThreadMetrics& metrics = getThreadMetrics();
+    metrics.stageSampled = metrics.sampleClock++ % kMetricsSampleInterval == 0;
+    return metrics.stageSampled;
+}
+
+inline bool isStageSampled() {
+    return getThreadMetrics().stageSampled;
+}
+
+inline std::uint64_t wallNanos() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()
+    );
+}
+
+// Wall and thread CPU time of every call.
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(MetricPhase metric)
+        : metric_(metric),
+          wallStart_(wallNanos()),
+          cpuStart_(threadCpuNanos()) {}
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+    ~ScopedPhaseTimer() {
+        recordPhase(metric_, true, wallNanos() - wallStart_, threadCpuNanos() - cpuStart_);
+    }
+
+private:
+    MetricPhase metric_;
+    std::uint64_t wallStart_;
+    std::uint64_t cpuStart_;
+};
+
+// Counts every call but reads the clock only inside a sampled stage.
+class SampledPhaseTimer {
+public:
+    explicit SampledPhaseTimer(MetricPhase metric)
+        : metric_(metric),
+          wallStart_(isStageSampled() ? wallNanos() : 0) {}
+
+    SampledPhaseTimer(const SampledPhaseTimer&) = delete;
+    SampledPhaseTimer& operator=(const SampledPhaseTimer&) = delete;
+
+    ~SampledPhaseTimer() {
+        const bool timed = wallStart_ != 0;
+        recordPhase(metric_, timed, timed ? wallNanos() - wallStart_ : 0, 0);
+    }
+
+private:
+    MetricPhase metric_;
+    std::uint64_t wallStart_;
+};
+} // namespace metrics_detail
+
+#define TILE_METRICS_CONCAT_INNER(left, right) left##right
+#define TILE_METRICS_CONCAT(left, right) TILE_METRICS_CONCAT_INNER(left, right)
+#define TILE_METRICS_COUNT(metric, amount) ::metrics_detail::addCounter(MetricCounter::metric, (amount))
+#define TILE_METRICS_STAGE_ATTEMPTS(attemptCount) ::metrics_detail::recordStageAttempts(attemptCount)
+#define TILE_METRICS_BEGIN_STAGE() ((void)::metrics_detail::beginStageSample())
+#define TILE_METRICS_PHASE(metric) \
+    ::metrics_detail::ScopedPhaseTimer TILE_METRICS_CONCAT(metricsPhaseTimer, __LINE__)(MetricPhase::metric)
+#define TILE_METRICS_SAMPLED_PHASE(metric) \
+    ::metrics_detail::SampledPhaseTimer TILE_METRICS_CONCAT(metricsPhaseTimer, __LINE__)(MetricPhase::metric)
+#else
+#define TILE_METRICS_COUNT(metric, amount) ((void)0)
+#define TILE_METRICS_STAGE_ATTEMPTS(attemptCount) ((void)0)
+#define TILE_METRICS_BEGIN_STAGE() ((void)0)
+#define TILE_METRICS_PHASE(metric) ((void)0)
+#define TILE_METRICS_SAMPLED_PHASE(metric) ((void)0)
+#endif
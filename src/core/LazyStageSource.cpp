@@ -0,0 +1,202 @@
+#include "core/LazyStageSource.hpp"
+
+#include "core/StageCsvExporter.hpp"
+#include "core/StagePack.hpp"
+
+#include <algorithm>
+
+namespace {
+// Tiles generated per export window, whatever the map size: 8 MiB at 16 bits
+// a tile, half that for layouts kept in bytes.
+constexpr std::size_t kExportWindowTiles = std::size_t{4} << 20;
+
+// Generates the batch window by window on the pool for one of the windowed
+// exporters: writeWindows(windowStageCount, fillWindow) does the writing.
+template <typename WriteWindows>
+bool writeLazyStages(
+    const StageSourceSettings& settings,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int& invalidStageCount,
+    WriteWindows&& writeWindows
+) {
+    invalidStageCount = 0;
+
+    const std::size_t stageTileCount = static_cast<std::size_t>(std::max(1, settings.mapWidth)) *
+        std::max(1, settings.mapHeight) * getMapCountPerStage(settings.isMultiplayerMode);
+    const int windowStageCount = static_cast<int>(std::clamp<std::size_t>(
+        kExportWindowTiles / stageTileCount,
+        1,
+        static_cast<std::size_t>(std::max(1, settings.stageCount))
+    ));
+
+    // Progress from shuffleStageMaps counts stages of the current window only.
+    int completedBeforeWindow = 0;
+    GenerationControl windowControl;
+    windowControl.cancelRequested = control.cancelRequested;
+    if (control.onStageCompleted) {
+        windowControl.onStageCompleted = [&](int completedInWindow) {
+            control.onStageCompleted(completedBeforeWindow + completedInWindow);
+        };
+    }
+
+    return writeWindows(windowStageCount, [&](int firstStageIndex, int stageCountInWindow, StageStore& window) {
+        completedBeforeWindow = firstStageIndex;
+        window.reset(
+            stageCountInWindow,
+            getMapCountPerStage(settings.isMultiplayerMode),
+            settings.mapWidth,
+            settings.mapHeight
+        );
+        invalidStageCount += shuffleStageMaps(
+            window,
+            settings.shuffleSettings,
+            settings.isMultiplayerMode,
+            settings.masterSeed,
+            pool,
+            windowControl,
+            firstStageIndex
+        );
+        return !control.isCancelled();
+    });
+}
+} // namespace
+
+LazyStageSource::LazyStageSource(const StageSourceSettings& settings, int cacheCapacity)
+    : settings_(settings),
+      slots_(static_cast<std::size_t>(std::max(2, cacheCapacity))) {
+    settings_.stageCount = std::max(0, settings_.stageCount);
+    if (settings_.mapWidth <= 0 || settings_.mapHeight <= 0 ||
+        settings_.mapHeight > getMaxMapHeight(settings_.mapWidth, mapCountPerStage())) {
+        settings_.stageCount = 0;
+        return;
+    }
+
+    arrangementPossible_ = checkStageConfigurationFeasibility(
+        settings_.mapWidth,
+        settings_.mapHeight,
+        settings_.isMultiplayerMode
+    ).isPossible;
+    stageTileCount_ = static_cast<std::size_t>(settings_.mapWidth) * settings_.mapHeight * mapCountPerStage();
+    slotTiles_.resize(slots_.size() * stageTileCount_);
+}
+
+const StageSourceSettings& LazyStageSource::settings() const {
+    return settings_;
+}
+
+bool LazyStageSource::empty() const {
+    return settings_.stageCount == 0;
+}
+
+int LazyStageSource::stageCount() const {
+    return settings_.stageCount;
+}
+
+int LazyStageSource::mapCountPerStage() const {
+    return getMapCountPerStage(settings_.isMultiplayerMode);
+}
+
+MapView LazyStageSource::map(int stageIndex, int mapIndex) {
+    const int slotIndex = acquireSlot(stageIndex);
+    const std::size_t mapTileCount = static_cast<std::size_t>(settings_.mapWidth) * settings_.mapHeight;
+
+    MapView view;
+    view.width = settings_.mapWidth;
+    view.height = settings_.mapHeight;
+    view.tiles = slotTiles_.data() + static_cast<std::size_t>(slotIndex) * stageTileCount_ + mapIndex * mapTileCount;
+    return view;
+}
+
+bool LazyStageSource::isStageArranged(int stageIndex) {
+    return slots_[static_cast<std::size_t>(acquireSlot(stageIndex))].arranged;
+}
+
+int LazyStageSource::cachedStageCount() const {
+    return static_cast<int>(std::count_if(slots_.begin(), slots_.end(), [](const CacheSlot& slot) {
+        return slot.stageIndex >= 0;
+    }));
+}
+
+std::uint64_t LazyStageSource::generatedStageCount() const {
+    return generatedStageCount_;
+}
+
+std::size_t LazyStageSource::memoryUsageBytes() const {
+    return slotTiles_.capacity() * sizeof(Tile) + slots_.capacity() * sizeof(CacheSlot);
+}
+
+int LazyStageSource::acquireSlot(int stageIndex) {
+    ++useClock_;
+
+    // The cache is a few dozen slots, so a linear scan beats any index.
+    std::size_t victim = 0;
+    for (std::size_t slotIndex = 0; slotIndex < slots_.size(); ++slotIndex) {
+        CacheSlot& slot = slots_[slotIndex];
+        if (slot.stageIndex == stageIndex) {
+            slot.lastUse = useClock_;
+            return static_cast<int>(slotIndex);
+        }
+        if (slot.lastUse < slots_[victim].lastUse) {
+            victim = slotIndex;
+        }
+    }
+
+    CacheSlot& slot = slots_[victim];
+    slot.stageIndex = stageIndex;
+    slot.lastUse = useClock_;
+    slot.arranged = generateStageTiles(
+        slotTiles_.data() + victim * stageTileCount_,
+        settings_.mapWidth,
+        settings_.mapHeight,
+        settings_.isMultiplayerMode,
+        stageIndex,
+        settings_.shuffleSettings,
+        settings_.masterSeed,
+        arrangementPossible_
+    );
+    ++generatedStageCount_;
+    return static_cast<int>(victim);
+}
+
+bool writeLazyStagesCsv(
+    const StageSourceSettings& settings,
+    const std::string& outputPath,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int& invalidStageCount
+) {
+    const auto writeWindows = [&](int windowStageCount, const StageWindowFiller& fillWindow) {
+        return writeStagesCsvByWindow(
+            settings.stageCount,
+            windowStageCount,
+            settings.isMultiplayerMode,
+            settings.masterSeed,
+            outputPath,
+            fillWindow
+        );
+    };
+    return writeLazyStages(settings, pool, control, invalidStageCount, writeWindows);
+}
+
+bool writeLazyStagesPack(
+    const StageSourceSettings& settings,
+    const std::string& outputPath,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int& invalidStageCount
+) {
+    const auto writeWindows = [&](int windowStageCount, const StageWindowFiller& fillWindow) {
+        return writeStagePackByWindow(
+            settings.stageCount,
+            windowStageCount,
+            settings.mapWidth,
+            settings.mapHeight,
+            settings.isMultiplayerMode,
+            settings.masterSeed,
+            outputPath,
+            fillWindow
+        );
+    };
+    return writeLazyStages(settings, pool, control, invalidStageCount, writeWindows);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "core/StageGenerator.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything that determines the tiles of a batch.
+struct StageSourceSettings {
+    int stageCount = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    bool isMultiplayerMode = false;
+    ShuffleSettings shuffleSettings;
+    std::uint64_t masterSeed = 0;
+};
+
+// A batch whose stages are generated when they are asked for. Stage i is a
+// pure function of the settings and i (see generateStageTiles), so only a
+// small LRU cache of recently used stages is kept and any index opens
+// directly. Memory use does not depend on the stage count.
+class LazyStageSource {
+public:
+    static constexpr int kDefaultCacheCapacity = 32;
+
+    LazyStageSource() = default;
+    explicit LazyStageSource(const StageSourceSettings& settings, int cacheCapacity = kDefaultCacheCapacity);
+
+    const StageSourceSettings& settings() const;
+    bool empty() const;
+    int stageCount() const;
+    int mapCountPerStage() const;
+
+    // The view stays valid until cacheCapacity - 1 other stages have been
+    // requested after this one.
+    MapView map(int stageIndex, int mapIndex);
+
+    // False if the stage could not avoid vertically adjacent equal numbers.
+    bool isStageArranged(int stageIndex);
+
+    int cachedStageCount() const;
+    std::uint64_t generatedStageCount() const;
+    std::size_t memoryUsageBytes() const;
+
+private:
+    struct CacheSlot {
+        int stageIndex = -1;
+        std::uint64_t lastUse = 0;
+        bool arranged = false;
+    };
+
+    int acquireSlot(int stageIndex);
+
+    StageSourceSettings settings_;
+    bool arrangementPossible_ = true;
+    std::size_t stageTileCount_ = 0;
+    std::vector<CacheSlot> slots_;
+    // Slot s holds its stage's tiles at s * stageTileCount_.
+    std::vector<Tile> slotTiles_;
+    std::uint64_t useClock_ = 0;
+    std::uint64_t generatedStageCount_ = 0;
+};
+
+// Writes the batch described by settings to outputPath in the format of
+// writeStagesCsv without ever holding the whole batch: stages are generated on
+// the pool one window at a time and written in order. Progress and
+// cancellation go through control as for shuffleStageMaps. invalidStageCount
+// receives the number of stages that kept vertical matches.
+bool writeLazyStagesCsv(
+    const StageSourceSettings& settings,
+    const std::string& outputPath,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int& invalidStageCount
+);
+
+// writeLazyStagesCsv for the binary stage pack format (see StagePack.hpp).
+bool writeLazyStagesPack(
+    const StageSourceSettings& settings,
+    const std::string& outputPath,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int& invalidStageCount
+);
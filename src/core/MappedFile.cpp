@@ -0,0 +1,166 @@
+#include "core/MappedFile.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        swap(other);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#if defined(_WIN32)
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open '" + path + "' (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        error = "cannot read the size of '" + path + "' (error " + std::to_string(GetLastError()) + ")";
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    isOpen_ = true;
+    if (size_ == 0) {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        error = "cannot map '" + path + "' (error " + std::to_string(GetLastError()) + ")";
+        close();
+        return false;
+    }
+    mappingHandle_ = mapping;
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        error = "cannot map '" + path + "' (error " + std::to_string(GetLastError()) + ")";
+        close();
+        return false;
+    }
+    data_ = static_cast<const std::uint8_t*>(view);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+    }
+    if (fileHandle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(fileHandle_));
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isOpen_ = false;
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat fileStatus = {};
+    if (::fstat(fd, &fileStatus) != 0) {
+        error = "cannot read the size of '" + path + "': " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<std::size_t>(fileStatus.st_size);
+    if (size_ > 0) {
+        void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            error = "cannot map '" + path + "': " + std::strerror(errno);
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const std::uint8_t*>(mapping);
+    }
+
+    // The mapping keeps the file referenced on its own.
+    ::close(fd);
+    isOpen_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isOpen_ = false;
+}
+#endif
+
+bool MappedFile::isOpen() const {
+    return isOpen_;
+}
+
+const std::uint8_t* MappedFile::data() const {
+    return data_;
+}
+
+std::size_t MappedFile::size() const {
+    return size_;
+}
+
+void MappedFile::swap(MappedFile& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(isOpen_, other.isOpen_);
+#if defined(_WIN32)
+    std::swap(fileHandle_, other.fileHandle_);
+    std::swap(mappingHandle_, other.mappingHandle_);
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The bytes are paged in by the OS
+// as they are touched, so opening is O(1) in the file size.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    // On failure returns false and describes the problem in error.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool isOpen() const;
+    // nullptr for an empty file.
+    const std::uint8_t* data() const;
+    std::size_t size() const;
+
+private:
+    void swap(MappedFile& other) noexcept;
+
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool isOpen_ = false;
+#if defined(_WIN32)
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
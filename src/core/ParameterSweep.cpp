@@ -0,0 +1,183 @@
+#include "core/ParameterSweep.hpp"
+
+#include "core/StageCsvExporter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+double getShare(std::uint64_t count, int sampledStageCount) {
+    return sampledStageCount > 0 ? static_cast<double>(count) / sampledStageCount : 0.0;
+}
+
+void sampleParameterSweepCell(
+    ParameterSweepCell& cell,
+    const ParameterSweepSettings& settings,
+    const GenerationControl& control
+) {
+    cell.arrangementPossible =
+        checkStageConfigurationFeasibility(cell.mapWidth, cell.mapHeight, cell.isMultiplayerMode).isPossible;
+
+    ArrangementOutcomeCounts outcomes;
+    GenerationControl cellControl;
+    cellControl.cancelRequested = control.cancelRequested;
+    cellControl.arrangementOutcomes = &outcomes;
+
+    std::vector<Tile> stageTiles(
+        static_cast<std::size_t>(cell.mapWidth) * cell.mapHeight * getMapCountPerStage(cell.isMultiplayerMode)
+    );
+    const auto startTime = std::chrono::steady_clock::now();
+    int stageIndex = 0;
+    for (; stageIndex < settings.samplesPerCell && !control.isCancelled(); ++stageIndex) {
+        generateStageTiles(
+            stageTiles.data(),
+            cell.mapWidth,
+            cell.mapHeight,
+            cell.isMultiplayerMode,
+            stageIndex,
+            settings.shuffleSettings,
+            settings.masterSeed,
+            cell.arrangementPossible,
+            cellControl
+        );
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    cell.sampledStageCount = stageIndex;
+    cell.validAfterShuffleCount = outcomes.validAfterShuffle.load(std::memory_order_relaxed);
+    cell.repairedCount = outcomes.repaired.load(std::memory_order_relaxed);
+    cell.placedCount = outcomes.placed.load(std::memory_order_relaxed);
+    // A skipped layout keeps its vertical matches just like a failed one.
+    cell.failedCount = outcomes.failed.load(std::memory_order_relaxed) + outcomes.skipped.load(std::memory_order_relaxed);
+    cell.secondsPerStage = stageIndex > 0 ? elapsed.count() / stageIndex : 0.0;
+}
+} // namespace
+
+double ParameterSweepCell::acceptanceRate() const {
+    return getShare(validAfterShuffleCount, sampledStageCount);
+}
+
+double ParameterSweepCell::failureRate() const {
+    return getShare(failedCount, sampledStageCount);
+}
+
+const ParameterSweepCell* ParameterSweepResult::findCell(int mapWidth, int mapHeight, bool isMultiplayerMode) const {
+    for (const ParameterSweepCell& cell : cells) {
+        if (cell.mapWidth == mapWidth && cell.mapHeight == mapHeight && cell.isMultiplayerMode == isMultiplayerMode) {
+            return &cell;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<ParameterSweepCell> createParameterSweepCells(const ParameterSweepSettings& settings) {
+    const int minMapWidth = std::clamp(settings.minMapWidth, 1, kMaxMapWidth);
+    const int maxMapWidth = std::clamp(settings.maxMapWidth, minMapWidth, kMaxMapWidth);
+    // Multi stages have the most tiles, so their limit holds for both modes.
+    const int heightLimit = getMaxMapHeight(maxMapWidth, getMapCountPerStage(true));
+    const int minMapHeight = std::clamp(settings.minMapHeight, 1, heightLimit);
+    const int maxMapHeight = std::clamp(settings.maxMapHeight, minMapHeight, heightLimit);
+
+    std::vector<ParameterSweepCell> cells;
+    for (const bool isMultiplayerMode : {false, true}) {
+        if (!(isMultiplayerMode ? settings.includeMultiMode : settings.includeSingleMode)) {
+            continue;
+        }
+
+        for (int mapHeight = minMapHeight; mapHeight <= maxMapHeight; ++mapHeight) {
+            for (int mapWidth = minMapWidth; mapWidth <= maxMapWidth; ++mapWidth) {
+                ParameterSweepCell cell;
+                cell.mapWidth = mapWidth;
+                cell.mapHeight = mapHeight;
+                cell.isMultiplayerMode = isMultiplayerMode;
+                cells.push_back(cell);
+            }
+        }
+    }
+    return cells;
+}
+
+ParameterSweepResult runParameterSweep(
+    const ParameterSweepSettings& settings,
+    WorkStealingPool& pool,
+    const GenerationControl& control
+) {
+    ParameterSweepResult result;
+    result.settings = settings;
+    result.cells = createParameterSweepCells(settings);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::atomic<int> completedCellCount{0};
+    pool.parallelFor(static_cast<int>(result.cells.size()), [&](int cellIndex) {
+        if (control.isCancelled()) {
+            return;
+        }
+
+        sampleParameterSweepCell(result.cells[static_cast<std::size_t>(cellIndex)], settings, control);
+        const int completed = completedCellCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (control.onStageCompleted) {
+            control.onStageCompleted(completed);
+        }
+    });
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    result.wallSeconds = elapsed.count();
+    result.cancelled = control.isCancelled();
+    return result;
+}
+
+std::string getParameterSweepFileName(const std::string& exportTitle) {
+    const std::string normalizedTitle = normalizeExportTitle(exportTitle);
+    if (normalizedTitle.empty()) {
+        return "parameter_sweep.csv";
+    }
+
+    return "parameter_sweep_" + normalizedTitle + ".csv";
+}
+
+bool writeParameterSweepCsv(const ParameterSweepResult& result, const std::string& outputPath) {
+    std::FILE* file = std::fopen(outputPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    const ParameterSweepSettings& settings = result.settings;
+    std::fprintf(
+        file,
+        "# parameter_sweep master_seed=%llu samples_per_cell=%d shuffle_count=%d kernel=%s rng=%s wall_seconds=%.3f%s\n",
+        static_cast<unsigned long long>(settings.masterSeed),
+        settings.samplesPerCell,
+        settings.shuffleSettings.shuffleCount,
+        settings.shuffleSettings.kernel == ShuffleKernel::LegacyExact ? "legacy" : "fast",
+        settings.shuffleSettings.rngBackend == RngBackend::Xoshiro256StarStar ? "xoshiro" : "mt19937",
+        result.wallSeconds,
+        result.cancelled ? " cancelled=1" : ""
+    );
+    std::fprintf(
+        file,
+        "mode,width,height,possible,samples,valid_after_shuffle,repaired,placed,failed,"
+        "acceptance_rate,failure_rate,us_per_stage\n"
+    );
+    for (const ParameterSweepCell& cell : result.cells) {
+        std::fprintf(
+            file,
+            "%s,%d,%d,%d,%d,%llu,%llu,%llu,%llu,%.6f,%.6f,%.3f\n",
+            cell.isMultiplayerMode ? "multi" : "single",
+            cell.mapWidth,
+            cell.mapHeight,
+            cell.arrangementPossible ? 1 : 0,
+            cell.sampledStageCount,
+            static_cast<unsigned long long>(cell.validAfterShuffleCount),
+            static_cast<unsigned long long>(cell.repairedCount),
+            static_cast<unsigned long long>(cell.placedCount),
+            static_cast<unsigned long long>(cell.failedCount),
+            cell.acceptanceRate(),
+            cell.failureRate(),
+            cell.secondsPerStage * 1'000'000.0
+        );
+    }
+
+    return std::fclose(file) == 0;
+}
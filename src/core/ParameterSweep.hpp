@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/StageGenerator.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A grid of map sizes and modes to sample before committing to a batch.
+struct ParameterSweepSettings {
+    int minMapWidth = 2;
+    int maxMapWidth = 8;
+    int minMapHeight = 2;
+    int maxMapHeight = 8;
+    bool includeSingleMode = true;
+    bool includeMultiMode = true;
+    // Stages generated per cell: stages 0..samplesPerCell - 1 of the batch
+    // each cell's settings and masterSeed describe.
+    int samplesPerCell = 1000;
+    ShuffleSettings shuffleSettings;
+    std::uint64_t masterSeed = 0;
+};
+
+struct ParameterSweepCell {
+    int mapWidth = 0;
+    int mapHeight = 0;
+    bool isMultiplayerMode = false;
+    // False for layouts that cannot avoid vertical matches at all; their
+    // stages are still sampled for timing.
+    bool arrangementPossible = true;
+    int sampledStageCount = 0;
+    std::uint64_t validAfterShuffleCount = 0;
+    std::uint64_t repairedCount = 0;
+    std::uint64_t placedCount = 0;
+    std::uint64_t failedCount = 0;
+    double secondsPerStage = 0.0;
+
+    // Share of sampled stages the arranger accepted exactly as shuffled.
+    double acceptanceRate() const;
+    // Share of sampled stages left with vertically adjacent equal numbers.
+    double failureRate() const;
+};
+
+struct ParameterSweepResult {
+    ParameterSweepSettings settings;
+    // Single mode first, then by height and width, as createParameterSweepCells.
+    std::vector<ParameterSweepCell> cells;
+    double wallSeconds = 0.0;
+    bool cancelled = false;
+
+    // nullptr if the cell is not part of the sweep.
+    const ParameterSweepCell* findCell(int mapWidth, int mapHeight, bool isMultiplayerMode) const;
+};
+
+// The cells of the sweep with only their size and mode set. Widths are
+// clamped to 1..kMaxMapWidth and heights to 1..getMaxMapHeight of the
+// widest multi stage.
+std::vector<ParameterSweepCell> createParameterSweepCells(const ParameterSweepSettings& settings);
+
+// Samples every cell on the pool, one cell per task so that the time per
+// stage of a cell is measured on a single thread. control.onStageCompleted
+// receives the number of finished cells.
+ParameterSweepResult runParameterSweep(
+    const ParameterSweepSettings& settings,
+    WorkStealingPool& pool,
+    const GenerationControl& control
+);
+
+// "parameter_sweep.csv", with the normalized title appended like the stage CSV.
+std::string getParameterSweepFileName(const std::string& exportTitle);
+
+// One row per cell after a "# parameter_sweep ..." line with the settings.
+bool writeParameterSweepCsv(const ParameterSweepResult& result, const std::string& outputPath);
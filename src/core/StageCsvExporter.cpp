@@ -0,0 +1,537 @@
+#include "core/StageCsvExporter.hpp"
+
+#include "core/GenerationMetrics.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+constexpr std::size_t kCsvBlockBytes = std::size_t{1} << 20;
+
+// Longest single field appended without a capacity check in between: a
+// 20-digit integer plus its separator.
+constexpr std::size_t kMaxFieldBytes = 24;
+
+// CSV files are opened in text mode, so every '\n' reaches the file as the
+// platform's line ending; row offsets are file offsets and count it in full.
+#if defined(_WIN32)
+constexpr char kFileLineEnding[] = "\r\n";
+#else
+constexpr char kFileLineEnding[] = "\n";
+#endif
+constexpr std::uint64_t kFileLineEndingBytes = sizeof(kFileLineEnding) - 1;
+
+// Formats CSV text with std::to_chars into one fixed block and hands it to
+// fwrite whenever it fills up, so memory stays at kCsvBlockBytes however large
+// the pack is and the file sees a few big writes instead of one per field.
+class CsvBlockWriter {
+public:
+    explicit CsvBlockWriter(std::FILE* file)
+        : file_(file),
+          block_(std::make_unique<char[]>(kCsvBlockBytes)) {}
+
+    void appendChar(char ch) {
+        reserveField();
+        block_[used_++] = ch;
+    }
+
+    void appendText(const char* text) {
+        for (; *text != '\0'; ++text) {
+            appendChar(*text);
+        }
+    }
+
+    template <typename T>
+    void appendNumber(T value) {
+        reserveField();
+        char* begin = block_.get() + used_;
+        used_ = static_cast<std::size_t>(std::to_chars(begin, begin + kMaxFieldBytes, value).ptr - block_.get());
+    }
+
+    void appendMap(const MapView& map) {
+        map.visitTiles([&](const auto* tiles) {
+            for (int col = 0; col < map.width; ++col) {
+                if (col > 0) {
+                    appendChar('^');
+                }
+
+                for (int row = 0; row < map.height; ++row) {
+                    reserveField();
+                    if (row > 0) {
+                        block_[used_++] = '#';
+                    }
+
+                    const int tileIndex = row * map.width + col;
+                    char* begin = block_.get() + used_;
+                    const char* end = std::to_chars(begin, begin + kMaxFieldBytes, tiles[tileIndex]).ptr;
+                    used_ = static_cast<std::size_t>(end - block_.get());
+                }
+            }
+        });
+    }
+
+    void appendHeader(bool isMultiplayerMode, std::uint64_t masterSeed) {
+        appendText("# master_seed=");
+        appendNumber(masterSeed);
+        appendLineEnd();
+        appendText(isMultiplayerMode ? "stage,width,height,map1,map2" : "stage,width,height,map");
+        appendLineEnd();
+    }
+
+    // One row per stage; multi mode always has a (possibly empty) map2 column.
+    // stageNumber is the 1-based number written in the stage column.
+    void appendStageRow(const StageStore& stages, int stageIndex, bool isMultiplayerMode, int stageNumber) {
+        const int mapCount = stages.stage(stageIndex).mapCount;
+        if (mapCount == 0) {
+            return;
+        }
+
+        const MapView firstMap = stages.map(stageIndex, 0);
+        appendNumber(stageNumber);
+        appendChar(',');
+        appendNumber(firstMap.width);
+        appendChar(',');
+        appendNumber(firstMap.height);
+        appendChar(',');
+        appendMap(firstMap);
+        if (isMultiplayerMode) {
+            appendChar(',');
+            if (mapCount >= 2) {
+                appendMap(stages.map(stageIndex, 1));
+            }
+        }
+        appendLineEnd();
+    }
+
+    bool flush() {
+        if (used_ > 0 && !failed_) {
+            failed_ = std::fwrite(block_.get(), 1, used_, file_) != used_;
+            TILE_METRICS_COUNT(BytesWritten, used_);
+        }
+        bytesFlushed_ += used_;
+        used_ = 0;
+        return !failed_;
+    }
+
+    std::uint64_t bytesWritten() const {
+        return bytesFlushed_ + used_;
+    }
+
+    // Where the next character lands in the file, line endings included.
+    std::uint64_t fileOffset() const {
+        return bytesWritten() + linesWritten_ * (kFileLineEndingBytes - 1);
+    }
+
+private:
+    void appendLineEnd() {
+        appendChar('\n');
+        ++linesWritten_;
+    }
+
+    void reserveField() {
+        if (kCsvBlockBytes - used_ < kMaxFieldBytes) {
+            flush();
+        }
+    }
+
+    std::FILE* file_;
+    std::unique_ptr<char[]> block_;
+    std::size_t used_ = 0;
+    std::uint64_t bytesFlushed_ = 0;
+    std::uint64_t linesWritten_ = 0;
+    bool failed_ = false;
+};
+
+// Text mode, like the std::ofstream the exporter used to write through.
+std::FILE* openCsvFile(const std::string& outputPath) {
+    return std::fopen(outputPath.c_str(), "w");
+}
+
+bool closeCsvFile(std::FILE* file, CsvBlockWriter& writer) {
+    const bool flushed = writer.flush();
+    return std::fclose(file) == 0 && flushed;
+}
+
+// CSV files of large packs run past what a long offset can address on Windows.
+bool seekCsvFile(std::FILE* file, std::uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+void beginRowIndex(StageCsvRowIndex& rowIndex, const std::string& outputPath, bool isMultiplayerMode, int stageCount) {
+    rowIndex.outputPath = outputPath;
+    rowIndex.isMultiplayerMode = isMultiplayerMode;
+    rowIndex.rowOffsets.clear();
+    rowIndex.rowOffsets.reserve(static_cast<std::size_t>(stageCount) + 1);
+}
+
+// The row appendStageRow writes for the stage, without its line ending.
+std::string formatStageRow(const StageStore& stages, int stageIndex, bool isMultiplayerMode) {
+    const int mapCount = stages.stage(stageIndex).mapCount;
+    const MapView firstMap = stages.map(stageIndex, 0);
+    std::string row;
+    char number[kMaxFieldBytes];
+    for (const int value : {stageIndex + 1, firstMap.width, firstMap.height}) {
+        row.append(number, std::to_chars(number, number + sizeof(number), value).ptr);
+        row.push_back(',');
+    }
+    row += serializeMapForCsv(firstMap);
+    if (isMultiplayerMode) {
+        row.push_back(',');
+        if (mapCount >= 2) {
+            row += serializeMapForCsv(stages.map(stageIndex, 1));
+        }
+    }
+    return row;
+}
+} // namespace
+
+std::string normalizeExportTitle(const std::string& rawTitle) {
+    std::string normalizedTitle;
+    normalizedTitle.reserve(rawTitle.size());
+
+    for (char ch : rawTitle) {
+        if (std::isalnum(static_cast<unsigned char>(ch))) {
+            normalizedTitle.push_back(ch);
+        } else if (std::isspace(static_cast<unsigned char>(ch)) || ch == '-' || ch == '_') {
+            normalizedTitle.push_back('_');
+        }
+    }
+
+    while (!normalizedTitle.empty() && normalizedTitle.front() == '_') {
+        normalizedTitle.erase(normalizedTitle.begin());
+    }
+    while (!normalizedTitle.empty() && normalizedTitle.back() == '_') {
+        normalizedTitle.pop_back();
+    }
+
+    return normalizedTitle;
+}
+
+std::string getStageCsvFileName(bool isMultiplayerMode, const std::string& exportTitle) {
+    const std::string baseName = isMultiplayerMode ? "stages_multi_mode" : "stages_single_mode";
+    const std::string normalizedTitle = normalizeExportTitle(exportTitle);
+
+    if (normalizedTitle.empty()) {
+        return baseName + ".csv";
+    }
+
+    return baseName + "_" + normalizedTitle + ".csv";
+}
+
+std::string serializeMapForCsv(const MapView& map) {
+    std::string serializedMap;
+    serializedMap.reserve(map.tileCount() * 3);
+
+    char number[kMaxFieldBytes];
+    for (int col = 0; col < map.width; ++col) {
+        if (col > 0) {
+            serializedMap.push_back('^');
+        }
+
+        for (int row = 0; row < map.height; ++row) {
+            if (row > 0) {
+                serializedMap.push_back('#');
+            }
+
+            const Tile tile = map.tileAt(static_cast<std::size_t>(row * map.width + col));
+            char* const end = std::to_chars(number, number + sizeof(number), tile).ptr;
+            serializedMap.append(number, end);
+        }
+    }
+
+    return serializedMap;
+}
+
+bool writeStagesCsv(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    StageCsvRowIndex* rowIndex
+) {
+    TILE_METRICS_PHASE(Export);
+    std::FILE* csvFile = openCsvFile(outputPath);
+    if (csvFile == nullptr) {
+        return false;
+    }
+
+    if (rowIndex != nullptr) {
+        beginRowIndex(*rowIndex, outputPath, isMultiplayerMode, stages.stageCount());
+    }
+    CsvBlockWriter writer(csvFile);
+    writer.appendHeader(isMultiplayerMode, masterSeed);
+    for (int stageIndex = 0; stageIndex < stages.stageCount(); ++stageIndex) {
+        if (rowIndex != nullptr) {
+            rowIndex->rowOffsets.push_back(writer.fileOffset());
+        }
+        writer.appendStageRow(stages, stageIndex, isMultiplayerMode, stageIndex + 1);
+    }
+    if (rowIndex != nullptr) {
+        rowIndex->rowOffsets.push_back(writer.fileOffset());
+    }
+
+    const bool closed = closeCsvFile(csvFile, writer);
+    if (!closed && rowIndex != nullptr) {
+        rowIndex->clear();
+    }
+    return closed;
+}
+
+bool exportStagesToCsv(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& exportTitle,
+    std::string& outputPath,
+    StageCsvRowIndex* rowIndex
+) {
+    outputPath = getStageCsvFileName(isMultiplayerMode, exportTitle);
+    return writeStagesCsv(stages, isMultiplayerMode, masterSeed, outputPath, rowIndex);
+}
+
+bool rewriteStagesCsvRows(
+    const StageStore& stages,
+    const std::vector<int>& stageIndices,
+    const StageCsvRowIndex& rowIndex
+) {
+    TILE_METRICS_PHASE(Export);
+    if (rowIndex.rowOffsets.size() != static_cast<std::size_t>(stages.stageCount()) + 1) {
+        return false;
+    }
+
+    std::error_code sizeError;
+    const std::uintmax_t fileSize = std::filesystem::file_size(rowIndex.outputPath, sizeError);
+    if (sizeError || fileSize != rowIndex.rowOffsets.back()) {
+        return false;
+    }
+
+    // Every row is formatted and checked before the first write, so a
+    // mismatch leaves the file as it was.
+    struct PendingRow {
+        std::uint64_t offset = 0;
+        std::string text;
+    };
+    std::vector<PendingRow> pendingRows;
+    pendingRows.reserve(stageIndices.size());
+    for (const int stageIndex : stageIndices) {
+        if (stageIndex < 0 || stageIndex >= stages.stageCount()) {
+            return false;
+        }
+
+        const std::uint64_t offset = rowIndex.rowOffsets[static_cast<std::size_t>(stageIndex)];
+        const std::uint64_t rowBytes = rowIndex.rowOffsets[static_cast<std::size_t>(stageIndex) + 1] - offset;
+        if (stages.stage(stageIndex).mapCount == 0) {
+            if (rowBytes != 0) {
+                return false;
+            }
+            continue;
+        }
+
+        std::string text = formatStageRow(stages, stageIndex, rowIndex.isMultiplayerMode);
+        text += kFileLineEnding;
+        if (text.size() != rowBytes) {
+            return false;
+        }
+        pendingRows.push_back(PendingRow{offset, std::move(text)});
+    }
+
+    // Binary mode: the rows already carry the platform's line ending.
+    std::FILE* csvFile = std::fopen(rowIndex.outputPath.c_str(), "r+b");
+    if (csvFile == nullptr) {
+        return false;
+    }
+
+    // The stage number opens every row; a file rewritten by something else
+    // since the index was taken is left alone.
+    bool matches = true;
+    std::string stagePrefix;
+    for (const PendingRow& row : pendingRows) {
+        const std::size_t prefixLength = row.text.find(',') + 1;
+        stagePrefix.resize(prefixLength);
+        if (!seekCsvFile(csvFile, row.offset)
+            || std::fread(stagePrefix.data(), 1, prefixLength, csvFile) != prefixLength
+            || stagePrefix.compare(0, prefixLength, row.text, 0, prefixLength) != 0) {
+            matches = false;
+            break;
+        }
+    }
+
+    bool written = matches;
+    for (const PendingRow& row : pendingRows) {
+        if (!written) {
+            break;
+        }
+        written = seekCsvFile(csvFile, row.offset)
+            && std::fwrite(row.text.data(), 1, row.text.size(), csvFile) == row.text.size();
+        TILE_METRICS_COUNT(BytesWritten, row.text.size());
+    }
+    return std::fclose(csvFile) == 0 && written;
+}
+
+bool writeStagesCsvByWindow(
+    int stageCount,
+    int windowStageCount,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    const StageWindowFiller& fillWindow
+) {
+    TILE_METRICS_PHASE(Export);
+    std::FILE* csvFile = openCsvFile(outputPath);
+    if (csvFile == nullptr) {
+        return false;
+    }
+
+    CsvBlockWriter writer(csvFile);
+    writer.appendHeader(isMultiplayerMode, masterSeed);
+
+    StageStore window;
+    bool completed = true;
+    windowStageCount = std::max(1, windowStageCount);
+    for (int firstStageIndex = 0; firstStageIndex < stageCount; firstStageIndex += windowStageCount) {
+        const int currentWindowStageCount = std::min(windowStageCount, stageCount - firstStageIndex);
+        if (!fillWindow(firstStageIndex, currentWindowStageCount, window)) {
+            completed = false;
+            break;
+        }
+
+        for (int stageIndex = 0; stageIndex < currentWindowStageCount; ++stageIndex) {
+            writer.appendStageRow(window, stageIndex, isMultiplayerMode, firstStageIndex + stageIndex + 1);
+        }
+    }
+
+    const bool closed = closeCsvFile(csvFile, writer);
+    if (!completed) {
+        std::error_code removeError;
+        std::filesystem::remove(outputPath, removeError);
+    }
+    return completed && closed;
+}
+
+StreamingCsvExporter::~StreamingCsvExporter() {
+    abort();
+}
+
+bool StreamingCsvExporter::start(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    StageCsvRowIndex* rowIndex
+) {
+    if (worker_.joinable()) {
+        return false;
+    }
+
+    std::FILE* csvFile = openCsvFile(outputPath);
+    if (csvFile == nullptr) {
+        return false;
+    }
+
+    stages_ = &stages;
+    isMultiplayerMode_ = isMultiplayerMode;
+    masterSeed_ = masterSeed;
+    outputPath_ = outputPath;
+    rowIndex_ = rowIndex;
+    if (rowIndex_ != nullptr) {
+        beginRowIndex(*rowIndex_, outputPath, isMultiplayerMode, stages.stageCount());
+    }
+    readyStages_ = std::make_unique<std::atomic<std::uint8_t>[]>(static_cast<std::size_t>(stages.stageCount()));
+    aborted_.store(false, std::memory_order_relaxed);
+    bytesWritten_.store(0, std::memory_order_relaxed);
+    succeeded_ = false;
+    worker_ = std::thread(&StreamingCsvExporter::runWorker, this, csvFile);
+    return true;
+}
+
+void StreamingCsvExporter::markStageReady(int stageIndex) {
+    readyStages_[static_cast<std::size_t>(stageIndex)].store(1, std::memory_order_release);
+}
+
+bool StreamingCsvExporter::finish() {
+    if (!worker_.joinable()) {
+        return false;
+    }
+
+    worker_.join();
+    return succeeded_;
+}
+
+void StreamingCsvExporter::abort() {
+    if (!worker_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(abortMutex_);
+        aborted_.store(true, std::memory_order_relaxed);
+    }
+    abortRequested_.notify_all();
+    worker_.join();
+
+    std::error_code removeError;
+    std::filesystem::remove(outputPath_, removeError);
+}
+
+std::uint64_t StreamingCsvExporter::bytesWritten() const {
+    return bytesWritten_.load(std::memory_order_relaxed);
+}
+
+bool StreamingCsvExporter::waitForStage(int stageIndex) {
+    // Generation threads only set a flag; waking this thread once per stage
+    // would cost them far more than the stage itself on small maps. Polling
+    // every kPollInterval lets a sleeping exporter pick up a whole run of
+    // finished stages at once.
+    static constexpr std::chrono::milliseconds kPollInterval{1};
+
+    const std::atomic<std::uint8_t>& ready = readyStages_[static_cast<std::size_t>(stageIndex)];
+    while (ready.load(std::memory_order_acquire) == 0) {
+        std::unique_lock<std::mutex> lock(abortMutex_);
+        if (abortRequested_.wait_for(lock, kPollInterval, [this] { return aborted_.load(std::memory_order_relaxed); })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StreamingCsvExporter::runWorker(std::FILE* csvFile) {
+    // Wall time here includes waiting on the generator; CPU time does not.
+    TILE_METRICS_PHASE(Export);
+    CsvBlockWriter writer(csvFile);
+    writer.appendHeader(isMultiplayerMode_, masterSeed_);
+
+    // Rows must come out in stage order, so this follows the lowest stage that
+    // is not yet written even though the pool finishes stages out of order.
+    bool completed = true;
+    for (int stageIndex = 0; stageIndex < stages_->stageCount(); ++stageIndex) {
+        if (!waitForStage(stageIndex)) {
+            completed = false;
+            break;
+        }
+
+        if (rowIndex_ != nullptr) {
+            rowIndex_->rowOffsets.push_back(writer.fileOffset());
+        }
+        writer.appendStageRow(*stages_, stageIndex, isMultiplayerMode_, stageIndex + 1);
+        bytesWritten_.store(writer.bytesWritten(), std::memory_order_relaxed);
+    }
+    if (rowIndex_ != nullptr) {
+        rowIndex_->rowOffsets.push_back(writer.fileOffset());
+    }
+
+    const bool closed = closeCsvFile(csvFile, writer);
+    bytesWritten_.store(writer.bytesWritten(), std::memory_order_relaxed);
+    succeeded_ = completed && closed;
+    if (!succeeded_ && rowIndex_ != nullptr) {
+        rowIndex_->clear();
+    }
+}
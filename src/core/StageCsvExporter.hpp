@@ -0,0 +1,145 @@
+#pragma once
+
+#include "core/StageStore.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string normalizeExportTitle(const std::string& rawTitle);
+std::string getStageCsvFileName(bool isMultiplayerMode, const std::string& exportTitle);
+
+// Columns are joined with '^' and the cells of a column, top to bottom, with '#'.
+std::string serializeMapForCsv(const MapView& map);
+
+// Where every stage's row starts in a CSV an exporter wrote, so stages that
+// change afterwards can be rewritten in place (see rewriteStagesCsvRows).
+struct StageCsvRowIndex {
+    std::string outputPath;
+    bool isMultiplayerMode = false;
+    // File offset of each stage's row, then the file size: stageCount + 1
+    // entries. A stage without maps has no row and an empty range.
+    std::vector<std::uint64_t> rowOffsets;
+
+    bool empty() const {
+        return rowOffsets.empty();
+    }
+
+    void clear() {
+        outputPath.clear();
+        rowOffsets.clear();
+    }
+};
+
+// Writes "# master_seed=<seed>" followed by one row per stage to outputPath,
+// recording the row offsets in rowIndex when given.
+bool writeStagesCsv(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    StageCsvRowIndex* rowIndex = nullptr
+);
+
+// writeStagesCsv to getStageCsvFileName(...) in the working directory; the
+// chosen path is returned in outputPath.
+bool exportStagesToCsv(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& exportTitle,
+    std::string& outputPath,
+    StageCsvRowIndex* rowIndex = nullptr
+);
+
+// Overwrites the rows of stageIndices in the CSV described by rowIndex with
+// the current tiles of stages, touching only those rows. Regenerating a
+// stage keeps its numbers, only their order changes, so its row keeps its
+// length; if any row would change length, or the file no longer matches the
+// index, nothing is written and false is returned so the caller can write
+// the whole file instead.
+bool rewriteStagesCsvRows(
+    const StageStore& stages,
+    const std::vector<int>& stageIndices,
+    const StageCsvRowIndex& rowIndex
+);
+
+// Writes the same CSV as writeStagesCsv for a batch of stageCount stages that
+// is never resident at once: it asks fillWindow for windowStageCount stages
+// at a time and writes each window before asking for the next, so memory
+// depends on the window size only. A stopped export deletes the partial file.
+bool writeStagesCsvByWindow(
+    int stageCount,
+    int windowStageCount,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    const StageWindowFiller& fillWindow
+);
+
+// Writes the same CSV as writeStagesCsv while the stages are still being
+// generated. Generation threads call markStageReady as each stage finishes;
+// a dedicated thread appends rows strictly in stage order as soon as the next
+// stage is ready, so formatting and disk writes overlap with generation.
+// Output goes through one fixed 1 MiB block, so memory use does not grow with
+// the pack size.
+class StreamingCsvExporter {
+public:
+    StreamingCsvExporter() = default;
+    StreamingCsvExporter(const StreamingCsvExporter&) = delete;
+    StreamingCsvExporter& operator=(const StreamingCsvExporter&) = delete;
+
+    // Calls abort() if the export is still running.
+    ~StreamingCsvExporter();
+
+    // stages must stay alive (and must not be reset) until finish() or
+    // abort() returns. Returns false if outputPath cannot be opened. A
+    // rowIndex, when given, is filled by the export thread and is complete
+    // once finish() returns true.
+    bool start(
+        const StageStore& stages,
+        bool isMultiplayerMode,
+        std::uint64_t masterSeed,
+        const std::string& outputPath,
+        StageCsvRowIndex* rowIndex = nullptr
+    );
+
+    // Thread-safe. Publishes every tile write made to the stage before the call.
+    void markStageReady(int stageIndex);
+
+    // Blocks until every stage has been marked ready and written. Returns
+    // false if any write failed.
+    bool finish();
+
+    // Stops without waiting for the remaining stages and deletes the partial file.
+    void abort();
+
+    std::uint64_t bytesWritten() const;
+
+private:
+    bool waitForStage(int stageIndex);
+    void runWorker(std::FILE* csvFile);
+
+    const StageStore* stages_ = nullptr;
+    bool isMultiplayerMode_ = false;
+    std::uint64_t masterSeed_ = 0;
+    std::string outputPath_;
+    StageCsvRowIndex* rowIndex_ = nullptr;
+
+    std::unique_ptr<std::atomic<std::uint8_t>[]> readyStages_;
+    std::atomic<bool> aborted_{false};
+    std::mutex abortMutex_;
+    std::condition_variable abortRequested_;
+    std::atomic<std::uint64_t> bytesWritten_{0};
+
+    std::thread worker_;
+
+    // Written by the worker, read after it has been joined.
+    bool succeeded_ = false;
+};
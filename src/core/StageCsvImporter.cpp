@@ -0,0 +1,420 @@
+#include "core/StageCsvImporter.hpp"
+
+#include "core/GenerationMetrics.hpp"
+#include "core/MappedFile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <string_view>
+
+namespace {
+// Chunks smaller than this cost more in scheduling than they save in balance.
+constexpr std::size_t kMinChunkBytes = std::size_t{256} << 10;
+constexpr int kChunksPerWorker = 8;
+// Rows parsed between two progress reports and cancellation checks.
+constexpr int kRowsPerProgressStep = 4096;
+// Refuses first rows whose size would make the batch allocation absurd.
+constexpr std::uint64_t kMaxImportedMapTiles = std::uint64_t{1} << 24;
+
+const char* findLineEnd(const char* cursor, const char* end) {
+    if (cursor == end) {
+        return end;
+    }
+    const void* newline = std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor));
+    return newline != nullptr ? static_cast<const char*>(newline) : end;
+}
+
+// The line without its terminator, tolerating the "\r\n" of text-mode writers.
+std::string_view lineContent(const char* lineBegin, const char* lineEnd) {
+    if (lineEnd > lineBegin && lineEnd[-1] == '\r') {
+        --lineEnd;
+    }
+    return std::string_view(lineBegin, static_cast<std::size_t>(lineEnd - lineBegin));
+}
+
+bool parseNumber(const char*& cursor, const char* end, std::uint64_t maxValue, std::uint64_t& value) {
+    const std::from_chars_result parsed = std::from_chars(cursor, end, value);
+    if (parsed.ec != std::errc() || value > maxValue) {
+        return false;
+    }
+    cursor = parsed.ptr;
+    return true;
+}
+
+bool consume(const char*& cursor, const char* end, char expected) {
+    if (cursor == end || *cursor != expected) {
+        return false;
+    }
+    ++cursor;
+    return true;
+}
+
+struct RowHeader {
+    int stageNumber = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Reads "stage,width,height," and leaves cursor on the first map.
+bool parseRowHeader(const char*& cursor, const char* end, RowHeader& header) {
+    std::uint64_t stageNumber = 0;
+    std::uint64_t width = 0;
+    std::uint64_t height = 0;
+    if (!parseNumber(cursor, end, INT_MAX, stageNumber) || !consume(cursor, end, ',') ||
+        !parseNumber(cursor, end, static_cast<std::uint64_t>(kMaxMapWidth), width) || !consume(cursor, end, ',') ||
+        !parseNumber(cursor, end, INT_MAX, height) || !consume(cursor, end, ',')) {
+        return false;
+    }
+
+    header.stageNumber = static_cast<int>(stageNumber);
+    header.width = static_cast<int>(width);
+    header.height = static_cast<int>(height);
+    return true;
+}
+
+// Reads one map in the column-major '^' / '#' encoding into row-major tiles,
+// each at most maxTile (0xFF or 0xFFFF). Returns an error message, or nullptr
+// on success.
+const char* parseMap(const char*& cursor, const char* end, int width, int height, std::uint64_t maxTile, Tile* tiles) {
+    for (int col = 0; col < width; ++col) {
+        if (col > 0 && !consume(cursor, end, '^')) {
+            return "expected '^' between the columns of a map";
+        }
+
+        for (int row = 0; row < height; ++row) {
+            if (row > 0 && !consume(cursor, end, '#')) {
+                return "expected '#' between the cells of a column";
+            }
+
+            std::uint64_t tile = 0;
+            if (!parseNumber(cursor, end, maxTile, tile)) {
+                return maxTile == 0xFF ? "expected a tile number from 0 to 255 for this map size"
+                                       : "expected a tile number from 0 to 65535";
+            }
+            tiles[static_cast<std::size_t>(row) * width + col] = static_cast<Tile>(tile);
+        }
+    }
+    return nullptr;
+}
+
+struct ChunkBounds {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::uint64_t lineCount = 0;
+    int rowCount = 0;
+};
+
+struct ChunkResult {
+    std::uint64_t violatingMapCount = 0;
+    std::uint64_t violationCount = 0;
+    std::uint64_t parseErrorCount = 0;
+    std::vector<StageCellViolation> violations;
+    std::vector<StageCsvParseError> parseErrors;
+};
+
+void addParseError(ChunkResult& result, std::size_t maxReported, std::uint64_t lineNumber, std::string message) {
+    ++result.parseErrorCount;
+    if (result.parseErrors.size() < maxReported) {
+        result.parseErrors.push_back({lineNumber, std::move(message)});
+    }
+}
+
+void collectViolations(
+    ChunkResult& result,
+    std::size_t maxReported,
+    const Tile* stageTiles,
+    int stageNumber,
+    int mapCount,
+    int width,
+    int height
+) {
+    const std::size_t mapTileCount = static_cast<std::size_t>(width) * height;
+
+    for (int mapIndex = 0; mapIndex < mapCount; ++mapIndex) {
+        const Tile* tiles = stageTiles + mapIndex * mapTileCount;
+        if (!hasVerticalMatchingTiles(MapView{width, height, tiles})) {
+            continue;
+        }
+
+        ++result.violatingMapCount;
+        for (int row = 0; row + 1 < height; ++row) {
+            for (int col = 0; col < width; ++col) {
+                const std::size_t tileIndex = static_cast<std::size_t>(row) * width + col;
+                if (tiles[tileIndex] != tiles[tileIndex + width]) {
+                    continue;
+                }
+
+                ++result.violationCount;
+                if (result.violations.size() < maxReported) {
+                    result.violations.push_back({stageNumber, mapIndex + 1, row + 1, col + 1, tiles[tileIndex]});
+                }
+            }
+        }
+    }
+}
+
+std::string describeMapSize(int width, int height) {
+    return std::to_string(width) + "x" + std::to_string(height);
+}
+} // namespace
+
+StageCsvImportResult importStagesCsv(
+    const std::string& path,
+    WorkStealingPool& pool,
+    const StageCsvImportOptions& options,
+    const GenerationControl& control
+) {
+    TILE_METRICS_PHASE(Import);
+    StageCsvImportResult result;
+
+    MappedFile file;
+    if (!file.open(path, result.error)) {
+        return result;
+    }
+    result.fileBytes = file.size();
+    TILE_METRICS_COUNT(BytesRead, file.size());
+
+    const char* const fileBegin = reinterpret_cast<const char*>(file.data());
+    const char* const fileEnd = fileBegin + file.size();
+    const char* cursor = fileBegin;
+    if (file.size() >= 3 && std::memcmp(cursor, "\xEF\xBB\xBF", 3) == 0) {
+        cursor += 3;
+    }
+
+    // "# ..." comment lines, of which "# master_seed=N" is the one we know.
+    std::uint64_t headerLineCount = 0;
+    while (cursor < fileEnd && *cursor == '#') {
+        const char* lineEnd = findLineEnd(cursor, fileEnd);
+        const std::string_view line = lineContent(cursor, lineEnd);
+        constexpr std::string_view kSeedPrefix = "# master_seed=";
+        if (line.substr(0, kSeedPrefix.size()) == kSeedPrefix) {
+            const char* seedBegin = line.data() + kSeedPrefix.size();
+            const char* seedEnd = line.data() + line.size();
+            result.hasMasterSeed = std::from_chars(seedBegin, seedEnd, result.masterSeed).ptr == seedEnd;
+        }
+        ++headerLineCount;
+        cursor = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+    }
+
+    {
+        const char* lineEnd = findLineEnd(cursor, fileEnd);
+        const std::string_view line = lineContent(cursor, lineEnd);
+        if (line.substr(0, 6) != "stage,") {
+            result.error = "missing the stage,width,height,map header on line " + std::to_string(headerLineCount + 1);
+            return result;
+        }
+        result.isMultiplayerMode = line.find(",map2") != std::string_view::npos;
+        ++headerLineCount;
+        cursor = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+    }
+    const char* const bodyBegin = cursor;
+    const int mapCount = getMapCountPerStage(result.isMultiplayerMode);
+
+    // The first data row fixes the map size of the whole batch.
+    for (const char* lineBegin = bodyBegin; lineBegin < fileEnd;) {
+        const char* lineEnd = findLineEnd(lineBegin, fileEnd);
+        const std::string_view line = lineContent(lineBegin, lineEnd);
+        if (!line.empty()) {
+            const char* fieldCursor = line.data();
+            RowHeader header;
+            if (!parseRowHeader(fieldCursor, line.data() + line.size(), header) ||
+                header.width <= 0 || header.height <= 0 ||
+                static_cast<std::uint64_t>(header.width) * header.height > kMaxImportedMapTiles) {
+                result.error = "the first stage row has no valid width and height";
+                return result;
+            }
+            result.mapWidth = header.width;
+            result.mapHeight = header.height;
+            break;
+        }
+        lineBegin = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+    }
+
+    // Split the body at line boundaries, then count lines and rows per chunk
+    // so that every chunk knows its first stage index and line number.
+    const std::size_t bodyBytes = static_cast<std::size_t>(fileEnd - bodyBegin);
+    const int chunkCount = static_cast<int>(std::clamp<std::size_t>(
+        bodyBytes / kMinChunkBytes,
+        1,
+        static_cast<std::size_t>(pool.threadCount() * kChunksPerWorker)
+    ));
+
+    std::vector<ChunkBounds> chunks(static_cast<std::size_t>(chunkCount));
+    const char* chunkBegin = bodyBegin;
+    for (int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+        const char* chunkEnd = fileEnd;
+        if (chunkIndex + 1 < chunkCount) {
+            const char* split = bodyBegin + bodyBytes / chunkCount * (chunkIndex + 1);
+            split = std::max(split, chunkBegin);
+            chunkEnd = std::min(fileEnd, findLineEnd(split, fileEnd) + 1);
+        }
+        chunks[static_cast<std::size_t>(chunkIndex)].begin = chunkBegin;
+        chunks[static_cast<std::size_t>(chunkIndex)].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    pool.parallelFor(chunkCount, [&](int chunkIndex) {
+        ChunkBounds& chunk = chunks[static_cast<std::size_t>(chunkIndex)];
+        for (const char* lineBegin = chunk.begin; lineBegin < chunk.end;) {
+            const char* lineEnd = findLineEnd(lineBegin, chunk.end);
+            ++chunk.lineCount;
+            if (!lineContent(lineBegin, lineEnd).empty()) {
+                ++chunk.rowCount;
+            }
+            lineBegin = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+        }
+    });
+
+    std::vector<int> firstRowIndices(static_cast<std::size_t>(chunkCount));
+    std::vector<std::uint64_t> firstLineNumbers(static_cast<std::size_t>(chunkCount));
+    std::int64_t rowCount = 0;
+    std::uint64_t lineNumber = headerLineCount + 1;
+    for (int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+        firstRowIndices[static_cast<std::size_t>(chunkIndex)] = static_cast<int>(std::min<std::int64_t>(rowCount, INT_MAX));
+        firstLineNumbers[static_cast<std::size_t>(chunkIndex)] = lineNumber;
+        rowCount += chunks[static_cast<std::size_t>(chunkIndex)].rowCount;
+        lineNumber += chunks[static_cast<std::size_t>(chunkIndex)].lineCount;
+    }
+    if (rowCount > INT_MAX) {
+        result.error = "the file holds more stages than a batch can";
+        return result;
+    }
+
+    result.opened = true;
+    result.stageCount = static_cast<int>(rowCount);
+    if (result.stageCount == 0) {
+        return result;
+    }
+    if (options.onStageCountKnown) {
+        options.onStageCountKnown(result.stageCount);
+    }
+    if (options.keepStages) {
+        result.stages.reset(result.stageCount, mapCount, result.mapWidth, result.mapHeight);
+    }
+
+    const int mapWidth = result.mapWidth;
+    const int mapHeight = result.mapHeight;
+    const std::size_t mapTileCount = static_cast<std::size_t>(mapWidth) * mapHeight;
+    // A batch kept one byte per tile has no room for larger numbers, which no
+    // shuffle of its layout holds anyway.
+    const std::uint64_t maxTile = options.keepStages && result.stages.tileBytes() == 1 ? 0xFF : 0xFFFF;
+    const std::size_t maxReported = options.maxReportedIssues;
+    std::vector<ChunkResult> chunkResults(static_cast<std::size_t>(chunkCount));
+    std::atomic<int> parsedStageCount{0};
+
+    pool.parallelFor(chunkCount, [&](int chunkIndex) {
+        const ChunkBounds& chunk = chunks[static_cast<std::size_t>(chunkIndex)];
+        ChunkResult& chunkResult = chunkResults[static_cast<std::size_t>(chunkIndex)];
+        std::vector<Tile> stageTiles(mapTileCount * mapCount);
+
+        int rowIndex = firstRowIndices[static_cast<std::size_t>(chunkIndex)];
+        std::uint64_t currentLine = firstLineNumbers[static_cast<std::size_t>(chunkIndex)];
+        int rowsSinceReport = 0;
+
+        for (const char* lineBegin = chunk.begin; lineBegin < chunk.end; ++currentLine) {
+            const char* lineEnd = findLineEnd(lineBegin, chunk.end);
+            const std::string_view line = lineContent(lineBegin, lineEnd);
+            lineBegin = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+            if (line.empty()) {
+                continue;
+            }
+
+            const char* fieldCursor = line.data();
+            const char* const fieldEnd = line.data() + line.size();
+            RowHeader header;
+            const char* error = nullptr;
+            if (!parseRowHeader(fieldCursor, fieldEnd, header)) {
+                error = "expected stage,width,height before the maps";
+            } else if (header.width != mapWidth || header.height != mapHeight) {
+                addParseError(
+                    chunkResult,
+                    maxReported,
+                    currentLine,
+                    "stage " + std::to_string(header.stageNumber) + " is " + describeMapSize(header.width, header.height) +
+                        " but the batch is " + describeMapSize(mapWidth, mapHeight)
+                );
+            } else {
+                for (int mapIndex = 0; mapIndex < mapCount && error == nullptr; ++mapIndex) {
+                    if (mapIndex > 0 && !consume(fieldCursor, fieldEnd, ',')) {
+                        error = "expected a map2 column";
+                        break;
+                    }
+                    Tile* mapTiles = stageTiles.data() + mapIndex * mapTileCount;
+                    error = parseMap(fieldCursor, fieldEnd, mapWidth, mapHeight, maxTile, mapTiles);
+                }
+                if (error == nullptr && fieldCursor != fieldEnd) {
+                    error = "unexpected text after the last map";
+                }
+
+                if (error == nullptr) {
+                    if (options.keepStages) {
+                        result.stages.writeStageTiles(rowIndex, stageTiles.data());
+                    }
+                    collectViolations(
+                        chunkResult,
+                        maxReported,
+                        stageTiles.data(),
+                        header.stageNumber,
+                        mapCount,
+                        mapWidth,
+                        mapHeight
+                    );
+                }
+            }
+
+            if (error != nullptr) {
+                addParseError(chunkResult, maxReported, currentLine, error);
+            }
+            ++rowIndex;
+
+            if (++rowsSinceReport == kRowsPerProgressStep) {
+                if (control.isCancelled()) {
+                    return;
+                }
+                const int parsed = parsedStageCount.fetch_add(rowsSinceReport, std::memory_order_relaxed) + rowsSinceReport;
+                if (control.onStageCompleted) {
+                    control.onStageCompleted(parsed);
+                }
+                rowsSinceReport = 0;
+            }
+        }
+
+        const int parsed = parsedStageCount.fetch_add(rowsSinceReport, std::memory_order_relaxed) + rowsSinceReport;
+        if (control.onStageCompleted) {
+            control.onStageCompleted(parsed);
+        }
+    });
+
+    if (control.isCancelled()) {
+        result.cancelled = true;
+        result.stages.clear();
+        return result;
+    }
+
+    for (ChunkResult& chunkResult : chunkResults) {
+        result.violatingMapCount += chunkResult.violatingMapCount;
+        result.violationCount += chunkResult.violationCount;
+        result.parseErrorCount += chunkResult.parseErrorCount;
+
+        const std::size_t violationRoom = maxReported - result.violations.size();
+        result.violations.insert(
+            result.violations.end(),
+            chunkResult.violations.begin(),
+            chunkResult.violations.begin() + static_cast<std::ptrdiff_t>(std::min(violationRoom, chunkResult.violations.size()))
+        );
+
+        const std::size_t errorRoom = maxReported - result.parseErrors.size();
+        const auto errorsBegin = chunkResult.parseErrors.begin();
+        const auto errorsEnd = errorsBegin + static_cast<std::ptrdiff_t>(std::min(errorRoom, chunkResult.parseErrors.size()));
+        result.parseErrors.insert(
+            result.parseErrors.end(),
+            std::make_move_iterator(errorsBegin),
+            std::make_move_iterator(errorsEnd)
+        );
+    }
+
+    return result;
+}
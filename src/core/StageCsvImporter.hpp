@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/StageGenerator.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Two vertically adjacent cells holding the same number.
+struct StageCellViolation {
+    int stageNumber = 0;  // as written in the stage column
+    int mapNumber = 0;    // 1 or 2
+    int row = 0;          // 1-based row of the upper cell
+    int column = 0;       // 1-based
+    int tile = 0;
+};
+
+struct StageCsvParseError {
+    std::uint64_t lineNumber = 0;  // 1-based line of the file
+    std::string message;
+};
+
+struct StageCsvImportOptions {
+    // Rebuild the stages into the result; validation alone does not need them.
+    bool keepStages = true;
+    // Caps each of the violation and parse error lists; the counts are exact.
+    std::size_t maxReportedIssues = 1000;
+    // Called once the rows have been counted, before any of them is parsed.
+    std::function<void(int stageCount)> onStageCountKnown;
+};
+
+struct StageCsvImportResult {
+    // False when the file could not be read at all (see error); row-level
+    // problems are reported in parseErrors instead.
+    bool opened = false;
+    bool cancelled = false;
+    std::string error;
+
+    bool isMultiplayerMode = false;
+    bool hasMasterSeed = false;
+    std::uint64_t masterSeed = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    std::uint64_t fileBytes = 0;
+
+    // One stage per data row, in file order. Rows that failed to parse keep
+    // the initial layout. Empty unless keepStages was set.
+    StageStore stages;
+    int stageCount = 0;
+
+    std::uint64_t violatingMapCount = 0;
+    std::uint64_t violationCount = 0;
+    std::uint64_t parseErrorCount = 0;
+    // The first maxReportedIssues of each, in file order.
+    std::vector<StageCellViolation> violations;
+    std::vector<StageCsvParseError> parseErrors;
+};
+
+// Reads a CSV written by writeStagesCsv back through a memory mapping. The
+// rows are split into chunks at line boundaries and parsed on the pool, and
+// every map is checked with hasVerticalMatchingTiles; violating maps are
+// scanned again to report each offending cell. Every data row must use the
+// map size of the first one, since a batch is stored as one StageStore.
+// control.onStageCompleted reports parsed rows from the pool threads.
+StageCsvImportResult importStagesCsv(
+    const std::string& path,
+    WorkStealingPool& pool,
+    const StageCsvImportOptions& options = {},
+    const GenerationControl& control = {}
+);
@@ -0,0 +1,85 @@
+#include "core/StageFingerprint.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+constexpr std::uint64_t kFingerprintSalt = 0xD1B5'4A32'D192'ED03ull;
+constexpr std::size_t kMinSlotCount = 64;
+
+// The splitmix64 finalizer, kept local so the per-cell loop inlines it.
+inline std::uint64_t getCellKey(std::size_t cellIndex, Tile tile) {
+    std::uint64_t key = kFingerprintSalt ^ (static_cast<std::uint64_t>(cellIndex) << 16 | tile);
+    key = (key ^ (key >> 30)) * 0xBF58'476D'1CE4'E5B9ull;
+    key = (key ^ (key >> 27)) * 0x94D0'49BB'1331'11EBull;
+    return key ^ (key >> 31);
+}
+
+std::size_t getSlotCount(std::size_t expectedCount) {
+    return std::bit_ceil(std::max(kMinSlotCount, expectedCount * 2));
+}
+
+template <typename TileT>
+std::uint64_t computeFingerprint(const TileT* stageTiles, std::size_t tileCount) {
+    std::uint64_t fingerprint = 0;
+    for (std::size_t cellIndex = 0; cellIndex < tileCount; ++cellIndex) {
+        fingerprint ^= getCellKey(cellIndex, stageTiles[cellIndex]);
+    }
+    return fingerprint;
+}
+} // namespace
+
+std::uint64_t computeStageFingerprint(const Tile* stageTiles, std::size_t tileCount) {
+    return computeFingerprint(stageTiles, tileCount);
+}
+
+std::uint64_t computeStageFingerprint(const NarrowTile* stageTiles, std::size_t tileCount) {
+    return computeFingerprint(stageTiles, tileCount);
+}
+
+StageFingerprintSet::StageFingerprintSet(int expectedCount) {
+    const std::size_t slotCount = getSlotCount(static_cast<std::size_t>(std::max(0, expectedCount)));
+    slots_ = std::make_unique<std::uint64_t[]>(slotCount);
+    mask_ = slotCount - 1;
+}
+
+bool StageFingerprintSet::insert(std::uint64_t fingerprint) {
+    if (fingerprint == 0) {
+        fingerprint = kZeroFingerprint;
+    }
+    // Keeps the load factor at or below one half.
+    if (static_cast<std::size_t>(size_ + 1) * 2 > mask_ + 1) {
+        grow();
+    }
+
+    // Fingerprints are already well mixed, so their low bits index directly.
+    for (std::size_t slot = fingerprint & mask_;; slot = (slot + 1) & mask_) {
+        if (slots_[slot] == fingerprint) {
+            return false;
+        }
+        if (slots_[slot] == 0) {
+            slots_[slot] = fingerprint;
+            ++size_;
+            return true;
+        }
+    }
+}
+
+void StageFingerprintSet::grow() {
+    const std::size_t oldSlotCount = mask_ + 1;
+    std::unique_ptr<std::uint64_t[]> oldSlots = std::move(slots_);
+
+    slots_ = std::make_unique<std::uint64_t[]>(oldSlotCount * 2);
+    mask_ = oldSlotCount * 2 - 1;
+    for (std::size_t oldSlot = 0; oldSlot < oldSlotCount; ++oldSlot) {
+        const std::uint64_t fingerprint = oldSlots[oldSlot];
+        if (fingerprint == 0) {
+            continue;
+        }
+        std::size_t slot = fingerprint & mask_;
+        while (slots_[slot] != 0) {
+            slot = (slot + 1) & mask_;
+        }
+        slots_[slot] = fingerprint;
+    }
+}
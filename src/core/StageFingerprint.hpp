@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/StageStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Zobrist-style hash of a stage: the XOR of one 64-bit key per (cell, tile)
+// pair, so equal stages always collide and a swap of two cells would change
+// it by four keys. Keys come from the splitmix64 finalizer rather than a table, since tile
+// numbers span 16 bits. Keys depend only on the tile values, so a stage
+// fingerprints the same whether it is stored as Tile or NarrowTile.
+std::uint64_t computeStageFingerprint(const Tile* stageTiles, std::size_t tileCount);
+std::uint64_t computeStageFingerprint(const NarrowTile* stageTiles, std::size_t tileCount);
+
+// Open-addressing (linear probing) set of stage fingerprints. The table is a
+// power of two at least twice the expected count, allocated once, so an
+// insert is a couple of probes into a flat array. Only the 8-byte
+// fingerprints are kept; two distinct stages of a ten-million-stage batch
+// share one with a probability around 3e-6.
+class StageFingerprintSet {
+public:
+    explicit StageFingerprintSet(int expectedCount = 0);
+
+    // Returns false if fingerprint was already present.
+    bool insert(std::uint64_t fingerprint);
+
+    int size() const {
+        return size_;
+    }
+
+    std::size_t memoryUsageBytes() const {
+        return (mask_ + 1) * sizeof(std::uint64_t);
+    }
+
+private:
+    // 0 marks an empty slot, so a real 0 fingerprint is stored as this.
+    static constexpr std::uint64_t kZeroFingerprint = 0x9E37'79B9'7F4A'7C15ull;
+
+    void grow();
+
+    std::unique_ptr<std::uint64_t[]> slots_;
+    std::size_t mask_ = 0;
+    int size_ = 0;
+};
@@ -0,0 +1,1280 @@
+#include "core/StageGenerator.hpp"
+
+#include "core/GenerationMetrics.hpp"
+#include "core/StageRandom.hpp"
+#include "core/VerticalMatchValidator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+// Counterpart of the Arrangements* metrics for GenerationControl::arrangementOutcomes.
+void recordArrangementOutcome(const GenerationControl& control, std::atomic<std::uint64_t> ArrangementOutcomeCounts::*outcome) {
+    if (control.arrangementOutcomes != nullptr) {
+        (control.arrangementOutcomes->*outcome).fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template <typename Rng>
+std::uint32_t nextRandom32(Rng& rng) {
+    static_assert(Rng::min() == 0, "Expected a full-range generator");
+    if constexpr (Rng::max() == 0xFFFFFFFFull) {
+        return static_cast<std::uint32_t>(rng());
+    } else {
+        // The high bits of xoshiro256** are the strongest.
+        return static_cast<std::uint32_t>(rng() >> 32);
+    }
+}
+
+// Lemire, "Fast Random Integer Generation in an Interval" (2019): a uniform
+// value in [0, range) from one multiply, with a division only on the rare
+// rejection path.
+template <typename Rng>
+std::uint32_t boundedRandom(Rng& rng, std::uint32_t range) {
+    std::uint64_t product = static_cast<std::uint64_t>(nextRandom32(rng)) * range;
+    std::uint32_t low = static_cast<std::uint32_t>(product);
+    if (low < range) {
+        const std::uint32_t threshold = static_cast<std::uint32_t>(-range) % range;
+        while (low < threshold) {
+            product = static_cast<std::uint64_t>(nextRandom32(rng)) * range;
+            low = static_cast<std::uint32_t>(product);
+        }
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+}
+
+template <typename TileT, typename Rng>
+void shuffleTiles(
+    TileT* tiles,
+    std::size_t tileCount,
+    const ShuffleSettings& shuffleSettings,
+    Rng& rng,
+    const GenerationControl& control
+) {
+    TILE_METRICS_SAMPLED_PHASE(Shuffle);
+    if (shuffleSettings.kernel == ShuffleKernel::LegacyExact) {
+        for (int shuffleIndex = 0; shuffleIndex < shuffleSettings.shuffleCount && !control.isCancelled(); ++shuffleIndex) {
+            std::shuffle(tiles, tiles + tileCount, rng);
+        }
+        return;
+    }
+
+    for (std::size_t index = tileCount; index > 1; --index) {
+        const std::uint32_t swapIndex = boundedRandom(rng, static_cast<std::uint32_t>(index));
+        std::swap(tiles[index - 1], tiles[swapIndex]);
+    }
+}
+
+// A uniform value in [0, 1) with the 53 bits a double holds.
+template <typename Rng>
+double unitRandom(Rng& rng) {
+    const std::uint64_t high = nextRandom32(rng);
+    const std::uint64_t low = nextRandom32(rng);
+    return static_cast<double>((high << 21) | (low >> 11)) * 0x1.0p-53;
+}
+
+// Layouts of up to this many tiles are counted exactly, for
+// countDistinctStageArrangements and for sampleUniformArrangement.
+constexpr int kMaxCountedTiles = 64;
+
+// Column-major placements of tileCount tiles in columns of mapHeight, counted
+// by memoized search. Numbers with the same remaining count are
+// interchangeable, so a state is the sorted remaining counts plus the
+// remaining count of the number just placed above the next cell. Every state
+// keeps its transitions, one per run of equal counts a number can be taken
+// from, so sampling walks them without hashing. Counts are doubles: exact
+// below 2^53 and, above that, rounded far below anything sampling could
+// measure.
+class ArrangementCounter {
+public:
+    static constexpr std::int32_t kCompleteState = 0;
+    static constexpr std::int32_t kGaveUp = -1;
+
+    struct Transition {
+        // The run's choices times the ways of nextState.
+        double ways = 0.0;
+        std::int32_t nextState = kGaveUp;
+    };
+
+    struct State {
+        double ways = 0.0;
+        std::uint32_t firstTransition = 0;
+        std::uint32_t transitionCount = 0;
+    };
+
+    ArrangementCounter(int mapHeight, int tileCount)
+        : mapHeight_(mapHeight),
+          tileCount_(tileCount) {
+        states_.push_back(State{1.0, 0, 0});
+    }
+
+    // Index of the state after placedCount tiles, counted along with every
+    // state reachable from it, or kGaveUp once that takes too many states.
+    // counts is sorted in descending order and left as it was.
+    std::int32_t find(std::vector<std::uint8_t>& counts, int aboveCount, int placedCount) {
+        if (placedCount == tileCount_) {
+            return kCompleteState;
+        }
+        if (gaveUp_) {
+            return kGaveUp;
+        }
+
+        const StateKey key = makeKey(counts, aboveCount);
+        if (const auto found = index_.find(key); found != index_.end()) {
+            return found->second;
+        }
+        if (states_.size() >= kMaxStates) {
+            gaveUp_ = true;
+            return kGaveUp;
+        }
+
+        std::array<Transition, kMaxRuns> transitions;
+        std::size_t transitionCount = 0;
+        double total = 0.0;
+        // Walk each run of equal values.
+        for (std::size_t runBegin = 0; runBegin < counts.size();) {
+            const int value = counts[runBegin];
+            std::size_t runEnd = runBegin;
+            while (runEnd < counts.size() && counts[runEnd] == value) {
+                ++runEnd;
+            }
+            if (value == 0) {
+                break;
+            }
+
+            const std::size_t choices = (runEnd - runBegin) - (value == aboveCount ? 1 : 0);
+            if (choices > 0) {
+                // Lowering the last of the run keeps the order.
+                --counts[runEnd - 1];
+                const std::int32_t nextState = find(counts, aboveCountAfter(value, placedCount), placedCount + 1);
+                ++counts[runEnd - 1];
+                if (nextState == kGaveUp) {
+                    return kGaveUp;
+                }
+
+                const double ways = static_cast<double>(choices) * states_[static_cast<std::size_t>(nextState)].ways;
+                transitions[transitionCount++] = Transition{ways, nextState};
+                total += ways;
+            }
+            runBegin = runEnd;
+        }
+
+        const auto stateIndex = static_cast<std::int32_t>(states_.size());
+        states_.push_back(State{
+            total,
+            static_cast<std::uint32_t>(transitions_.size()),
+            static_cast<std::uint32_t>(transitionCount),
+        });
+        transitions_.insert(transitions_.end(), transitions.begin(), transitions.begin() + transitionCount);
+        index_.emplace(key, stateIndex);
+        return stateIndex;
+    }
+
+    const State& state(std::int32_t stateIndex) const {
+        return states_[static_cast<std::size_t>(stateIndex)];
+    }
+
+    const Transition& transition(const State& state, std::size_t transitionIndex) const {
+        return transitions_[state.firstTransition + transitionIndex];
+    }
+
+    // aboveCount of the next cell once a number with value copies left is
+    // placed at cell placedCount.
+    int aboveCountAfter(int value, int placedCount) const {
+        const bool nextStartsColumn = (placedCount + 1) % mapHeight_ == 0;
+        return nextStartsColumn || value == 1 ? -1 : value - 1;
+    }
+
+    bool isFor(int mapHeight, int tileCount) const {
+        return mapHeight == mapHeight_ && tileCount == tileCount_;
+    }
+
+    bool gaveUp() const {
+        return gaveUp_;
+    }
+
+private:
+    static constexpr std::size_t kMaxStates = std::size_t{1} << 18;
+    // At most 10 distinct positive counts add up to kMaxCountedTiles or less.
+    static constexpr std::size_t kMaxRuns = 10;
+
+    // The nonzero counts in unary, each as its drop from the previous one
+    // (starting at kMaxCountedTiles) in zero bits and a closing one bit. Counts
+    // add up to at most kMaxCountedTiles, so this takes at most 127 bits.
+    struct StateKey {
+        std::array<std::uint64_t, 2> bits{};
+        int aboveCount = -1;
+
+        bool operator==(const StateKey&) const = default;
+    };
+
+    struct StateKeyHash {
+        std::size_t operator()(const StateKey& key) const {
+            return static_cast<std::size_t>(
+                splitMix64(key.bits[0] ^ splitMix64(key.bits[1] ^ static_cast<std::uint64_t>(key.aboveCount + 1)))
+            );
+        }
+    };
+
+    static StateKey makeKey(const std::vector<std::uint8_t>& counts, int aboveCount) {
+        StateKey key;
+        key.aboveCount = aboveCount;
+        int bit = 0;
+        int previous = kMaxCountedTiles;
+        for (const std::uint8_t count : counts) {
+            if (count == 0) {
+                break;
+            }
+            bit += previous - count;
+            key.bits[static_cast<std::size_t>(bit / 64)] |= std::uint64_t{1} << (bit % 64);
+            ++bit;
+            previous = count;
+        }
+        return key;
+    }
+
+    int mapHeight_;
+    int tileCount_;
+    bool gaveUp_ = false;
+    // states_[kCompleteState] is the filled stage.
+    std::vector<State> states_;
+    std::vector<Transition> transitions_;
+    std::unordered_map<StateKey, std::int32_t, StateKeyHash> index_;
+};
+
+// Working memory for arranging one stage. Each generation thread keeps its
+// own instance alive across stages, so after the first few stages the hot
+// loop no longer touches the heap.
+struct GenerationScratch {
+    std::vector<int> conflictingTiles;
+    std::vector<Tile> tilePool;
+    std::vector<int> remainingCount;
+    std::vector<int> numbersWithCount;
+    // Counter of the last layout sampled on this thread; a batch keeps one
+    // size, so its memo is built once per thread.
+    std::unique_ptr<ArrangementCounter> arrangementCounter;
+    std::vector<std::uint8_t> sampledCounts;
+    std::vector<Tile> sampledNumbers;
+};
+
+GenerationScratch& getThreadGenerationScratch() {
+    thread_local GenerationScratch scratch;
+    return scratch;
+}
+
+// Tiles of one or more maps stacked in a single row-major buffer. Vertical
+// neighbours are only compared inside the same map, never across map seams.
+// TileT is whichever width the stage is stored in, Tile or NarrowTile.
+template <typename TileT>
+bool hasVerticalMatchAt(const TileT* tiles, int mapWidth, int mapHeight, int tileIndex) {
+    const int rowInMap = (tileIndex / mapWidth) % mapHeight;
+    const TileT tile = tiles[tileIndex];
+
+    if (rowInMap > 0 && tiles[tileIndex - mapWidth] == tile) {
+        return true;
+    }
+    if (rowInMap + 1 < mapHeight && tiles[tileIndex + mapWidth] == tile) {
+        return true;
+    }
+    return false;
+}
+
+template <typename TileT>
+bool hasVerticalMatchInStackedMaps(const TileT* tiles, int tileCount, int mapWidth, int mapHeight) {
+    if (mapWidth <= 0 || mapHeight <= 1) {
+        return false;
+    }
+    const int mapTileCount = mapWidth * mapHeight;
+    for (int mapStart = 0; mapStart < tileCount; mapStart += mapTileCount) {
+        if (hasVerticalMatch(tiles + mapStart, mapWidth, mapHeight)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Draws one of the arrangements without vertical matches uniformly at random,
+// cell by cell in the placer's column-major order: each number is taken with
+// probability proportional to the number of ways the rest of the stage can
+// still be completed after it, as counted by ArrangementCounter. Returns false,
+// with the tiles untouched, for layouts of more than kMaxCountedTiles tiles,
+// layouts whose count gave up, and layouts with no valid arrangement.
+template <typename TileT, typename Rng>
+bool sampleUniformArrangement(TileT* tiles, int tileCount, int mapWidth, int mapHeight, Rng& rng, GenerationScratch& scratch) {
+    if (tileCount > kMaxCountedTiles || mapWidth <= 0 || mapHeight <= 0) {
+        return false;
+    }
+
+    std::unique_ptr<ArrangementCounter>& counter = scratch.arrangementCounter;
+    if (counter == nullptr || !counter->isFor(mapHeight, tileCount)) {
+        counter = std::make_unique<ArrangementCounter>(mapHeight, tileCount);
+    }
+    if (counter->gaveUp()) {
+        return false;
+    }
+
+    // Distinct numbers in descending order of their remaining count, with
+    // those counts alongside, as the counter expects them.
+    std::vector<Tile>& numbers = scratch.sampledNumbers;
+    std::vector<std::uint8_t>& counts = scratch.sampledCounts;
+    std::vector<Tile>& sortedTiles = scratch.tilePool;
+    sortedTiles.assign(tiles, tiles + tileCount);
+    std::sort(sortedTiles.begin(), sortedTiles.end());
+    numbers.clear();
+    counts.clear();
+    for (std::size_t runBegin = 0; runBegin < sortedTiles.size();) {
+        std::size_t runEnd = runBegin;
+        while (runEnd < sortedTiles.size() && sortedTiles[runEnd] == sortedTiles[runBegin]) {
+            ++runEnd;
+        }
+        numbers.push_back(sortedTiles[runBegin]);
+        counts.push_back(static_cast<std::uint8_t>(runEnd - runBegin));
+        runBegin = runEnd;
+    }
+    for (std::size_t index = 1; index < counts.size(); ++index) {
+        for (std::size_t sorted = index; sorted > 0 && counts[sorted - 1] < counts[sorted]; --sorted) {
+            std::swap(counts[sorted - 1], counts[sorted]);
+            std::swap(numbers[sorted - 1], numbers[sorted]);
+        }
+    }
+
+    std::int32_t stateIndex = counter->find(counts, -1, 0);
+    if (stateIndex == ArrangementCounter::kGaveUp || counter->state(stateIndex).ways <= 0.0) {
+        return false;
+    }
+
+    const int mapTileCount = mapWidth * mapHeight;
+    int aboveCount = -1;
+    std::size_t abovePosition = 0;
+    for (int placedCount = 0; placedCount < tileCount; ++placedCount) {
+        // The state's transitions follow the runs of counts that hold a
+        // choice, in order. Every number of a run completes the stage the
+        // same number of ways; the one above the cell is not a choice.
+        const ArrangementCounter::State& state = counter->state(stateIndex);
+        std::array<std::size_t, kMaxCountedTiles> runEnds;
+        std::array<std::size_t, kMaxCountedTiles> runChoices;
+        std::size_t runCount = 0;
+        std::size_t candidateCount = 0;
+        for (std::size_t runBegin = 0; runBegin < counts.size();) {
+            const int value = counts[runBegin];
+            std::size_t runEnd = runBegin;
+            while (runEnd < counts.size() && counts[runEnd] == value) {
+                ++runEnd;
+            }
+            if (value == 0) {
+                break;
+            }
+
+            const std::size_t choices = (runEnd - runBegin) - (value == aboveCount ? 1 : 0);
+            if (choices > 0) {
+                if (counter->transition(state, runCount).ways > 0.0) {
+                    candidateCount += choices;
+                }
+                runEnds[runCount] = runEnd;
+                runChoices[runCount++] = choices;
+            }
+            runBegin = runEnd;
+        }
+
+        // Forced cells draw nothing. Otherwise one draw picks the run, and
+        // where it fell inside the run picks the number; the last run that
+        // can be completed absorbs any rounding.
+        double target = candidateCount > 1 ? unitRandom(rng) * state.ways : 0.0;
+        std::size_t chosenRun = runCount;
+        for (std::size_t run = 0; run < runCount; ++run) {
+            const double runWays = counter->transition(state, run).ways;
+            if (runWays > 0.0) {
+                chosenRun = run;
+                if (target < runWays) {
+                    break;
+                }
+                target -= runWays;
+            }
+        }
+
+        const ArrangementCounter::Transition& transition = counter->transition(state, chosenRun);
+        const std::size_t chosenRunEnd = runEnds[chosenRun];
+        const std::size_t choices = runChoices[chosenRun];
+        const int value = counts[chosenRunEnd - 1];
+        const bool runHoldsAbove = value == aboveCount;
+        const std::size_t chosenRunBegin = chosenRunEnd - choices - (runHoldsAbove ? 1 : 0);
+        std::size_t chosen = chosenRunBegin +
+            std::min(choices - 1, static_cast<std::size_t>(target / (transition.ways / static_cast<double>(choices))));
+        if (runHoldsAbove && chosen >= abovePosition) {
+            ++chosen;
+        }
+
+        // Moving the number to the end of its run keeps counts sorted once it
+        // is lowered.
+        std::swap(numbers[chosen], numbers[chosenRunEnd - 1]);
+        const int column = placedCount / mapHeight;
+        const int row = placedCount % mapHeight;
+        tiles[(column / mapWidth) * mapTileCount + row * mapWidth + (column % mapWidth)] =
+            static_cast<TileT>(numbers[chosenRunEnd - 1]);
+        --counts[chosenRunEnd - 1];
+        aboveCount = counter->aboveCountAfter(value, placedCount);
+        abovePosition = chosenRunEnd - 1;
+        stateIndex = transition.nextState;
+    }
+    return true;
+}
+
+// Min-conflicts repair of a shuffle with vertical matches: every tile that
+// sits under an equal tile is swapped with a randomly chosen tile such that
+// neither swapped cell ends up next to an equal number. Each accepted swap
+// strictly lowers the conflict count, so the pass is linear in the map size.
+// Gives up on the first conflict it cannot fix cheaply;
+// placeTilesAvoidingVerticalMatches handles those layouts.
+//
+// Unlike sampleUniformArrangement, the result is not uniform: arrangements a
+// few swaps away from many shuffles come out more often. On 3 x 3 single mode,
+// where most shuffles need a repair, 240000 stages hit the 336 arrangements
+// between 419 and 1154 times around a mean of 714, so the repair only serves
+// layouts too large to count.
+template <typename TileT, typename Rng>
+bool repairVerticalMatches(
+    TileT* tiles,
+    int tileCount,
+    int mapWidth,
+    int mapHeight,
+    Rng& rng,
+    GenerationScratch& scratch,
+    const GenerationControl& control
+) {
+    static constexpr int kRandomSwapCandidates = 64;
+
+    std::vector<int>& conflictingTiles = scratch.conflictingTiles;
+    conflictingTiles.clear();
+    for (int tileIndex = mapWidth; tileIndex < tileCount; ++tileIndex) {
+        const int rowInMap = (tileIndex / mapWidth) % mapHeight;
+        if (rowInMap > 0 && tiles[tileIndex] == tiles[tileIndex - mapWidth]) {
+            conflictingTiles.push_back(tileIndex);
+        }
+    }
+
+    std::uniform_int_distribution<int> anyTile(0, tileCount - 1);
+    int swapCount = 0;
+    for (const int conflictIndex : conflictingTiles) {
+        if (control.isCancelled()) {
+            return false;
+        }
+        if (!hasVerticalMatchAt(tiles, mapWidth, mapHeight, conflictIndex)) {
+            continue;
+        }
+
+        bool repaired = false;
+        for (int candidate = 0; candidate < kRandomSwapCandidates && !repaired; ++candidate) {
+            const int candidateIndex = anyTile(rng);
+            if (tiles[candidateIndex] == tiles[conflictIndex]) {
+                continue;
+            }
+
+            std::swap(tiles[conflictIndex], tiles[candidateIndex]);
+            repaired = !hasVerticalMatchAt(tiles, mapWidth, mapHeight, conflictIndex) &&
+                !hasVerticalMatchAt(tiles, mapWidth, mapHeight, candidateIndex);
+            if (!repaired) {
+                std::swap(tiles[conflictIndex], tiles[candidateIndex]);
+            }
+        }
+
+        if (!repaired) {
+            return false;
+        }
+        ++swapCount;
+    }
+
+    TILE_METRICS_COUNT(ArrangementsRepaired, 1);
+    recordArrangementOutcome(control, &ArrangementOutcomeCounts::repaired);
+    TILE_METRICS_COUNT(RepairSwaps, swapCount);
+    return true;
+}
+
+// Builds a conflict-free arrangement directly, one column at a time from top to
+// bottom. Each cell takes a uniformly drawn remaining tile unless that tile
+// equals the one above it or would leave some number with more copies than the
+// unfilled cells can hold without vertical neighbours (half of each remaining
+// column, rounded up). That bound is exact, so the placer never dead-ends when
+// a valid arrangement exists. On failure the tile multiset is left intact.
+template <typename TileT, typename Rng>
+bool placeTilesAvoidingVerticalMatches(
+    TileT* tiles,
+    int tileCount,
+    int mapWidth,
+    int mapHeight,
+    Rng& rng,
+    GenerationScratch& scratch,
+    const GenerationControl& control
+) {
+    static constexpr int kRandomPicksPerCell = 16;
+
+    if (mapWidth <= 0 || mapHeight <= 0 || tileCount == 0) {
+        return true;
+    }
+
+    const int mapTileCount = mapWidth * mapHeight;
+    const int columnCount = tileCount / mapHeight;
+    const int cellsPerColumnForOneNumber = (mapHeight + 1) / 2;
+    auto tileIndexAt = [&](int placementIndex) {
+        const int column = placementIndex / mapHeight;
+        const int row = placementIndex % mapHeight;
+        return (column / mapWidth) * mapTileCount + row * mapWidth + (column % mapWidth);
+    };
+
+    std::vector<Tile>& pool = scratch.tilePool;
+    pool.assign(tiles, tiles + tileCount);
+    const int maxTile = *std::max_element(pool.begin(), pool.end());
+    std::vector<int>& remainingCount = scratch.remainingCount;
+    remainingCount.assign(static_cast<std::size_t>(maxTile) + 1, 0);
+    for (const Tile tile : pool) {
+        ++remainingCount[tile];
+    }
+
+    // numbersWithCount[c] is how many distinct numbers have c copies left, so
+    // the largest remaining count other than a given number is cheap to find.
+    std::vector<int>& numbersWithCount = scratch.numbersWithCount;
+    numbersWithCount.assign(static_cast<std::size_t>(tileCount) + 1, 0);
+    int highestCount = 0;
+    for (const int count : remainingCount) {
+        if (count > 0) {
+            ++numbersWithCount[count];
+            highestCount = std::max(highestCount, count);
+        }
+    }
+
+    auto highestCountExcluding = [&](int tile) {
+        if (remainingCount[tile] != highestCount || numbersWithCount[highestCount] > 1) {
+            return highestCount;
+        }
+        for (int count = highestCount - 1; count > 0; --count) {
+            if (numbersWithCount[count] > 0) {
+                return count;
+            }
+        }
+        return 0;
+    };
+
+    int placementIndex = 0;
+    auto restoreUnplacedTiles = [&] {
+        for (int index = placementIndex; index < tileCount; ++index) {
+            tiles[tileIndexAt(index)] = static_cast<TileT>(pool[index]);
+        }
+    };
+
+    for (int column = 0; column < columnCount; ++column) {
+        const int fullColumnsAfter = columnCount - column - 1;
+        const int fullColumnCapacity = fullColumnsAfter * cellsPerColumnForOneNumber;
+        int tileAbove = -1;
+
+        for (int row = 0; row < mapHeight; ++row, ++placementIndex) {
+            if (control.isCancelled()) {
+                restoreUnplacedTiles();
+                return false;
+            }
+
+            const int cellsLeftInColumn = mapHeight - row - 1;
+            auto canPlace = [&](int tile) {
+                if (tile == tileAbove) {
+                    return false;
+                }
+                // After placing, this number may fill every other remaining
+                // cell below it; every other number may also take the first.
+                const int sameNumberCapacity = fullColumnCapacity + cellsLeftInColumn / 2;
+                const int otherNumberCapacity = fullColumnCapacity + (cellsLeftInColumn + 1) / 2;
+                return remainingCount[tile] - 1 <= sameNumberCapacity &&
+                    highestCountExcluding(tile) <= otherNumberCapacity;
+            };
+
+            std::uniform_int_distribution<int> remainingTile(placementIndex, tileCount - 1);
+            int chosenIndex = -1;
+            for (int pick = 0; pick < kRandomPicksPerCell && chosenIndex < 0; ++pick) {
+                const int candidateIndex = remainingTile(rng);
+                if (canPlace(pool[candidateIndex])) {
+                    chosenIndex = candidateIndex;
+                }
+            }
+            if (chosenIndex < 0) {
+                const int scanStart = remainingTile(rng);
+                const int remaining = tileCount - placementIndex;
+                for (int offset = 0; offset < remaining && chosenIndex < 0; ++offset) {
+                    const int candidateIndex = placementIndex + (scanStart - placementIndex + offset) % remaining;
+                    if (canPlace(pool[candidateIndex])) {
+                        chosenIndex = candidateIndex;
+                    }
+                }
+            }
+            if (chosenIndex < 0) {
+                restoreUnplacedTiles();
+                return false;
+            }
+
+            std::swap(pool[placementIndex], pool[chosenIndex]);
+            const Tile tile = pool[placementIndex];
+            tiles[tileIndexAt(placementIndex)] = static_cast<TileT>(tile);
+            tileAbove = tile;
+
+            --numbersWithCount[remainingCount[tile]];
+            --remainingCount[tile];
+            if (remainingCount[tile] > 0) {
+                ++numbersWithCount[remainingCount[tile]];
+            }
+            while (highestCount > 0 && numbersWithCount[highestCount] == 0) {
+                --highestCount;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename TileT, typename Rng>
+bool arrangeTilesAvoidingVerticalMatches(
+    TileT* tiles,
+    int tileCount,
+    int mapWidth,
+    int mapHeight,
+    Rng& rng,
+    GenerationScratch& scratch,
+    const GenerationControl& control
+) {
+    TILE_METRICS_SAMPLED_PHASE(Arrange);
+    // Most shuffles of wide maps are already valid; confirm that with the
+    // vectorized validator before doing any per-tile work. Accepting them
+    // as shuffled keeps the result uniform: every arrangement is equally
+    // likely to come out of the shuffle, and the sampler is uniform too.
+    if (!hasVerticalMatchInStackedMaps(tiles, tileCount, mapWidth, mapHeight)) {
+        TILE_METRICS_COUNT(ArrangementsValidAfterShuffle, 1);
+        recordArrangementOutcome(control, &ArrangementOutcomeCounts::validAfterShuffle);
+        return true;
+    }
+    if (sampleUniformArrangement(tiles, tileCount, mapWidth, mapHeight, rng, scratch)) {
+        TILE_METRICS_COUNT(ArrangementsPlaced, 1);
+        recordArrangementOutcome(control, &ArrangementOutcomeCounts::placed);
+        return true;
+    }
+    if (repairVerticalMatches(tiles, tileCount, mapWidth, mapHeight, rng, scratch, control)) {
+        return true;
+    }
+    if (control.isCancelled()) {
+        return false;
+    }
+    const bool placed = placeTilesAvoidingVerticalMatches(tiles, tileCount, mapWidth, mapHeight, rng, scratch, control);
+    if (placed) {
+        TILE_METRICS_COUNT(ArrangementsPlaced, 1);
+        recordArrangementOutcome(control, &ArrangementOutcomeCounts::placed);
+    } else if (!control.isCancelled()) {
+        TILE_METRICS_COUNT(ArrangementsFailed, 1);
+        recordArrangementOutcome(control, &ArrangementOutcomeCounts::failed);
+    }
+    return placed;
+}
+
+template <typename TileT, typename Rng>
+bool shuffleMapTilesAvoidingVerticalMatches(
+    TileT* tiles,
+    int mapWidth,
+    int mapHeight,
+    const ShuffleSettings& shuffleSettings,
+    bool arrangementPossible,
+    Rng& rng,
+    GenerationScratch& scratch,
+    const GenerationControl& control
+) {
+    const int tileCount = mapWidth * mapHeight;
+    shuffleTiles(tiles, static_cast<std::size_t>(tileCount), shuffleSettings, rng, control);
+    if (!arrangementPossible) {
+        TILE_METRICS_COUNT(ArrangementsSkipped, 1);
+        recordArrangementOutcome(control, &ArrangementOutcomeCounts::skipped);
+        return false;
+    }
+    return arrangeTilesAvoidingVerticalMatches(tiles, tileCount, mapWidth, mapHeight, rng, scratch, control);
+}
+
+// The maps of a stage are stored back to back and already carry their +100
+// per-map offsets, so the stage's own tiles are the shared number pool and are
+// shuffled and arranged in place as the maps stacked on top of each other.
+template <typename TileT, typename Rng>
+bool shuffleMultiplayerTileNumbersAcrossMapsAvoidingVerticalMatches(
+    TileT* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    int mapCount,
+    const ShuffleSettings& shuffleSettings,
+    bool arrangementPossible,
+    Rng& rng,
+    GenerationScratch& scratch,
+    const GenerationControl& control
+) {
+    const int tileCount = mapWidth * mapHeight * mapCount;
+    shuffleTiles(stageTiles, static_cast<std::size_t>(tileCount), shuffleSettings, rng, control);
+    if (!arrangementPossible) {
+        TILE_METRICS_COUNT(ArrangementsSkipped, 1);
+        recordArrangementOutcome(control, &ArrangementOutcomeCounts::skipped);
+        return false;
+    }
+    return arrangeTilesAvoidingVerticalMatches(stageTiles, tileCount, mapWidth, mapHeight, rng, scratch, control);
+}
+
+template <typename TileT, typename Rng>
+bool shuffleStage(
+    TileT* stageTiles,
+    const StageRecord& stage,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    bool arrangementPossible,
+    Rng& rng,
+    const GenerationControl& control
+) {
+    if (stage.mapCount == 0) {
+        return true;
+    }
+
+    GenerationScratch& scratch = getThreadGenerationScratch();
+    TILE_METRICS_BEGIN_STAGE();
+
+    if (isMultiplayerMode && stage.mapCount >= 2) {
+        return shuffleMultiplayerTileNumbersAcrossMapsAvoidingVerticalMatches(
+            stageTiles,
+            stage.mapWidth,
+            stage.mapHeight,
+            stage.mapCount,
+            shuffleSettings,
+            arrangementPossible,
+            rng,
+            scratch,
+            control
+        );
+    }
+
+    return shuffleMapTilesAvoidingVerticalMatches(
+        stageTiles,
+        stage.mapWidth,
+        stage.mapHeight,
+        shuffleSettings,
+        arrangementPossible,
+        rng,
+        scratch,
+        control
+    );
+}
+
+// Stage stageIndex of a batch draws only from deriveStageSeed(masterSeed,
+// stageIndex), so it can be shuffled alone or as part of any batch.
+template <typename TileT>
+bool shuffleStageWithSeed(
+    TileT* stageTiles,
+    const StageRecord& stage,
+    std::uint64_t stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    bool arrangementPossible,
+    std::uint64_t masterSeed,
+    const GenerationControl& control
+) {
+    const std::uint64_t stageSeed = deriveStageSeed(masterSeed, stageIndex);
+
+    // The legacy kernel always replays the original mt19937 stream.
+    if (shuffleSettings.kernel == ShuffleKernel::Fast && shuffleSettings.rngBackend == RngBackend::Xoshiro256StarStar) {
+        Xoshiro256StarStar rng(stageSeed);
+        return shuffleStage(stageTiles, stage, shuffleSettings, isMultiplayerMode, arrangementPossible, rng, control);
+    }
+
+    LazyMt19937 rng = createStageRng(stageSeed);
+    return shuffleStage(stageTiles, stage, shuffleSettings, isMultiplayerMode, arrangementPossible, rng, control);
+}
+
+// Retry r of stage i draws from the stream of stage i under a master seed
+// derived from (masterSeed, r), so regenerated stages stay reproducible.
+std::uint64_t deriveDuplicateRetrySeed(std::uint64_t masterSeed, int retryIndex) {
+    static constexpr std::uint64_t kDuplicateRetrySalt = 0xC2B2'AE3D'27D4'EB4Full;
+    return splitMix64(masterSeed ^ (kDuplicateRetrySalt * static_cast<std::uint64_t>(retryIndex)));
+}
+
+} // namespace
+
+int getMapCountPerStage(bool isMultiplayerMode) {
+    return isMultiplayerMode ? 2 : 1;
+}
+
+StageStore createStages(
+    int stageCount,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode
+) {
+    StageStore stages;
+    stages.reset(stageCount, getMapCountPerStage(isMultiplayerMode), mapWidth, mapHeight);
+    return stages;
+}
+
+bool hasVerticalMatchingTiles(const MapView& map) {
+    return map.visitTiles([&](const auto* tiles) {
+        return hasVerticalMatch(tiles, map.width, map.height);
+    });
+}
+
+bool hasVerticalMatchingTilesInAnyMap(const StageStore& stages, int stageIndex) {
+    const int mapCount = stages.stage(stageIndex).mapCount;
+    for (int mapIndex = 0; mapIndex < mapCount; ++mapIndex) {
+        if (hasVerticalMatchingTiles(stages.map(stageIndex, mapIndex))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+namespace {
+template <typename TileT>
+ArrangementFeasibility checkArrangementFeasibility(const TileT* tiles, int tileCount, int mapWidth, int mapHeight) {
+    ArrangementFeasibility feasibility;
+    if (tileCount <= 0 || mapWidth <= 0 || mapHeight <= 0) {
+        return feasibility;
+    }
+
+    const int maxTile = *std::max_element(tiles, tiles + tileCount);
+    std::vector<int> tileCounts(static_cast<std::size_t>(maxTile) + 1, 0);
+    for (int tileIndex = 0; tileIndex < tileCount; ++tileIndex) {
+        const TileT tile = tiles[tileIndex];
+        const int count = ++tileCounts[tile];
+        if (count > feasibility.mostFrequentTileCount) {
+            feasibility.mostFrequentTile = tile;
+            feasibility.mostFrequentTileCount = count;
+        }
+    }
+
+    const int columnCount = tileCount / mapHeight;
+    feasibility.maxTileCountWithoutVerticalMatch = columnCount * ((mapHeight + 1) / 2);
+    feasibility.isPossible = feasibility.mostFrequentTileCount <= feasibility.maxTileCountWithoutVerticalMatch;
+    return feasibility;
+}
+} // namespace
+
+ArrangementFeasibility checkTileArrangementFeasibility(const Tile* tiles, int tileCount, int mapWidth, int mapHeight) {
+    return checkArrangementFeasibility(tiles, tileCount, mapWidth, mapHeight);
+}
+
+ArrangementFeasibility checkStageArrangementFeasibility(const StageStore& stages, int stageIndex, bool isMultiplayerMode) {
+    const StageRecord& stage = stages.stage(stageIndex);
+    if (stage.mapCount == 0) {
+        return {};
+    }
+
+    // Multi mode pools every map of the stage, single mode arranges its one map.
+    const int arrangedMapCount = isMultiplayerMode ? stage.mapCount : 1;
+    return stages.visitStageTiles(stageIndex, [&](const auto* stageTiles) {
+        return checkArrangementFeasibility(
+            stageTiles,
+            stage.mapWidth * stage.mapHeight * arrangedMapCount,
+            stage.mapWidth,
+            stage.mapHeight
+        );
+    });
+}
+
+ArrangementFeasibility checkStageConfigurationFeasibility(int mapWidth, int mapHeight, bool isMultiplayerMode) {
+    const int mapCount = getMapCountPerStage(isMultiplayerMode);
+    std::vector<Tile> tiles(static_cast<std::size_t>(mapWidth) * mapHeight * mapCount);
+    fillInitialStageLayout(tiles.data(), mapWidth, mapHeight, mapCount);
+    return checkTileArrangementFeasibility(tiles.data(), static_cast<int>(tiles.size()), mapWidth, mapHeight);
+}
+
+DistinctArrangementCount countDistinctStageArrangements(
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    std::uint64_t limit
+) {
+    // Doubles hold every integer below 2^53 exactly.
+    static constexpr double kMaxExactCount = 0x1.0p53;
+
+    DistinctArrangementCount result;
+    const int mapCount = getMapCountPerStage(isMultiplayerMode);
+    const int tileCount = mapWidth * mapHeight * mapCount;
+    if (mapWidth <= 0 || mapHeight <= 0 || limit == 0) {
+        return result;
+    }
+    // The pigeonhole check is exact, so impossible layouts need no counting.
+    if (!checkStageConfigurationFeasibility(mapWidth, mapHeight, isMultiplayerMode).isPossible) {
+        result.isExact = true;
+        return result;
+    }
+    if (tileCount > kMaxCountedTiles) {
+        return result;
+    }
+
+    // Every number of the initial layout fills one column's worth of cells.
+    std::vector<std::uint8_t> counts(static_cast<std::size_t>(mapWidth) * mapCount, static_cast<std::uint8_t>(mapHeight));
+    ArrangementCounter counter(mapHeight, tileCount);
+    const std::int32_t stateIndex = counter.find(counts, -1, 0);
+    if (stateIndex == ArrangementCounter::kGaveUp) {
+        return result;
+    }
+    const double count = counter.state(stateIndex).ways;
+    result.isExact = count < static_cast<double>(limit) && count < kMaxExactCount;
+    result.count = result.isExact ? static_cast<std::uint64_t>(count) : limit;
+    return result;
+}
+
+namespace {
+// Enough for tiny layouts that are nearly exhausted, cheap for the rest.
+constexpr int kMaxDuplicateRetries = 64;
+
+// Adds a generated stage to duplicateFilter, regenerating it from the retry
+// streams while its fingerprint is already there. Returns false if the final
+// tiles kept vertical matches; a stage that needed no retry keeps arranged,
+// the verdict of its first shuffle.
+template <typename TileT>
+bool commitStageWithRetries(
+    TileT* stageTiles,
+    const StageRecord& stage,
+    std::uint64_t batchStageIndex,
+    std::uint64_t fingerprint,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    bool arrangementPossible,
+    std::uint64_t masterSeed,
+    DuplicateStageFilter& duplicateFilter,
+    const GenerationControl& control,
+    bool arranged
+) {
+    const std::size_t tileCount = static_cast<std::size_t>(stage.mapWidth) * stage.mapHeight * stage.mapCount;
+    int retryIndex = 0;
+    while (!duplicateFilter.fingerprints.insert(fingerprint)) {
+        ++duplicateFilter.rejectedCandidateCount;
+        const bool exhausted = duplicateFilter.distinctStages.isExact &&
+            static_cast<std::uint64_t>(duplicateFilter.fingerprints.size()) >= duplicateFilter.distinctStages.count;
+        if (retryIndex == kMaxDuplicateRetries || exhausted || control.isCancelled()) {
+            ++duplicateFilter.unresolvedDuplicateCount;
+            break;
+        }
+        if (retryIndex == 0) {
+            ++duplicateFilter.regeneratedStageCount;
+        }
+
+        ++retryIndex;
+        fillInitialStageLayout(stageTiles, stage.mapWidth, stage.mapHeight, stage.mapCount);
+        arranged = shuffleStageWithSeed(
+            stageTiles,
+            stage,
+            batchStageIndex,
+            shuffleSettings,
+            isMultiplayerMode,
+            arrangementPossible,
+            deriveDuplicateRetrySeed(masterSeed, retryIndex),
+            control
+        );
+        fingerprint = computeStageFingerprint(stageTiles, tileCount);
+    }
+    TILE_METRICS_COUNT(DuplicateCandidatesRejected, retryIndex);
+    TILE_METRICS_COUNT(StagesGenerated, 1);
+    TILE_METRICS_STAGE_ATTEMPTS(retryIndex + 1);
+    return arranged;
+}
+
+template <typename TileT>
+bool generateStageTilesFromSeed(
+    TileT* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    const GenerationControl& control
+) {
+    StageRecord stage;
+    stage.mapWidth = mapWidth;
+    stage.mapHeight = mapHeight;
+    stage.mapCount = getMapCountPerStage(isMultiplayerMode);
+    fillInitialStageLayout(stageTiles, mapWidth, mapHeight, stage.mapCount);
+    TILE_METRICS_COUNT(StagesGenerated, 1);
+    TILE_METRICS_STAGE_ATTEMPTS(1);
+
+    return shuffleStageWithSeed(
+        stageTiles,
+        stage,
+        static_cast<std::uint64_t>(stageIndex),
+        shuffleSettings,
+        isMultiplayerMode,
+        arrangementPossible,
+        masterSeed,
+        control
+    );
+}
+} // namespace
+
+int shuffleStageMaps(
+    StageStore& stages,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int firstStageIndex,
+    DuplicateStageFilter* duplicateFilter
+) {
+    static constexpr int kTasksPerWorker = 16;
+
+    const int stageCount = stages.stageCount();
+    const int stagesPerTask = std::max(1, stageCount / (pool.threadCount() * kTasksPerWorker));
+    const int taskCount = (stageCount + stagesPerTask - 1) / stagesPerTask;
+
+    // Every stage of a batch starts from the same layout, so one check covers
+    // the whole batch and impossible layouts skip the arranger entirely.
+    const bool arrangementPossible = stages.empty() ||
+        checkStageArrangementFeasibility(stages, 0, isMultiplayerMode).isPossible;
+
+    std::atomic<int> completedStageCount{0};
+    // Stages never reached (cancellation) are not counted as invalid.
+    std::vector<std::uint8_t> stageArranged(static_cast<std::size_t>(stageCount), 1);
+
+    // Duplicate filtering commits stages strictly in index order, whichever
+    // worker finished them: the worker that finds the next stage ready takes
+    // the commit lock and advances the cursor as far as it can.
+    std::unique_ptr<std::atomic<std::uint8_t>[]> stageReady;
+    // Hashed by the worker that generated the stage, outside the commit lock.
+    std::vector<std::uint64_t> stageFingerprints;
+    if (duplicateFilter != nullptr) {
+        stageReady = std::make_unique<std::atomic<std::uint8_t>[]>(static_cast<std::size_t>(stageCount));
+        stageFingerprints.resize(static_cast<std::size_t>(stageCount));
+    }
+    std::mutex commitMutex;
+    int commitCursor = 0;
+    auto isStageReady = [&](int stageIndex) {
+        return stageIndex < stageCount &&
+            stageReady[static_cast<std::size_t>(stageIndex)].load(std::memory_order_acquire) != 0;
+    };
+
+    auto commitStage = [&](int stageIndex) {
+        std::uint8_t& arranged = stageArranged[static_cast<std::size_t>(stageIndex)];
+        arranged = stages.visitStageTiles(stageIndex, [&](auto* stageTiles) {
+            return commitStageWithRetries(
+                stageTiles,
+                stages.stage(stageIndex),
+                static_cast<std::uint64_t>(firstStageIndex) + static_cast<std::uint64_t>(stageIndex),
+                stageFingerprints[static_cast<std::size_t>(stageIndex)],
+                shuffleSettings,
+                isMultiplayerMode,
+                arrangementPossible,
+                masterSeed,
+                *duplicateFilter,
+                control,
+                arranged != 0
+            );
+        }) ? 1 : 0;
+
+        if (control.onStageGenerated) {
+            control.onStageGenerated(stageIndex);
+        }
+    };
+
+    auto commitReadyStages = [&] {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(commitMutex, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                return;
+            }
+            while (isStageReady(commitCursor)) {
+                commitStage(commitCursor);
+                ++commitCursor;
+            }
+            const int nextStageIndex = commitCursor;
+            lock.unlock();
+
+            // A stage marked ready while the lock was held may have been missed.
+            if (!isStageReady(nextStageIndex)) {
+                return;
+            }
+        }
+    };
+
+    pool.parallelFor(taskCount, [&](int taskIndex) {
+        TILE_METRICS_PHASE(Generate);
+        const int begin = taskIndex * stagesPerTask;
+        const int end = std::min(stageCount, begin + stagesPerTask);
+
+        for (int stageIndex = begin; stageIndex < end; ++stageIndex) {
+            if (control.isCancelled()) {
+                return;
+            }
+
+            const bool arranged = stages.visitStageTiles(stageIndex, [&](auto* stageTiles) {
+                return shuffleStageWithSeed(
+                    stageTiles,
+                    stages.stage(stageIndex),
+                    static_cast<std::uint64_t>(firstStageIndex) + static_cast<std::uint64_t>(stageIndex),
+                    shuffleSettings,
+                    isMultiplayerMode,
+                    arrangementPossible,
+                    masterSeed,
+                    control
+                );
+            });
+
+            stageArranged[static_cast<std::size_t>(stageIndex)] = arranged ? 1 : 0;
+            if (duplicateFilter != nullptr) {
+                {
+                    TILE_METRICS_SAMPLED_PHASE(Fingerprint);
+                    stageFingerprints[static_cast<std::size_t>(stageIndex)] =
+                        stages.visitStageTiles(stageIndex, [&](const auto* stageTiles) {
+                            return computeStageFingerprint(stageTiles, stages.stageTileCount(stageIndex));
+                        });
+                }
+                stageReady[static_cast<std::size_t>(stageIndex)].store(1, std::memory_order_release);
+                commitReadyStages();
+            } else {
+                TILE_METRICS_COUNT(StagesGenerated, 1);
+                TILE_METRICS_STAGE_ATTEMPTS(1);
+                if (control.onStageGenerated) {
+                    control.onStageGenerated(stageIndex);
+                }
+            }
+
+            const int completed = completedStageCount.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (control.onStageCompleted) {
+                control.onStageCompleted(completed);
+            }
+        }
+    });
+
+    // Every worker has returned; commit whatever the race above left behind.
+    if (duplicateFilter != nullptr) {
+        while (isStageReady(commitCursor)) {
+            commitStage(commitCursor);
+            ++commitCursor;
+        }
+    }
+
+    return static_cast<int>(std::count(stageArranged.begin(), stageArranged.end(), std::uint8_t{0}));
+}
+
+bool generateStageTiles(
+    Tile* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    const GenerationControl& control
+) {
+    return generateStageTilesFromSeed(
+        stageTiles,
+        mapWidth,
+        mapHeight,
+        isMultiplayerMode,
+        stageIndex,
+        shuffleSettings,
+        masterSeed,
+        arrangementPossible,
+        control
+    );
+}
+
+bool generateStageTiles(
+    NarrowTile* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    const GenerationControl& control
+) {
+    return generateStageTilesFromSeed(
+        stageTiles,
+        mapWidth,
+        mapHeight,
+        isMultiplayerMode,
+        stageIndex,
+        shuffleSettings,
+        masterSeed,
+        arrangementPossible,
+        control
+    );
+}
+
+void commitStageWithoutDuplicates(
+    Tile* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    DuplicateStageFilter& duplicateFilter
+) {
+    StageRecord stage;
+    stage.mapWidth = mapWidth;
+    stage.mapHeight = mapHeight;
+    stage.mapCount = getMapCountPerStage(isMultiplayerMode);
+    const std::size_t tileCount = static_cast<std::size_t>(mapWidth) * mapHeight * stage.mapCount;
+
+    commitStageWithRetries(
+        stageTiles,
+        stage,
+        static_cast<std::uint64_t>(stageIndex),
+        computeStageFingerprint(stageTiles, tileCount),
+        shuffleSettings,
+        isMultiplayerMode,
+        arrangementPossible,
+        masterSeed,
+        duplicateFilter,
+        GenerationControl{},
+        true
+    );
+}
+
+int generateAutoMapShuffleCount(std::uint64_t masterSeed) {
+    static constexpr int kAutoMapMinShuffleCount = 20;
+    static constexpr int kAutoMapMaxShuffleCount = 100000;
+    static constexpr std::uint64_t kAutoMapSeedSalt = 0xA076'1D64'78BD'642Full;
+
+    const std::uint64_t autoMapSeed = splitMix64(masterSeed ^ kAutoMapSeedSalt);
+    std::seed_seq seedSequence{
+        static_cast<std::uint32_t>(autoMapSeed),
+        static_cast<std::uint32_t>(autoMapSeed >> 32),
+    };
+    std::mt19937 rng(seedSequence);
+    std::uniform_int_distribution<int> distribution(kAutoMapMinShuffleCount, kAutoMapMaxShuffleCount);
+    return distribution(rng);
+}
+
+std::string describeImpossibleArrangement(const ArrangementFeasibility& feasibility) {
+    return "Number " + std::to_string(feasibility.mostFrequentTile) + " appears " +
+        std::to_string(feasibility.mostFrequentTileCount) + " time(s), but at most " +
+        std::to_string(feasibility.maxTileCountWithoutVerticalMatch) +
+        " fit without vertically adjacent equal numbers.";
+}
+
+std::string describeStageShortage(const DistinctArrangementCount& distinctStages, int stageCount) {
+    if (distinctStages.count == 0) {
+        return "No stage without vertical matches exists for this map size and mode, so none of the " +
+            std::to_string(stageCount) + " requested is regenerated to avoid repeating an earlier one.";
+    }
+    return "Only " + std::to_string(distinctStages.count) + " distinct stage(s) exist for this map size and mode, so " +
+        std::to_string(static_cast<std::uint64_t>(stageCount) - distinctStages.count) + " of the " +
+        std::to_string(stageCount) + " requested will repeat an earlier one.";
+}
+
+std::string describeDuplicateStages(const DuplicateStageFilter& duplicateFilter, int stageCount) {
+    const std::string regenerated = std::to_string(duplicateFilter.regeneratedStageCount) + " stage(s) regenerated after " +
+        std::to_string(duplicateFilter.rejectedCandidateCount) + " duplicate candidate(s)";
+    if (duplicateFilter.unresolvedDuplicateCount > 0) {
+        return std::to_string(duplicateFilter.unresolvedDuplicateCount) + " of " + std::to_string(stageCount) +
+            " stage(s) still repeat an earlier one; " + regenerated + ".";
+    }
+    return "All " + std::to_string(stageCount) + " stage(s) are distinct; " + regenerated + ".";
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "core/StageFingerprint.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+enum class ShuffleKernel {
+    // One Fisher-Yates pass with Lemire's bounded draws. A uniform random
+    // permutation composed with anything is still uniform, so N passes have
+    // the same output distribution as one.
+    Fast,
+    // shuffleCount std::shuffle passes on mt19937, reproducing the exact
+    // stream (and output) of earlier releases for a given seed.
+    LegacyExact,
+};
+
+enum class RngBackend {
+    Mt19937,
+    Xoshiro256StarStar,
+};
+
+// Maps of up to 64 tiles that need rearranging are drawn by the uniform
+// sampler, so every arrangement without vertical matches is equally likely.
+// That costs time the old repair pass did not: 200k 8x8 single stages with
+// xoshiro take about 1.6 s instead of 0.23 s, roughly 7x slower.
+struct ShuffleSettings {
+    int shuffleCount = 1;
+    ShuffleKernel kernel = ShuffleKernel::Fast;
+    RngBackend rngBackend = RngBackend::Mt19937;
+};
+
+// How the arranger finished each shuffled map (a stage in multi mode),
+// counted whether or not generation metrics are compiled in.
+struct ArrangementOutcomeCounts {
+    // Accepted as shuffled, without a single swap.
+    std::atomic<std::uint64_t> validAfterShuffle{0};
+    std::atomic<std::uint64_t> repaired{0};
+    // Drawn by the uniform sampler (up to 64 tiles) or built by the placer.
+    std::atomic<std::uint64_t> placed{0};
+    std::atomic<std::uint64_t> failed{0};
+    // Impossible layouts, shuffled only.
+    std::atomic<std::uint64_t> skipped{0};
+};
+
+// Lets long-running generation observe cancellation and report per-stage progress.
+struct GenerationControl {
+    const std::atomic<bool>* cancelRequested = nullptr;
+    // Tallied from every worker when set.
+    ArrangementOutcomeCounts* arrangementOutcomes = nullptr;
+    std::function<void(int completedStageCount)> onStageCompleted;
+    // Called from the generating worker right after stage stageIndex has its
+    // final tiles, in whatever order the pool finishes stages.
+    std::function<void(int stageIndex)> onStageGenerated;
+
+    bool isCancelled() const {
+        return cancelRequested != nullptr && cancelRequested->load(std::memory_order_relaxed);
+    }
+};
+
+// Result of the pigeonhole check. A number can fill at most every other cell
+// of a column, i.e. ceil(height / 2) cells, so a layout is impossible as soon
+// as one number has more copies than the columns can hold that way. The
+// constructive placer proves the converse, so the check is exact.
+struct ArrangementFeasibility {
+    bool isPossible = true;
+    int mostFrequentTile = 0;
+    int mostFrequentTileCount = 0;
+    int maxTileCountWithoutVerticalMatch = 0;
+};
+
+// Number of distinct conflict-free arrangements of one stage, counted exactly
+// up to limit. isExact is false when the count was cut off at limit or the
+// layout is too large to count; count is then only a lower bound. An
+// impossible layout has an exact count of 0 at any size.
+struct DistinctArrangementCount {
+    std::uint64_t count = 0;
+    bool isExact = false;
+};
+
+// Rejects stages that repeat an earlier stage of the batch. Shared by every
+// worker of a shuffleStageMaps call.
+struct DuplicateStageFilter {
+    explicit DuplicateStageFilter(int stageCount)
+        : fingerprints(stageCount) {}
+
+    StageFingerprintSet fingerprints;
+    // Number of distinct stages; when exact, repeats are kept without retrying
+    // once that many are in the batch, right away for an exact 0.
+    DistinctArrangementCount distinctStages;
+    // Candidates that matched an earlier stage and were thrown away.
+    int rejectedCandidateCount = 0;
+    // Stages that needed at least one regeneration.
+    int regeneratedStageCount = 0;
+    // Stages left equal to an earlier one after every retry.
+    int unresolvedDuplicateCount = 0;
+};
+
+int getMapCountPerStage(bool isMultiplayerMode);
+
+StageStore createStages(
+    int stageCount,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode
+);
+
+bool hasVerticalMatchingTiles(const MapView& map);
+bool hasVerticalMatchingTilesInAnyMap(const StageStore& stages, int stageIndex);
+
+// tiles holds one or more maps of mapWidth x mapHeight stacked on top of each
+// other, arranged as a single pool.
+ArrangementFeasibility checkTileArrangementFeasibility(const Tile* tiles, int tileCount, int mapWidth, int mapHeight);
+ArrangementFeasibility checkStageArrangementFeasibility(const StageStore& stages, int stageIndex, bool isMultiplayerMode);
+ArrangementFeasibility checkStageConfigurationFeasibility(int mapWidth, int mapHeight, bool isMultiplayerMode);
+std::string describeImpossibleArrangement(const ArrangementFeasibility& feasibility);
+
+// Counts the vertical-match-free stages with this map size and mode, stopping
+// at limit. Only small layouts are counted; larger ones report isExact false.
+DistinctArrangementCount countDistinctStageArrangements(
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    std::uint64_t limit
+);
+
+// "Only N distinct stage(s) exist..." for an exact count below stageCount,
+// or that none exists for an exact 0.
+std::string describeStageShortage(const DistinctArrangementCount& distinctStages, int stageCount);
+// One-line uniqueness report of a finished batch.
+std::string describeDuplicateStages(const DuplicateStageFilter& duplicateFilter, int stageCount);
+
+// Shuffles and arranges every stage in place on the pool. Stage i of the
+// store is stage firstStageIndex + i of the batch and always uses the stream
+// deriveStageSeed(masterSeed, firstStageIndex + i), so a batch can also be
+// generated one window of stages at a time. Returns the number of stages that
+// could not avoid vertically adjacent equal numbers.
+//
+// With a duplicateFilter, stages are committed in index order: a stage whose
+// fingerprint is already in the filter is regenerated from a retry stream
+// (still derived only from the master seed, its index and the retry number)
+// until it is new, so the output does not depend on the thread count.
+// onStageGenerated then fires as each stage is committed, in index order.
+int shuffleStageMaps(
+    StageStore& stages,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    WorkStealingPool& pool,
+    const GenerationControl& control,
+    int firstStageIndex = 0,
+    DuplicateStageFilter* duplicateFilter = nullptr
+);
+
+// Builds stage stageIndex of a batch from scratch into stageTiles, which must
+// hold getMapCountPerStage(isMultiplayerMode) maps of mapWidth x mapHeight.
+// The tiles are exactly what shuffleStageMaps produces for that stage with the
+// same settings and master seed. arrangementPossible is
+// checkStageConfigurationFeasibility(...).isPossible, passed in so callers can
+// check the configuration once. Returns false if the stage kept vertically
+// adjacent equal numbers. The NarrowTile overload needs getStageTileBytes 1,
+// as in a StageStore that keeps the stage in bytes.
+bool generateStageTiles(
+    Tile* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    const GenerationControl& control = GenerationControl{}
+);
+bool generateStageTiles(
+    NarrowTile* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    const GenerationControl& control = GenerationControl{}
+);
+
+// Adds stage stageIndex of a batch, as generated from its own stream (e.g. by
+// a shuffleStageMaps call without a filter), to duplicateFilter the way a
+// filtered shuffleStageMaps commits it: while it repeats a stage already in
+// the filter it is regenerated in place from the same retry streams. Calling
+// this for every stage in index order therefore deduplicates a batch that
+// was generated in pieces (shards) to the same tiles as a single run.
+void commitStageWithoutDuplicates(
+    Tile* stageTiles,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    int stageIndex,
+    const ShuffleSettings& shuffleSettings,
+    std::uint64_t masterSeed,
+    bool arrangementPossible,
+    DuplicateStageFilter& duplicateFilter
+);
+
+int generateAutoMapShuffleCount(std::uint64_t masterSeed);
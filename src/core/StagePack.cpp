@@ -0,0 +1,502 @@
+#include "core/StagePack.hpp"
+
+#include "core/GenerationMetrics.hpp"
+#include "core/StageCsvExporter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace {
+constexpr char kStagePackMagic[8] = {'T', 'M', 'S', 'P', 'A', 'C', 'K', '\0'};
+constexpr std::uint32_t kMultiplayerModeFlag = 1;
+constexpr std::size_t kStagePackWriteBufferBytes = std::size_t{1} << 20;
+
+constexpr std::array<std::uint32_t, 256> makeCrc32Table() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t byte = 0; byte < 256; ++byte) {
+        std::uint32_t crc = byte;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB8'8320u : crc >> 1;
+        }
+        table[byte] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<std::uint32_t, 256> kCrc32Table = makeCrc32Table();
+
+// CRC-32 as used by zip and PNG.
+std::uint32_t computeCrc32(const std::uint8_t* data, std::size_t size) {
+    std::uint32_t crc = 0xFFFF'FFFFu;
+    for (std::size_t index = 0; index < size; ++index) {
+        crc = kCrc32Table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFF'FFFFu;
+}
+
+void storeU32(std::uint8_t* out, std::uint32_t value) {
+    for (int byte = 0; byte < 4; ++byte) {
+        out[byte] = static_cast<std::uint8_t>(value >> (8 * byte));
+    }
+}
+
+void storeU64(std::uint8_t* out, std::uint64_t value) {
+    for (int byte = 0; byte < 8; ++byte) {
+        out[byte] = static_cast<std::uint8_t>(value >> (8 * byte));
+    }
+}
+
+std::uint32_t loadU32(const std::uint8_t* in) {
+    std::uint32_t value = 0;
+    for (int byte = 3; byte >= 0; --byte) {
+        value = (value << 8) | in[byte];
+    }
+    return value;
+}
+
+std::uint64_t loadU64(const std::uint8_t* in) {
+    std::uint64_t value = 0;
+    for (int byte = 7; byte >= 0; --byte) {
+        value = (value << 8) | in[byte];
+    }
+    return value;
+}
+
+template <typename TileT>
+void unpackStageTiles(const std::uint8_t* data, std::size_t tileCount, int tileBytes, TileT* tiles) {
+    if (tileBytes == 1) {
+        std::copy(data, data + tileCount, tiles);
+    } else {
+        for (std::size_t index = 0; index < tileCount; ++index) {
+            tiles[index] = static_cast<TileT>(data[2 * index] | (data[2 * index + 1] << 8));
+        }
+    }
+}
+
+// Streams tiles right after a placeholder header and appends the stage table
+// at the end, then rewrites the header with the final offsets.
+class StagePackWriter {
+public:
+    StagePackWriter() = default;
+    StagePackWriter(const StagePackWriter&) = delete;
+    StagePackWriter& operator=(const StagePackWriter&) = delete;
+
+    ~StagePackWriter() {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+
+    bool open(
+        const std::string& outputPath,
+        int stageCount,
+        int mapWidth,
+        int mapHeight,
+        int mapCountPerStage,
+        bool isMultiplayerMode,
+        std::uint64_t masterSeed,
+        int firstStageIndex
+    ) {
+        file_ = std::fopen(outputPath.c_str(), "wb");
+        if (file_ == nullptr) {
+            return false;
+        }
+        std::setvbuf(file_, nullptr, _IOFBF, kStagePackWriteBufferBytes);
+
+        outputPath_ = outputPath;
+        stageCount_ = stageCount;
+        mapWidth_ = mapWidth;
+        mapHeight_ = mapHeight;
+        mapCountPerStage_ = mapCountPerStage;
+        isMultiplayerMode_ = isMultiplayerMode;
+        masterSeed_ = masterSeed;
+        firstStageIndex_ = firstStageIndex;
+        // Same rule as StageStore, so a narrow batch is packed as it is stored.
+        tileBytes_ = getStageTileBytes(mapWidth, mapCountPerStage);
+        table_.reserve(static_cast<std::size_t>(stageCount) * kStagePackTableEntryBytes);
+
+        const std::uint8_t placeholder[kStagePackHeaderBytes] = {};
+        write(placeholder, sizeof(placeholder));
+        return !failed_;
+    }
+
+    template <typename TileT>
+    void appendStage(const TileT* tiles, std::size_t tileCount) {
+        packed_.resize(tileCount * static_cast<std::size_t>(tileBytes_));
+        if constexpr (sizeof(TileT) == 1) {
+            std::copy(tiles, tiles + tileCount, packed_.begin());
+        } else if (tileBytes_ == 1) {
+            for (std::size_t index = 0; index < tileCount; ++index) {
+                packed_[index] = static_cast<std::uint8_t>(tiles[index]);
+            }
+        } else {
+            for (std::size_t index = 0; index < tileCount; ++index) {
+                packed_[2 * index] = static_cast<std::uint8_t>(tiles[index]);
+                packed_[2 * index + 1] = static_cast<std::uint8_t>(tiles[index] >> 8);
+            }
+        }
+
+        std::uint8_t entry[kStagePackTableEntryBytes];
+        storeU64(entry, tileDataBytes_);
+        storeU32(entry + 8, static_cast<std::uint32_t>(tileCount));
+        storeU32(entry + 12, computeCrc32(packed_.data(), packed_.size()));
+        table_.insert(table_.end(), entry, entry + sizeof(entry));
+
+        write(packed_.data(), packed_.size());
+        tileDataBytes_ += packed_.size();
+    }
+
+    bool finish() {
+        const std::uint64_t tableOffset = kStagePackHeaderBytes + tileDataBytes_;
+        write(table_.data(), table_.size());
+
+        std::uint8_t header[kStagePackHeaderBytes] = {};
+        std::memcpy(header, kStagePackMagic, sizeof(kStagePackMagic));
+        storeU32(header + 8, kStagePackVersion);
+        storeU32(header + 12, isMultiplayerMode_ ? kMultiplayerModeFlag : 0);
+        storeU64(header + 16, masterSeed_);
+        storeU32(header + 24, static_cast<std::uint32_t>(stageCount_));
+        storeU32(header + 28, static_cast<std::uint32_t>(mapWidth_));
+        storeU32(header + 32, static_cast<std::uint32_t>(mapHeight_));
+        storeU32(header + 36, static_cast<std::uint32_t>(mapCountPerStage_));
+        storeU32(header + 40, static_cast<std::uint32_t>(tileBytes_));
+        storeU32(header + 44, static_cast<std::uint32_t>(firstStageIndex_));
+        storeU64(header + 48, tableOffset);
+        storeU64(header + 56, kStagePackHeaderBytes);
+        if (std::fseek(file_, 0, SEEK_SET) != 0) {
+            failed_ = true;
+        }
+        write(header, sizeof(header));
+
+        const bool closed = std::fclose(file_) == 0;
+        file_ = nullptr;
+        return closed && !failed_;
+    }
+
+    // Closes and deletes the partial file.
+    void abort() {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+        std::error_code removeError;
+        std::filesystem::remove(outputPath_, removeError);
+    }
+
+private:
+    void write(const void* data, std::size_t size) {
+        if (!failed_ && size > 0) {
+            failed_ = std::fwrite(data, 1, size, file_) != size;
+            TILE_METRICS_COUNT(BytesWritten, size);
+        }
+    }
+
+    std::FILE* file_ = nullptr;
+    std::string outputPath_;
+    int stageCount_ = 0;
+    int mapWidth_ = 0;
+    int mapHeight_ = 0;
+    int mapCountPerStage_ = 0;
+    bool isMultiplayerMode_ = false;
+    std::uint64_t masterSeed_ = 0;
+    int firstStageIndex_ = 0;
+    int tileBytes_ = 1;
+    std::uint64_t tileDataBytes_ = 0;
+    std::vector<std::uint8_t> packed_;
+    std::vector<std::uint8_t> table_;
+    bool failed_ = false;
+};
+} // namespace
+
+std::string getStagePackFileName(bool isMultiplayerMode, const std::string& exportTitle) {
+    const std::string baseName = isMultiplayerMode ? "stages_multi_mode" : "stages_single_mode";
+    const std::string normalizedTitle = normalizeExportTitle(exportTitle);
+
+    if (normalizedTitle.empty()) {
+        return baseName + ".tmpack";
+    }
+
+    return baseName + "_" + normalizedTitle + ".tmpack";
+}
+
+bool writeStagePack(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    int firstStageIndex
+) {
+    TILE_METRICS_PHASE(Export);
+    // Every stage of a batch has the same dimensions.
+    const StageRecord firstStage = stages.empty() ? StageRecord{} : stages.stage(0);
+
+    StagePackWriter writer;
+    if (!writer.open(
+            outputPath,
+            stages.stageCount(),
+            firstStage.mapWidth,
+            firstStage.mapHeight,
+            firstStage.mapCount,
+            isMultiplayerMode,
+            masterSeed,
+            firstStageIndex
+        )) {
+        writer.abort();
+        return false;
+    }
+
+    for (int stageIndex = 0; stageIndex < stages.stageCount(); ++stageIndex) {
+        stages.visitStageTiles(stageIndex, [&](const auto* stageTiles) {
+            writer.appendStage(stageTiles, stages.stageTileCount(stageIndex));
+        });
+    }
+    return writer.finish();
+}
+
+bool exportStagesToPack(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& exportTitle,
+    std::string& outputPath
+) {
+    outputPath = getStagePackFileName(isMultiplayerMode, exportTitle);
+    return writeStagePack(stages, isMultiplayerMode, masterSeed, outputPath);
+}
+
+bool writeStagePackByWindow(
+    int stageCount,
+    int windowStageCount,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    const StageWindowFiller& fillWindow
+) {
+    TILE_METRICS_PHASE(Export);
+    StagePackWriter writer;
+    // getMapCountPerStage, without pulling in the generator.
+    const int mapCountPerStage = isMultiplayerMode ? 2 : 1;
+    if (!writer.open(outputPath, stageCount, mapWidth, mapHeight, mapCountPerStage, isMultiplayerMode, masterSeed, 0)) {
+        writer.abort();
+        return false;
+    }
+
+    StageStore window;
+    windowStageCount = std::max(1, windowStageCount);
+    for (int firstStageIndex = 0; firstStageIndex < stageCount; firstStageIndex += windowStageCount) {
+        const int currentWindowStageCount = std::min(windowStageCount, stageCount - firstStageIndex);
+        if (!fillWindow(firstStageIndex, currentWindowStageCount, window)) {
+            writer.abort();
+            return false;
+        }
+
+        for (int stageIndex = 0; stageIndex < currentWindowStageCount; ++stageIndex) {
+            window.visitStageTiles(stageIndex, [&](const auto* stageTiles) {
+                writer.appendStage(stageTiles, window.stageTileCount(stageIndex));
+            });
+        }
+    }
+    return writer.finish();
+}
+
+bool StagePackReader::open(const std::string& path, std::string& error) {
+    close();
+    if (!file_.open(path, error)) {
+        return false;
+    }
+
+    auto fail = [&](const std::string& reason) {
+        error = "'" + path + "' is not a valid stage pack: " + reason;
+        close();
+        return false;
+    };
+
+    const std::size_t fileBytes = file_.size();
+    const std::uint8_t* header = file_.data();
+    if (fileBytes < kStagePackHeaderBytes || std::memcmp(header, kStagePackMagic, sizeof(kStagePackMagic)) != 0) {
+        return fail("missing TMSPACK header");
+    }
+
+    const std::uint32_t version = loadU32(header + 8);
+    if (version != kStagePackVersion) {
+        return fail("unsupported version " + std::to_string(version));
+    }
+
+    const std::uint32_t stageCount = loadU32(header + 24);
+    const std::uint32_t firstStageIndex = loadU32(header + 44);
+    const std::uint32_t mapWidth = loadU32(header + 28);
+    const std::uint32_t mapHeight = loadU32(header + 32);
+    const std::uint32_t mapCountPerStage = loadU32(header + 36);
+    const std::uint32_t tileBytes = loadU32(header + 40);
+    const std::uint64_t tableOffset = loadU64(header + 48);
+    const std::uint64_t tileDataOffset = loadU64(header + 56);
+
+    if (stageCount > 0x7FFF'FFFFu ||
+        firstStageIndex > 0x7FFF'FFFFu - stageCount ||
+        mapWidth > static_cast<std::uint32_t>(kMaxMapWidth) ||
+        mapCountPerStage > 2 ||
+        mapHeight > static_cast<std::uint32_t>(
+            getMaxMapHeight(static_cast<int>(mapWidth), static_cast<int>(mapCountPerStage))) ||
+        (tileBytes != 1 && tileBytes != 2) ||
+        std::uint64_t{mapWidth} * mapHeight * mapCountPerStage * tileBytes > fileBytes) {
+        return fail("header values out of range");
+    }
+    if (static_cast<int>(tileBytes) != getStageTileBytes(static_cast<int>(mapWidth), static_cast<int>(mapCountPerStage))) {
+        return fail("tile width does not match the map size");
+    }
+    if (tableOffset > fileBytes ||
+        (fileBytes - tableOffset) / kStagePackTableEntryBytes < stageCount ||
+        tileDataOffset < kStagePackHeaderBytes ||
+        tileDataOffset > tableOffset) {
+        return fail("stage table or tile data outside the file");
+    }
+
+    path_ = path;
+    masterSeed_ = loadU64(header + 16);
+    isMultiplayerMode_ = (loadU32(header + 12) & kMultiplayerModeFlag) != 0;
+    stageCount_ = static_cast<int>(stageCount);
+    firstStageIndex_ = static_cast<int>(firstStageIndex);
+    mapWidth_ = static_cast<int>(mapWidth);
+    mapHeight_ = static_cast<int>(mapHeight);
+    mapCountPerStage_ = static_cast<int>(mapCountPerStage);
+    tileBytes_ = static_cast<int>(tileBytes);
+    tableOffset_ = tableOffset;
+    tileDataOffset_ = tileDataOffset;
+    return true;
+}
+
+void StagePackReader::close() {
+    file_.close();
+    path_.clear();
+    masterSeed_ = 0;
+    isMultiplayerMode_ = false;
+    stageCount_ = 0;
+    firstStageIndex_ = 0;
+    mapWidth_ = 0;
+    mapHeight_ = 0;
+    mapCountPerStage_ = 0;
+    tileBytes_ = 1;
+    tableOffset_ = 0;
+    tileDataOffset_ = 0;
+}
+
+bool StagePackReader::isOpen() const {
+    return file_.isOpen();
+}
+
+const std::string& StagePackReader::path() const {
+    return path_;
+}
+
+std::uint64_t StagePackReader::masterSeed() const {
+    return masterSeed_;
+}
+
+bool StagePackReader::isMultiplayerMode() const {
+    return isMultiplayerMode_;
+}
+
+int StagePackReader::stageCount() const {
+    return stageCount_;
+}
+
+int StagePackReader::firstStageIndex() const {
+    return firstStageIndex_;
+}
+
+int StagePackReader::mapWidth() const {
+    return mapWidth_;
+}
+
+int StagePackReader::mapHeight() const {
+    return mapHeight_;
+}
+
+int StagePackReader::mapCountPerStage() const {
+    return mapCountPerStage_;
+}
+
+int StagePackReader::tileBytes() const {
+    return tileBytes_;
+}
+
+std::size_t StagePackReader::stageTileCount() const {
+    return static_cast<std::size_t>(mapWidth_) * mapHeight_ * mapCountPerStage_;
+}
+
+std::size_t StagePackReader::fileBytes() const {
+    return file_.size();
+}
+
+const std::uint8_t* StagePackReader::stageData(int stageIndex) const {
+    if (stageIndex < 0 || stageIndex >= stageCount_) {
+        return nullptr;
+    }
+
+    const std::uint8_t* entry = tableEntry(stageIndex);
+    const std::uint64_t offset = loadU64(entry);
+    const std::uint64_t tileCount = loadU32(entry + 8);
+    const std::uint64_t stageBytes = tileCount * static_cast<std::uint64_t>(tileBytes_);
+    const std::uint64_t tileDataBytes = tableOffset_ - tileDataOffset_;
+    if (tileCount != stageTileCount() || offset > tileDataBytes || tileDataBytes - offset < stageBytes) {
+        return nullptr;
+    }
+    return file_.data() + tileDataOffset_ + offset;
+}
+
+bool StagePackReader::verifyStage(int stageIndex) const {
+    const std::uint8_t* data = stageData(stageIndex);
+    if (data == nullptr) {
+        return false;
+    }
+
+    const std::size_t stageBytes = stageTileCount() * static_cast<std::size_t>(tileBytes_);
+    return computeCrc32(data, stageBytes) == loadU32(tableEntry(stageIndex) + 12);
+}
+
+std::uint32_t StagePackReader::stageChecksum(int stageIndex) const {
+    return loadU32(tableEntry(stageIndex) + 12);
+}
+
+bool StagePackReader::readStageTiles(int stageIndex, Tile* tiles) const {
+    const std::uint8_t* data = stageData(stageIndex);
+    if (data == nullptr) {
+        return false;
+    }
+    unpackStageTiles(data, stageTileCount(), tileBytes_, tiles);
+    return true;
+}
+
+bool StagePackReader::readStageTiles(int stageIndex, NarrowTile* tiles) const {
+    const std::uint8_t* data = stageData(stageIndex);
+    if (data == nullptr) {
+        return false;
+    }
+    unpackStageTiles(data, stageTileCount(), tileBytes_, tiles);
+    return true;
+}
+
+bool StagePackReader::readStageWindow(int firstStageIndex, int windowStageCount, StageStore& window) const {
+    window.reset(windowStageCount, mapCountPerStage_, mapWidth_, mapHeight_);
+    for (int stageIndex = 0; stageIndex < windowStageCount; ++stageIndex) {
+        const bool read = window.visitStageTiles(stageIndex, [&](auto* stageTiles) {
+            return readStageTiles(firstStageIndex + stageIndex, stageTiles);
+        });
+        if (!read) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::uint8_t* StagePackReader::tableEntry(int stageIndex) const {
+    return file_.data() + tableOffset_ + static_cast<std::size_t>(stageIndex) * kStagePackTableEntryBytes;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "core/MappedFile.hpp"
+#include "core/StageStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary stage pack (.tmpack). All integers are little-endian.
+//
+//   Header, 64 bytes
+//      0  char[8]  "TMSPACK" followed by a zero byte
+//      8  u32      format version (kStagePackVersion)
+//     12  u32      flags, bit 0 set for multi mode
+//     16  u64      master seed
+//     24  u32      stage count
+//     28  u32      map width
+//     32  u32      map height
+//     36  u32      maps per stage
+//     40  u32      bytes per tile, 1 or 2
+//     44  u32      global index of the first stage: 0 unless the pack is one
+//                   shard of a larger batch (see StageShard.hpp)
+//     48  u64      file offset of the stage table
+//     56  u64      file offset of the tile data
+//
+//   Tile data: the maps of each stage back to back, each map row by row as
+//   in StageStore, one byte per tile when every tile number fits in 8 bits.
+//
+//   Stage table, 16 bytes per stage
+//      0  u64      offset of the stage's tiles from the start of the tile data
+//      8  u32      tile count of the stage
+//     12  u32      CRC-32 of the stage's packed tile bytes
+inline constexpr std::uint32_t kStagePackVersion = 1;
+inline constexpr std::size_t kStagePackHeaderBytes = 64;
+inline constexpr std::size_t kStagePackTableEntryBytes = 16;
+
+std::string getStagePackFileName(bool isMultiplayerMode, const std::string& exportTitle);
+
+// Stage i of stages is written as stage firstStageIndex + i of the batch.
+bool writeStagePack(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    int firstStageIndex = 0
+);
+
+// writeStagePack to getStagePackFileName(...) in the working directory; the
+// chosen path is returned in outputPath.
+bool exportStagesToPack(
+    const StageStore& stages,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& exportTitle,
+    std::string& outputPath
+);
+
+// Writes a pack of stageCount stages produced one window at a time, like
+// writeStagesCsvByWindow. Only the 16-byte table entries of the stages written
+// so far are kept in memory.
+bool writeStagePackByWindow(
+    int stageCount,
+    int windowStageCount,
+    int mapWidth,
+    int mapHeight,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    const std::string& outputPath,
+    const StageWindowFiller& fillWindow
+);
+
+// Zero-copy reader over a memory-mapped pack. open() checks the header and
+// the table bounds only, so it takes the same time for any pack size; a stage
+// is located through its table entry when it is accessed.
+class StagePackReader {
+public:
+    // On failure returns false and describes the problem in error.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool isOpen() const;
+    const std::string& path() const;
+
+    std::uint64_t masterSeed() const;
+    bool isMultiplayerMode() const;
+    int stageCount() const;
+    // Batch index of stage 0 of the pack, non-zero only for a shard.
+    int firstStageIndex() const;
+    int mapWidth() const;
+    int mapHeight() const;
+    int mapCountPerStage() const;
+    int tileBytes() const;
+    std::size_t stageTileCount() const;
+    std::size_t fileBytes() const;
+
+    // Packed tiles of a stage inside the mapping (stageTileCount() *
+    // tileBytes() bytes), or nullptr if its table entry points outside the file.
+    const std::uint8_t* stageData(int stageIndex) const;
+
+    // Recomputes the CRC-32 of the stage and compares it with the table.
+    bool verifyStage(int stageIndex) const;
+
+    // CRC-32 the table records for the stage, without reading its tiles.
+    std::uint32_t stageChecksum(int stageIndex) const;
+
+    // Unpacks the stage into stageTileCount() tiles. Returns false if its
+    // table entry is invalid. NarrowTile is only for packs whose tiles fit in
+    // a byte (getStageTileBytes 1).
+    bool readStageTiles(int stageIndex, Tile* tiles) const;
+    bool readStageTiles(int stageIndex, NarrowTile* tiles) const;
+
+    // Loads stages [firstStageIndex, firstStageIndex + windowStageCount) into
+    // window, e.g. to re-export a pack through a StageWindowFiller.
+    bool readStageWindow(int firstStageIndex, int windowStageCount, StageStore& window) const;
+
+private:
+    const std::uint8_t* tableEntry(int stageIndex) const;
+
+    MappedFile file_;
+    std::string path_;
+    std::uint64_t masterSeed_ = 0;
+    bool isMultiplayerMode_ = false;
+    int stageCount_ = 0;
+    int firstStageIndex_ = 0;
+    int mapWidth_ = 0;
+    int mapHeight_ = 0;
+    int mapCountPerStage_ = 0;
+    int tileBytes_ = 1;
+    std::uint64_t tableOffset_ = 0;
+    std::uint64_t tileDataOffset_ = 0;
+};
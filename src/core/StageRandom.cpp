@@ -0,0 +1,116 @@
+#include "core/StageRandom.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+std::uint64_t splitMix64(std::uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+std::uint64_t generateMasterSeed() {
+    std::random_device rd;
+    return (static_cast<std::uint64_t>(rd()) << 32) ^ static_cast<std::uint64_t>(rd());
+}
+
+std::uint64_t deriveStageSeed(std::uint64_t masterSeed, std::uint64_t stageIndex) {
+    return splitMix64(masterSeed ^ splitMix64(stageIndex));
+}
+
+namespace {
+// std::seed_seq over the two words createStageRng passes. generate() follows
+// the standard's definition step for step, so mt19937 ends up in exactly the
+// same state, but walks its indices incrementally instead of taking three
+// modulos per step and needs no heap allocation. Seeding is most of the cost
+// of a small stage, so this matters more than anything in the shuffle.
+class TwoWordSeedSequence {
+public:
+    using result_type = std::uint32_t;
+
+    TwoWordSeedSequence(std::uint32_t low, std::uint32_t high)
+        : words_{low, high} {}
+
+    template <typename RandomIt>
+    void generate(RandomIt begin, RandomIt end) const {
+        static constexpr std::size_t kWordCount = 2;
+
+        const std::size_t n = static_cast<std::size_t>(end - begin);
+        if (n == 0) {
+            return;
+        }
+        std::fill(begin, end, 0x8b8b8b8bu);
+
+        const std::size_t t = n >= 623 ? 11 : n >= 68 ? 7 : n >= 39 ? 5 : n >= 7 ? 3 : (n - 1) / 2;
+        const std::size_t p = (n - t) / 2;
+        const std::size_t q = p + t;
+        const std::size_t m = std::max(kWordCount + 1, n);
+
+        auto advance = [n](std::size_t& index) {
+            if (++index == n) {
+                index = 0;
+            }
+        };
+        auto mix = [](std::uint32_t value) {
+            return value ^ (value >> 27);
+        };
+
+        // k, (k + p) and (k + q), all modulo n. Element (k - 1) modulo n is
+        // always the value the previous step stored last, so it stays in a
+        // register.
+        std::size_t kn = 0;
+        std::size_t kpn = p % n;
+        std::size_t kqn = q % n;
+        std::uint32_t previous = static_cast<std::uint32_t>(begin[n - 1]);
+        for (std::size_t k = 0; k < m; ++k) {
+            const std::uint32_t r1 = 1664525u * mix(static_cast<std::uint32_t>(begin[kn] ^ begin[kpn]) ^ previous);
+            const std::size_t r2Offset = k == 0 ? kWordCount : k <= kWordCount ? kn + words_[k - 1] : kn;
+            const std::uint32_t r2 = r1 + static_cast<std::uint32_t>(r2Offset);
+            begin[kpn] = static_cast<std::uint32_t>(begin[kpn] + r1);
+            begin[kqn] = static_cast<std::uint32_t>(begin[kqn] + r2);
+            begin[kn] = r2;
+            previous = r2;
+            advance(kn);
+            advance(kpn);
+            advance(kqn);
+        }
+        for (std::size_t k = 0; k < n; ++k) {
+            const std::uint32_t r3 = 1566083941u * mix(static_cast<std::uint32_t>(begin[kn] + begin[kpn]) + previous);
+            const std::uint32_t r4 = r3 - static_cast<std::uint32_t>(kn);
+            begin[kpn] = static_cast<std::uint32_t>(begin[kpn] ^ r3);
+            begin[kqn] = static_cast<std::uint32_t>(begin[kqn] ^ r4);
+            begin[kn] = r4;
+            previous = r4;
+            advance(kn);
+            advance(kpn);
+            advance(kqn);
+        }
+    }
+
+private:
+    std::uint32_t words_[2];
+};
+} // namespace
+
+LazyMt19937::LazyMt19937(std::uint64_t stageSeed) {
+    const TwoWordSeedSequence seedSequence(
+        static_cast<std::uint32_t>(stageSeed),
+        static_cast<std::uint32_t>(stageSeed >> 32)
+    );
+    seedSequence.generate(state_, state_ + kStateWords);
+
+    // mersenne_twister_engine::seed(Sseq&): an all-zero state (ignoring the
+    // low 31 bits of the first word) is replaced by a single set bit.
+    bool allZero = (state_[0] & 0x80000000u) == 0;
+    for (std::size_t word = 1; word < kStateWords && allZero; ++word) {
+        allZero = state_[word] == 0;
+    }
+    if (allZero) {
+        state_[0] = 0x80000000u;
+    }
+}
+
+LazyMt19937 createStageRng(std::uint64_t stageSeed) {
+    return LazyMt19937(stageSeed);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+std::uint64_t splitMix64(std::uint64_t value);
+std::uint64_t generateMasterSeed();
+
+// Every stage draws from its own stream, derived only from the master seed and
+// the stage index, so output does not depend on which worker ran the stage.
+std::uint64_t deriveStageSeed(std::uint64_t masterSeed, std::uint64_t stageIndex);
+
+// The mt19937 stream of one stage: exactly the numbers std::mt19937 seeded
+// with std::seed_seq{low word, high word} of stageSeed produces, which is what
+// earlier releases used. Instead of regenerating all 624 words of state on
+// the first draw, each word is regenerated when it is drawn, so a stage that
+// only needs a few dozen numbers does not pay for the rest.
+class LazyMt19937 {
+public:
+    using result_type = std::mt19937::result_type;
+
+    explicit LazyMt19937(std::uint64_t stageSeed);
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return 0xFFFFFFFFu;
+    }
+
+    result_type operator()() {
+        // The in-place twist of std::mt19937, one word at a time: word i reads
+        // words i + 1 and i + 397 exactly as the full pass would, whether they
+        // have already been regenerated in this pass or not.
+        const std::size_t next = index_ + 1 == kStateWords ? 0 : index_ + 1;
+        const std::size_t shifted = index_ + kShift < kStateWords ? index_ + kShift : index_ + kShift - kStateWords;
+        const std::uint32_t joined = (state_[index_] & 0x80000000u) | (state_[next] & 0x7FFFFFFFu);
+        std::uint32_t value = state_[shifted] ^ (joined >> 1) ^ ((joined & 1u) != 0 ? 0x9908B0DFu : 0u);
+        state_[index_] = value;
+        index_ = next;
+
+        value ^= value >> 11;
+        value ^= (value << 7) & 0x9D2C5680u;
+        value ^= (value << 15) & 0xEFC60000u;
+        value ^= value >> 18;
+        return value;
+    }
+
+private:
+    static constexpr std::size_t kStateWords = 624;
+    static constexpr std::size_t kShift = 397;
+
+    std::uint32_t state_[kStateWords];
+    std::size_t index_ = 0;
+};
+
+LazyMt19937 createStageRng(std::uint64_t stageSeed);
+
+// xoshiro256** (Blackman/Vigna). Four words of state seeded straight from
+// splitmix64, versus mt19937's 624 words run through std::seed_seq, so it is
+// much cheaper per stage and per draw.
+class Xoshiro256StarStar {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256StarStar(std::uint64_t seed) {
+        for (std::uint64_t& word : state_) {
+            seed = splitMix64(seed);
+            word = seed;
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~static_cast<result_type>(0);
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotateLeft(state_[1] * 5, 7) * 9;
+        const std::uint64_t shifted = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= shifted;
+        state_[3] = rotateLeft(state_[3], 45);
+
+        return result;
+    }
+
+private:
+    static std::uint64_t rotateLeft(std::uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    std::uint64_t state_[4] = {};
+};
@@ -0,0 +1,230 @@
+#include "core/StageShard.hpp"
+
+#include "core/StageCsvExporter.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+// Stages read per merge window: 4 Mi tiles, as for lazy export.
+constexpr std::size_t kMergeWindowTiles = std::size_t{4} << 20;
+} // namespace
+
+StageShardRange getStageShardRange(int stageCount, int shardIndex, int shardCount) {
+    if (stageCount <= 0 || shardCount <= 0 || shardIndex < 0 || shardIndex >= shardCount) {
+        return {};
+    }
+
+    auto boundary = [&](int index) {
+        return static_cast<int>(static_cast<std::int64_t>(stageCount) * index / shardCount);
+    };
+    const int firstStageIndex = boundary(shardIndex);
+    return StageShardRange{firstStageIndex, boundary(shardIndex + 1) - firstStageIndex};
+}
+
+std::string getStageShardFileName(const std::string& outputPath, int shardIndex, int shardCount) {
+    std::filesystem::path shardPath(outputPath);
+    shardPath.replace_extension();
+    shardPath += ".shard-" + std::to_string(shardIndex) + "-of-" + std::to_string(shardCount) + ".tmpack";
+    return shardPath.string();
+}
+
+bool StageShardSet::open(const std::vector<std::string>& shardPaths, std::string& error) {
+    shards_.clear();
+    stageCount_ = 0;
+    if (shardPaths.empty()) {
+        error = "no shard packs given";
+        return false;
+    }
+
+    for (const std::string& shardPath : shardPaths) {
+        auto shard = std::make_unique<StagePackReader>();
+        if (!shard->open(shardPath, error)) {
+            shards_.clear();
+            return false;
+        }
+        shards_.push_back(std::move(shard));
+    }
+    // An empty shard sorts before the one that shares its first index.
+    std::sort(shards_.begin(), shards_.end(), [](const auto& left, const auto& right) {
+        if (left->firstStageIndex() != right->firstStageIndex()) {
+            return left->firstStageIndex() < right->firstStageIndex();
+        }
+        return left->stageCount() < right->stageCount();
+    });
+
+    auto fail = [&](const std::string& reason) {
+        error = reason;
+        shards_.clear();
+        stageCount_ = 0;
+        return false;
+    };
+
+    const StagePackReader& firstShard = *shards_.front();
+    int nextStageIndex = 0;
+    for (const auto& shard : shards_) {
+        if (shard->masterSeed() != firstShard.masterSeed() ||
+            shard->isMultiplayerMode() != firstShard.isMultiplayerMode() ||
+            shard->mapWidth() != firstShard.mapWidth() ||
+            shard->mapHeight() != firstShard.mapHeight()) {
+            return fail(
+                "'" + shard->path() + "' is not a shard of the same batch as '" + firstShard.path() +
+                "': master seed, mode or map size differ"
+            );
+        }
+        if (shard->firstStageIndex() > nextStageIndex) {
+            return fail(
+                "stages " + std::to_string(nextStageIndex + 1) + " to " + std::to_string(shard->firstStageIndex()) +
+                " are in none of the shards"
+            );
+        }
+        if (shard->firstStageIndex() < nextStageIndex) {
+            return fail("'" + shard->path() + "' overlaps the stages of another shard");
+        }
+        nextStageIndex += shard->stageCount();
+    }
+    if (nextStageIndex == 0) {
+        return fail("the shards hold no stages");
+    }
+
+    stageCount_ = nextStageIndex;
+    return true;
+}
+
+int StageShardSet::shardCount() const {
+    return static_cast<int>(shards_.size());
+}
+
+int StageShardSet::stageCount() const {
+    return stageCount_;
+}
+
+int StageShardSet::mapWidth() const {
+    return shards_.empty() ? 0 : shards_.front()->mapWidth();
+}
+
+int StageShardSet::mapHeight() const {
+    return shards_.empty() ? 0 : shards_.front()->mapHeight();
+}
+
+int StageShardSet::mapCountPerStage() const {
+    return shards_.empty() ? 0 : shards_.front()->mapCountPerStage();
+}
+
+bool StageShardSet::isMultiplayerMode() const {
+    return !shards_.empty() && shards_.front()->isMultiplayerMode();
+}
+
+std::uint64_t StageShardSet::masterSeed() const {
+    return shards_.empty() ? 0 : shards_.front()->masterSeed();
+}
+
+bool StageShardSet::readStageTiles(int stageIndex, Tile* tiles, std::string& error) const {
+    // Last shard starting at or before the stage, never an empty one.
+    const auto found = std::upper_bound(shards_.begin(), shards_.end(), stageIndex, [](int index, const auto& shard) {
+        return index < shard->firstStageIndex();
+    });
+    if (stageIndex < 0 || stageIndex >= stageCount_ || found == shards_.begin()) {
+        error = "stage " + std::to_string(stageIndex + 1) + " is outside the batch";
+        return false;
+    }
+
+    const StagePackReader& shard = **(found - 1);
+    const int localStageIndex = stageIndex - shard.firstStageIndex();
+    if (!shard.verifyStage(localStageIndex) || !shard.readStageTiles(localStageIndex, tiles)) {
+        error = "stage " + std::to_string(stageIndex + 1) + " in '" + shard.path() + "' is damaged";
+        return false;
+    }
+    return true;
+}
+
+StageShardMergeResult mergeStageShards(
+    const StageShardSet& shards,
+    const std::string& outputPath,
+    const StageShardMergeOptions& options
+) {
+    StageShardMergeResult result;
+    const int stageCount = shards.stageCount();
+    const int mapWidth = shards.mapWidth();
+    const int mapHeight = shards.mapHeight();
+    const bool isMultiplayerMode = shards.isMultiplayerMode();
+    if (stageCount == 0) {
+        result.error = "no shards are open";
+        return result;
+    }
+
+    const ArrangementFeasibility feasibility =
+        checkStageConfigurationFeasibility(mapWidth, mapHeight, isMultiplayerMode);
+    if (options.rejectDuplicates) {
+        // Same limit as a single-process run, so a nearly exhausted layout
+        // stops retrying at the same stage.
+        result.duplicateFilter = std::make_unique<DuplicateStageFilter>(stageCount);
+        result.duplicateFilter->distinctStages = countDistinctStageArrangements(
+            mapWidth,
+            mapHeight,
+            isMultiplayerMode,
+            static_cast<std::uint64_t>(stageCount)
+        );
+    }
+
+    const std::size_t stageTileCount =
+        static_cast<std::size_t>(mapWidth) * mapHeight * shards.mapCountPerStage();
+    const int windowStageCount = static_cast<int>(std::clamp<std::size_t>(
+        kMergeWindowTiles / std::max<std::size_t>(1, stageTileCount),
+        1,
+        static_cast<std::size_t>(stageCount)
+    ));
+
+    // Each stage is read and deduplicated here, then stored at the window's
+    // own tile width.
+    std::vector<Tile> stageTiles(stageTileCount);
+    const StageWindowFiller fillWindow = [&](int firstStageIndex, int stageCountInWindow, StageStore& window) {
+        window.reset(stageCountInWindow, shards.mapCountPerStage(), mapWidth, mapHeight);
+        for (int stageInWindow = 0; stageInWindow < stageCountInWindow; ++stageInWindow) {
+            const int stageIndex = firstStageIndex + stageInWindow;
+            if (!shards.readStageTiles(stageIndex, stageTiles.data(), result.error)) {
+                return false;
+            }
+
+            if (result.duplicateFilter != nullptr) {
+                commitStageWithoutDuplicates(
+                    stageTiles.data(),
+                    mapWidth,
+                    mapHeight,
+                    isMultiplayerMode,
+                    stageIndex,
+                    options.shuffleSettings,
+                    shards.masterSeed(),
+                    feasibility.isPossible,
+                    *result.duplicateFilter
+                );
+            }
+            window.writeStageTiles(stageInWindow, stageTiles.data());
+            if (hasVerticalMatchingTilesInAnyMap(window, stageInWindow)) {
+                ++result.invalidStageCount;
+            }
+            if (options.onStageMerged) {
+                options.onStageMerged(stageIndex, stageTiles.data(), stageTileCount);
+            }
+        }
+        return true;
+    };
+
+    const bool written = options.writeCsv
+        ? writeStagesCsvByWindow(stageCount, windowStageCount, isMultiplayerMode, shards.masterSeed(), outputPath, fillWindow)
+        : writeStagePackByWindow(
+              stageCount,
+              windowStageCount,
+              mapWidth,
+              mapHeight,
+              isMultiplayerMode,
+              shards.masterSeed(),
+              outputPath,
+              fillWindow
+          );
+    if (!written && result.error.empty()) {
+        result.error = "failed to write '" + outputPath + "'";
+    }
+    result.succeeded = written;
+    return result;
+}
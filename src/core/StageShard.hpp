@@ -0,0 +1,84 @@
+#pragma once
+
+#include "core/StageGenerator.hpp"
+#include "core/StagePack.hpp"
+#include "core/StageStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A batch can be split across processes or machines: each one runs the same
+// settings and master seed over its own contiguous range of stage indices and
+// writes a stage pack of it. Stage i depends only on the master seed and i
+// (see shuffleStageMaps), so the shards concatenate to the batch one process
+// would generate. Duplicate rejection depends on every earlier stage of the
+// batch and is therefore left to the merge.
+struct StageShardRange {
+    int firstStageIndex = 0;
+    int stageCount = 0;
+};
+
+// Range of shard shardIndex when stageCount stages are split into shardCount
+// contiguous shards whose sizes differ by at most one.
+StageShardRange getStageShardRange(int stageCount, int shardIndex, int shardCount);
+
+// outputPath with ".shard-<i>-of-<n>" inserted before its extension, the
+// extension itself replaced by ".tmpack".
+std::string getStageShardFileName(const std::string& outputPath, int shardIndex, int shardCount);
+
+// The shard packs of one batch, ordered by their first stage. open() fails
+// unless they share master seed, mode and map size and cover stages
+// 0..stageCount() - 1 exactly once; they may be given in any order.
+class StageShardSet {
+public:
+    bool open(const std::vector<std::string>& shardPaths, std::string& error);
+
+    int shardCount() const;
+    int stageCount() const;
+    int mapWidth() const;
+    int mapHeight() const;
+    int mapCountPerStage() const;
+    bool isMultiplayerMode() const;
+    std::uint64_t masterSeed() const;
+
+    // Unpacks stage stageIndex of the batch after checking its CRC-32.
+    bool readStageTiles(int stageIndex, Tile* tiles, std::string& error) const;
+
+private:
+    std::vector<std::unique_ptr<StagePackReader>> shards_;
+    int stageCount_ = 0;
+};
+
+struct StageShardMergeOptions {
+    // Settings of the shard runs; stages rejected as duplicates are
+    // regenerated with them.
+    ShuffleSettings shuffleSettings;
+    bool rejectDuplicates = true;
+    // CSV as written by writeStagesCsv instead of a stage pack.
+    bool writeCsv = false;
+    // Called with the final tiles of every stage, in batch order.
+    std::function<void(int stageIndex, const Tile* tiles, std::size_t tileCount)> onStageMerged;
+};
+
+struct StageShardMergeResult {
+    bool succeeded = false;
+    std::string error;
+    // Stages left with vertically adjacent equal numbers.
+    int invalidStageCount = 0;
+    // Set when duplicates were rejected.
+    std::unique_ptr<DuplicateStageFilter> duplicateFilter;
+};
+
+// Writes the batch held by shards to outputPath one window at a time. With
+// rejectDuplicates the stages are committed in index order as a filtered
+// shuffleStageMaps would (see commitStageWithoutDuplicates), so the file is
+// byte for byte the one a single process writes for the same settings.
+StageShardMergeResult mergeStageShards(
+    const StageShardSet& shards,
+    const std::string& outputPath,
+    const StageShardMergeOptions& options
+);
@@ -0,0 +1,264 @@
+#include "core/StageStatus.hpp"
+
+#include "core/StageRandom.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+constexpr int kTasksPerWorker = 16;
+
+// Revision r of every stage is generated under a master seed derived from
+// (masterSeed, r), the way duplicate retries are, but with its own salt so a
+// revision never replays a retry stream.
+std::uint64_t deriveStageRevisionSeed(std::uint64_t masterSeed, std::uint32_t revision) {
+    static constexpr std::uint64_t kStageRevisionSalt = 0x1656'67B1'9E37'79F9ull;
+    return splitMix64(masterSeed ^ (kStageRevisionSalt * static_cast<std::uint64_t>(revision)));
+}
+} // namespace
+
+void StageStatusTable::reset(int stageCount) {
+    const std::size_t count = static_cast<std::size_t>(std::max(0, stageCount));
+    flags_.assign(count, 0);
+    revisions_.assign(count, 0);
+    dirtyStages_.clear();
+    failedCount_ = 0;
+    lockedCount_ = 0;
+    selectedCount_ = 0;
+}
+
+void StageStatusTable::markFailedStages(const StageStore& stages, WorkStealingPool& pool) {
+    const int stageCount = std::min(this->stageCount(), stages.stageCount());
+    if (stageCount == 0) {
+        return;
+    }
+
+    const int stagesPerTask = std::max(1, stageCount / (pool.threadCount() * kTasksPerWorker));
+    const int taskCount = (stageCount + stagesPerTask - 1) / stagesPerTask;
+    // Tasks only read the store and write disjoint bytes; counts are fixed up
+    // once every task has returned.
+    std::vector<std::uint8_t> failed(static_cast<std::size_t>(stageCount), 0);
+    pool.parallelFor(taskCount, [&](int taskIndex) {
+        const int begin = taskIndex * stagesPerTask;
+        const int end = std::min(stageCount, begin + stagesPerTask);
+        for (int stageIndex = begin; stageIndex < end; ++stageIndex) {
+            failed[static_cast<std::size_t>(stageIndex)] = hasVerticalMatchingTilesInAnyMap(stages, stageIndex) ? 1 : 0;
+        }
+    });
+
+    for (int stageIndex = 0; stageIndex < stageCount; ++stageIndex) {
+        if (setFlag(stageIndex, Failed, failed[static_cast<std::size_t>(stageIndex)] != 0)) {
+            failedCount_ += failed[static_cast<std::size_t>(stageIndex)] != 0 ? 1 : -1;
+        }
+    }
+}
+
+bool StageStatusTable::isFailed(int stageIndex) const {
+    return hasFlag(stageIndex, Failed);
+}
+
+bool StageStatusTable::isLocked(int stageIndex) const {
+    return hasFlag(stageIndex, Locked);
+}
+
+bool StageStatusTable::isSelected(int stageIndex) const {
+    return hasFlag(stageIndex, Selected);
+}
+
+bool StageStatusTable::isDirty(int stageIndex) const {
+    return hasFlag(stageIndex, Dirty);
+}
+
+std::uint32_t StageStatusTable::revision(int stageIndex) const {
+    if (stageIndex < 0 || stageIndex >= stageCount()) {
+        return 0;
+    }
+    return revisions_[static_cast<std::size_t>(stageIndex)];
+}
+
+void StageStatusTable::setLocked(int stageIndex, bool locked) {
+    if (setFlag(stageIndex, Locked, locked)) {
+        lockedCount_ += locked ? 1 : -1;
+    }
+}
+
+void StageStatusTable::setSelected(int stageIndex, bool selected) {
+    if (setFlag(stageIndex, Selected, selected)) {
+        selectedCount_ += selected ? 1 : -1;
+    }
+}
+
+void StageStatusTable::clearSelection() {
+    if (selectedCount_ == 0) {
+        return;
+    }
+    for (std::uint8_t& flags : flags_) {
+        flags = static_cast<std::uint8_t>(flags & ~Selected);
+    }
+    selectedCount_ = 0;
+}
+
+std::vector<int> StageStatusTable::failedStages() const {
+    return failedCount_ == 0 ? std::vector<int>{} : collectStages(Failed, true);
+}
+
+std::vector<int> StageStatusTable::selectedStages() const {
+    return selectedCount_ == 0 ? std::vector<int>{} : collectStages(Selected, true);
+}
+
+std::vector<int> StageStatusTable::unlockedStages() const {
+    return collectStages(Locked, false);
+}
+
+void StageStatusTable::clearDirty() {
+    for (const int stageIndex : dirtyStages_) {
+        setFlag(stageIndex, Dirty, false);
+    }
+    dirtyStages_.clear();
+}
+
+void StageStatusTable::recordRegeneration(int stageIndex, std::uint32_t revision, bool failed) {
+    if (stageIndex < 0 || stageIndex >= stageCount()) {
+        return;
+    }
+    revisions_[static_cast<std::size_t>(stageIndex)] = revision;
+    if (setFlag(stageIndex, Failed, failed)) {
+        failedCount_ += failed ? 1 : -1;
+    }
+    if (setFlag(stageIndex, Dirty, true)) {
+        dirtyStages_.push_back(stageIndex);
+    }
+}
+
+bool StageStatusTable::hasFlag(int stageIndex, Flag flag) const {
+    if (stageIndex < 0 || stageIndex >= stageCount()) {
+        return false;
+    }
+    return (flags_[static_cast<std::size_t>(stageIndex)] & flag) != 0;
+}
+
+bool StageStatusTable::setFlag(int stageIndex, Flag flag, bool value) {
+    if (stageIndex < 0 || stageIndex >= stageCount() || hasFlag(stageIndex, flag) == value) {
+        return false;
+    }
+    std::uint8_t& flags = flags_[static_cast<std::size_t>(stageIndex)];
+    flags = static_cast<std::uint8_t>(value ? flags | flag : flags & ~flag);
+    return true;
+}
+
+std::vector<int> StageStatusTable::collectStages(Flag flag, bool value) const {
+    std::vector<int> stageIndices;
+    for (int stageIndex = 0; stageIndex < stageCount(); ++stageIndex) {
+        if (hasFlag(stageIndex, flag) == value) {
+            stageIndices.push_back(stageIndex);
+        }
+    }
+    return stageIndices;
+}
+
+StageRegenerationResult regenerateStages(
+    StageStore& stages,
+    StageStatusTable& status,
+    const std::vector<int>& stageIndices,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    WorkStealingPool& pool,
+    const GenerationControl& control
+) {
+    StageRegenerationResult result;
+    const int mapCountPerStage = getMapCountPerStage(isMultiplayerMode);
+
+    // Locked and foreign stages are filtered out up front so the tasks below
+    // only see stages they will actually regenerate.
+    std::vector<int> sortedIndices = stageIndices;
+    std::sort(sortedIndices.begin(), sortedIndices.end());
+    sortedIndices.erase(std::unique(sortedIndices.begin(), sortedIndices.end()), sortedIndices.end());
+
+    std::vector<int> targets;
+    targets.reserve(sortedIndices.size());
+    for (const int stageIndex : sortedIndices) {
+        if (stageIndex < 0 || stageIndex >= stages.stageCount() || stageIndex >= status.stageCount()) {
+            continue;
+        }
+        if (status.isLocked(stageIndex)) {
+            ++result.lockedStageCount;
+            continue;
+        }
+        if (stages.stage(stageIndex).mapCount != mapCountPerStage) {
+            ++result.skippedStageCount;
+            continue;
+        }
+        targets.push_back(stageIndex);
+    }
+
+    const int targetCount = static_cast<int>(targets.size());
+    if (targetCount == 0) {
+        return result;
+    }
+
+    // Every stage of a store shares one size, so one feasibility check covers
+    // all targets.
+    const StageRecord& stageSize = stages.stage(targets.front());
+    const bool arrangementPossible =
+        checkStageConfigurationFeasibility(stageSize.mapWidth, stageSize.mapHeight, isMultiplayerMode).isPossible;
+
+    // A stage is never abandoned half-shuffled: cancellation is only checked
+    // between stages, and the per-stage control carries no cancel flag.
+    GenerationControl stageControl;
+    stageControl.arrangementOutcomes = control.arrangementOutcomes;
+
+    // 0 = not regenerated, 1 = arranged, 2 = kept vertical matches.
+    std::vector<std::uint8_t> outcomes(targets.size(), 0);
+    std::atomic<int> completedStageCount{0};
+    const int stagesPerTask = std::max(1, targetCount / (pool.threadCount() * kTasksPerWorker));
+    const int taskCount = (targetCount + stagesPerTask - 1) / stagesPerTask;
+    pool.parallelFor(taskCount, [&](int taskIndex) {
+        const int begin = taskIndex * stagesPerTask;
+        const int end = std::min(targetCount, begin + stagesPerTask);
+        for (int targetIndex = begin; targetIndex < end; ++targetIndex) {
+            if (control.isCancelled()) {
+                return;
+            }
+
+            const int stageIndex = targets[static_cast<std::size_t>(targetIndex)];
+            const bool arranged = stages.visitStageTiles(stageIndex, [&](auto* stageTiles) {
+                return generateStageTiles(
+                    stageTiles,
+                    stageSize.mapWidth,
+                    stageSize.mapHeight,
+                    isMultiplayerMode,
+                    stageIndex,
+                    shuffleSettings,
+                    deriveStageRevisionSeed(masterSeed, status.revision(stageIndex) + 1),
+                    arrangementPossible,
+                    stageControl
+                );
+            });
+            outcomes[static_cast<std::size_t>(targetIndex)] = arranged ? 1 : 2;
+
+            if (control.onStageGenerated) {
+                control.onStageGenerated(stageIndex);
+            }
+            const int completed = completedStageCount.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (control.onStageCompleted) {
+                control.onStageCompleted(completed);
+            }
+        }
+    });
+
+    // The table is only touched here, after every task has returned.
+    for (int targetIndex = 0; targetIndex < targetCount; ++targetIndex) {
+        const std::uint8_t outcome = outcomes[static_cast<std::size_t>(targetIndex)];
+        if (outcome == 0) {
+            continue;
+        }
+        const int stageIndex = targets[static_cast<std::size_t>(targetIndex)];
+        status.recordRegeneration(stageIndex, status.revision(stageIndex) + 1, outcome == 2);
+        ++result.regeneratedStageCount;
+        if (outcome == 2) {
+            ++result.failedStageCount;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "core/StageGenerator.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Per-stage state of a batch held in a StageStore, so single stages can be
+// fixed up without regenerating the batch: whether a stage kept vertically
+// adjacent equal numbers, whether the user locked or selected it, how often
+// it was regenerated, and which stages changed since the batch was last
+// written out. One byte of flags and a 32-bit revision per stage.
+class StageStatusTable {
+public:
+    // Every stage valid, unlocked and unchanged.
+    void reset(int stageCount);
+    // Marks the stages that keep vertical matches, checked on the pool.
+    void markFailedStages(const StageStore& stages, WorkStealingPool& pool);
+
+    bool empty() const {
+        return flags_.empty();
+    }
+
+    int stageCount() const {
+        return static_cast<int>(flags_.size());
+    }
+
+    bool isFailed(int stageIndex) const;
+    bool isLocked(int stageIndex) const;
+    bool isSelected(int stageIndex) const;
+    bool isDirty(int stageIndex) const;
+    // 0 for the stage as the batch generated it.
+    std::uint32_t revision(int stageIndex) const;
+
+    void setLocked(int stageIndex, bool locked);
+    void setSelected(int stageIndex, bool selected);
+    void clearSelection();
+
+    int failedCount() const {
+        return failedCount_;
+    }
+
+    int lockedCount() const {
+        return lockedCount_;
+    }
+
+    int selectedCount() const {
+        return selectedCount_;
+    }
+
+    int dirtyCount() const {
+        return static_cast<int>(dirtyStages_.size());
+    }
+
+    // Stages matching the flags, in index order, for regenerateStages.
+    std::vector<int> failedStages() const;
+    std::vector<int> selectedStages() const;
+    std::vector<int> unlockedStages() const;
+
+    // Stages whose tiles changed since the last clearDirty(), in the order
+    // they were first changed.
+    const std::vector<int>& dirtyStages() const {
+        return dirtyStages_;
+    }
+
+    void clearDirty();
+
+    // Records that the stage was regenerated to revision with the given
+    // outcome and marks it dirty.
+    void recordRegeneration(int stageIndex, std::uint32_t revision, bool failed);
+
+private:
+    enum Flag : std::uint8_t {
+        Failed = 1,
+        Locked = 2,
+        Selected = 4,
+        Dirty = 8,
+    };
+
+    bool hasFlag(int stageIndex, Flag flag) const;
+    // Returns true if the flag changed.
+    bool setFlag(int stageIndex, Flag flag, bool value);
+    std::vector<int> collectStages(Flag flag, bool value) const;
+
+    std::vector<std::uint8_t> flags_;
+    std::vector<std::uint32_t> revisions_;
+    std::vector<int> dirtyStages_;
+    int failedCount_ = 0;
+    int lockedCount_ = 0;
+    int selectedCount_ = 0;
+};
+
+struct StageRegenerationResult {
+    int regeneratedStageCount = 0;
+    // Regenerated stages that still keep vertical matches.
+    int failedStageCount = 0;
+    int lockedStageCount = 0;
+    // Stages whose maps do not match the mode, e.g. from an imported CSV.
+    int skippedStageCount = 0;
+};
+
+// Regenerates stageIndices of stages in place on the pool, skipping locked
+// stages. A stage's revision r >= 1 is generated as in generateStageTiles
+// from a master seed derived from masterSeed and r, so it depends only on the
+// master seed, the stage index and how often the stage was regenerated. Each
+// stage is replaced whole or not at all, also on cancellation, and the work
+// is proportional to the number of stages, not to the batch. Regenerated
+// stages are not checked against the rest of the batch for duplicates.
+StageRegenerationResult regenerateStages(
+    StageStore& stages,
+    StageStatusTable& status,
+    const std::vector<int>& stageIndices,
+    const ShuffleSettings& shuffleSettings,
+    bool isMultiplayerMode,
+    std::uint64_t masterSeed,
+    WorkStealingPool& pool,
+    const GenerationControl& control
+);
@@ -0,0 +1,125 @@
+#include "core/StageStore.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+// monotonic_buffer_resource aligns each allocation; leave room for padding
+// so the initial buffer is never outgrown.
+constexpr std::size_t kArenaSlackBytes = 64;
+
+template <typename TileT>
+void fillInitialLayout(TileT* stageTiles, int mapWidth, int mapHeight, int mapCount) {
+    for (int mapIndex = 0; mapIndex < mapCount; ++mapIndex) {
+        const int mapOffset = mapIndex * kMultiplayerMapTileOffset;
+        for (int row = 0; row < mapHeight; ++row) {
+            for (int col = 0; col < mapWidth; ++col) {
+                *stageTiles++ = static_cast<TileT>(col + 1 + mapOffset);
+            }
+        }
+    }
+}
+} // namespace
+
+void StageStore::reset(int stageCount, int mapCountPerStage, int mapWidth, int mapHeight) {
+    if (stageCount <= 0 || mapHeight > getMaxMapHeight(mapWidth, mapCountPerStage)) {
+        clear();
+        return;
+    }
+
+    const std::size_t tilesPerStage =
+        static_cast<std::size_t>(mapCountPerStage) * static_cast<std::size_t>(mapWidth) * static_cast<std::size_t>(mapHeight);
+    const std::size_t tileCount = tilesPerStage * static_cast<std::size_t>(stageCount);
+    const bool isNarrow = getStageTileBytes(mapWidth, mapCountPerStage) == 1;
+    const std::size_t arenaBytes = tileCount * (isNarrow ? sizeof(NarrowTile) : sizeof(Tile)) + kArenaSlackBytes;
+
+    auto storage = std::make_unique<Storage>(arenaBytes);
+    storage->arenaBytes = arenaBytes;
+    storage->tileBytes = isNarrow ? 1 : 2;
+    storage->stageCount = stageCount;
+    storage->stage.mapWidth = mapWidth;
+    storage->stage.mapHeight = mapHeight;
+    storage->stage.mapCount = mapCountPerStage;
+    storage->stageTileCount = tilesPerStage;
+    if (isNarrow) {
+        storage->narrowTiles.resize(tileCount);
+    } else {
+        storage->tiles.resize(tileCount);
+    }
+
+    for (std::size_t tileOffset = 0; tileOffset < tileCount; tileOffset += tilesPerStage) {
+        if (isNarrow) {
+            fillInitialStageLayout(storage->narrowTiles.data() + tileOffset, mapWidth, mapHeight, mapCountPerStage);
+        } else {
+            fillInitialStageLayout(storage->tiles.data() + tileOffset, mapWidth, mapHeight, mapCountPerStage);
+        }
+    }
+
+    storage_ = std::move(storage);
+}
+
+void StageStore::clear() {
+    storage_.reset();
+}
+
+bool StageStore::empty() const {
+    return stageCount() == 0;
+}
+
+int StageStore::stageCount() const {
+    return storage_ ? storage_->stageCount : 0;
+}
+
+int StageStore::tileBytes() const {
+    return storage_ ? storage_->tileBytes : 2;
+}
+
+const StageRecord& StageStore::stage(int /*stageIndex*/) const {
+    return storage_->stage;
+}
+
+MapView StageStore::map(int stageIndex, int mapIndex) const {
+    const StageRecord& record = stage(stageIndex);
+
+    MapView view;
+    view.width = record.mapWidth;
+    view.height = record.mapHeight;
+    const std::size_t mapOffset = stageTileOffset(stageIndex) + view.tileCount() * static_cast<std::size_t>(mapIndex);
+    if (storage_->tileBytes == 1) {
+        view.narrowTiles = storage_->narrowTiles.data() + mapOffset;
+    } else {
+        view.tiles = storage_->tiles.data() + mapOffset;
+    }
+    return view;
+}
+
+void StageStore::readStageTiles(int stageIndex, Tile* tiles) const {
+    const std::size_t tileCount = stageTileCount(stageIndex);
+    visitStageTiles(stageIndex, [&](const auto* stageTiles) {
+        std::copy(stageTiles, stageTiles + tileCount, tiles);
+    });
+}
+
+void StageStore::writeStageTiles(int stageIndex, const Tile* tiles) {
+    const std::size_t tileCount = stageTileCount(stageIndex);
+    visitStageTiles(stageIndex, [&](auto* stageTiles) {
+        using TileT = std::remove_pointer_t<decltype(stageTiles)>;
+        std::transform(tiles, tiles + tileCount, stageTiles, [](Tile tile) { return static_cast<TileT>(tile); });
+    });
+}
+
+std::size_t StageStore::stageTileCount(int /*stageIndex*/) const {
+    return storage_->stageTileCount;
+}
+
+std::size_t StageStore::memoryUsageBytes() const {
+    return storage_ ? sizeof(Storage) + storage_->arenaBytes : 0;
+}
+
+void fillInitialStageLayout(Tile* stageTiles, int mapWidth, int mapHeight, int mapCount) {
+    fillInitialLayout(stageTiles, mapWidth, mapHeight, mapCount);
+}
+
+void fillInitialStageLayout(NarrowTile* stageTiles, int mapWidth, int mapHeight, int mapCount) {
+    fillInitialLayout(stageTiles, mapWidth, mapHeight, mapCount);
+}
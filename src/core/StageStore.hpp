@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Tile numbers stay small (map 1 uses 1..width, map 2 uses 101..100 + width),
+// so 16 bits cover every layout the generator produces.
+using Tile = std::uint16_t;
+// How a StageStore keeps the tiles of a batch whose numbers all fit in a byte.
+using NarrowTile = std::uint8_t;
+
+inline constexpr int kMultiplayerMapTileOffset = 100;
+inline constexpr int kMaxMapWidth = 0xFFFF - kMultiplayerMapTileOffset;
+
+// Bytes per stored tile for stages of mapCount maps of mapWidth: 1 while the
+// largest number of the initial layout (and so of any shuffle of it),
+// 100 * (mapCount - 1) + mapWidth, fits in a byte, 2 otherwise.
+constexpr int getStageTileBytes(int mapWidth, int mapCount) {
+    const int maxTile = kMultiplayerMapTileOffset * (mapCount > 1 ? mapCount - 1 : 0) + mapWidth;
+    return maxTile <= 0xFF ? 1 : 2;
+}
+
+// Tallest maps for which a stage of mapCount maps of mapWidth still has at
+// most INT_MAX tiles, the range of the int tile counts used per stage.
+constexpr int getMaxMapHeight(int mapWidth, int mapCount) {
+    const int tilesPerRow = (mapWidth > 0 ? mapWidth : 1) * (mapCount > 0 ? mapCount : 1);
+    return std::numeric_limits<int>::max() / tilesPerRow;
+}
+
+struct MapView {
+    int width = 0;
+    int height = 0;
+    // Exactly one is set: narrowTiles for maps kept one byte per tile.
+    const Tile* tiles = nullptr;
+    const NarrowTile* narrowTiles = nullptr;
+
+    std::size_t tileCount() const {
+        return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    }
+
+    Tile tileAt(std::size_t tileIndex) const {
+        return narrowTiles != nullptr ? narrowTiles[tileIndex] : tiles[tileIndex];
+    }
+
+    // Calls visit with whichever tile pointer is set, so per-tile loops are
+    // compiled once per tile width instead of testing it on every tile.
+    template <typename Visitor>
+    decltype(auto) visitTiles(Visitor&& visit) const {
+        if (narrowTiles != nullptr) {
+            return visit(narrowTiles);
+        }
+        return visit(tiles);
+    }
+};
+
+// Size of a stage. Every stage of a StageStore has the same size, so the store
+// keeps a single record instead of one per stage.
+struct StageRecord {
+    std::int32_t mapWidth = 0;
+    std::int32_t mapHeight = 0;
+    std::int32_t mapCount = 0;
+};
+
+// Storage for a whole batch: every tile of every stage lives in one contiguous
+// buffer, the maps of a stage back to back, and stage i starts at
+// i * stageTileCount. The buffer is carved out of a single monotonic arena
+// sized up front, so a batch costs one heap allocation no matter how many
+// stages it holds.
+//
+// The tile buffer holds NarrowTile when getStageTileBytes allows it for the
+// batch, which covers every single-mode width up to 255 and multi-mode width
+// up to 155, and Tile otherwise.
+class StageStore {
+public:
+    StageStore() = default;
+
+    // Lays out stageCount stages of mapCountPerStage maps each and fills them
+    // with the initial layout (see fillInitialStageLayout).
+    void reset(int stageCount, int mapCountPerStage, int mapWidth, int mapHeight);
+    void clear();
+
+    bool empty() const;
+    int stageCount() const;
+
+    // 1 if the batch keeps NarrowTile, 2 if it keeps Tile.
+    int tileBytes() const;
+
+    // The same record for every stage of the batch.
+    const StageRecord& stage(int stageIndex) const;
+    MapView map(int stageIndex, int mapIndex) const;
+
+    // Calls visit with all tiles of one stage, maps stacked on top of each
+    // other, as NarrowTile* or Tile* (const for a const store) depending on
+    // tileBytes().
+    template <typename Visitor>
+    decltype(auto) visitStageTiles(int stageIndex, Visitor&& visit) {
+        const std::size_t tileOffset = stageTileOffset(stageIndex);
+        if (storage_->tileBytes == 1) {
+            return visit(storage_->narrowTiles.data() + tileOffset);
+        }
+        return visit(storage_->tiles.data() + tileOffset);
+    }
+
+    template <typename Visitor>
+    decltype(auto) visitStageTiles(int stageIndex, Visitor&& visit) const {
+        const std::size_t tileOffset = stageTileOffset(stageIndex);
+        if (storage_->tileBytes == 1) {
+            return visit(static_cast<const NarrowTile*>(storage_->narrowTiles.data() + tileOffset));
+        }
+        return visit(static_cast<const Tile*>(storage_->tiles.data() + tileOffset));
+    }
+
+    // Copies one stage out to, or in from, stageTileCount Tile values.
+    void readStageTiles(int stageIndex, Tile* tiles) const;
+    void writeStageTiles(int stageIndex, const Tile* tiles);
+    std::size_t stageTileCount(int stageIndex) const;
+
+    // Bytes reserved from the heap for this batch.
+    std::size_t memoryUsageBytes() const;
+
+private:
+    struct Storage {
+        explicit Storage(std::size_t arenaBytes)
+            : arena(arenaBytes) {}
+
+        std::size_t arenaBytes = 0;
+        int tileBytes = 2;
+        int stageCount = 0;
+        StageRecord stage;
+        std::size_t stageTileCount = 0;
+        std::pmr::monotonic_buffer_resource arena;
+        // Only the one matching tileBytes is filled.
+        std::pmr::vector<Tile> tiles{&arena};
+        std::pmr::vector<NarrowTile> narrowTiles{&arena};
+    };
+
+    std::size_t stageTileOffset(int stageIndex) const {
+        return storage_->stageTileCount * static_cast<std::size_t>(stageIndex);
+    }
+
+    std::unique_ptr<Storage> storage_;
+};
+
+// Map m of a stage starts as rows of 1..width shifted by m * 100, i.e. the
+// same numbers multi mode pools across its maps before shuffling.
+// NarrowTile only holds it while getStageTileBytes is 1.
+void fillInitialStageLayout(Tile* stageTiles, int mapWidth, int mapHeight, int mapCount);
+void fillInitialStageLayout(NarrowTile* stageTiles, int mapWidth, int mapHeight, int mapCount);
+
+// Fills window with stages [firstStageIndex, firstStageIndex +
+// windowStageCount) of a batch, for exporters that write a batch one window
+// at a time. Returning false stops the export.
+using StageWindowFiller = std::function<bool(int firstStageIndex, int windowStageCount, StageStore& window)>;
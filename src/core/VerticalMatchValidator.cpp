@@ -0,0 +1,277 @@
+#include "core/VerticalMatchValidator.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TILE_VALIDATOR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define TILE_VALIDATOR_X86 0
+#endif
+
+#if TILE_VALIDATOR_X86 && (defined(__GNUC__) || defined(__clang__))
+#define TILE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TILE_TARGET_AVX2
+#endif
+
+namespace {
+template <typename Tile>
+bool hasVerticalMatchScalar(const Tile* tiles, std::size_t begin, std::size_t compareCount, std::size_t width) {
+    for (std::size_t index = begin; index < compareCount; ++index) {
+        if (tiles[index] == tiles[index + width]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if TILE_VALIDATOR_X86
+template <typename Tile>
+__m128i compareEqual128(__m128i upper, __m128i lower) {
+    if constexpr (sizeof(Tile) == 1) {
+        return _mm_cmpeq_epi8(upper, lower);
+    } else if constexpr (sizeof(Tile) == 2) {
+        return _mm_cmpeq_epi16(upper, lower);
+    } else {
+        return _mm_cmpeq_epi32(upper, lower);
+    }
+}
+
+template <typename Tile>
+bool hasVerticalMatchSse2(const Tile* tiles, std::size_t compareCount, std::size_t width) {
+    constexpr std::size_t kLanes = sizeof(__m128i) / sizeof(Tile);
+
+    std::size_t index = 0;
+    for (; index + kLanes <= compareCount; index += kLanes) {
+        const __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + index));
+        const __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + index + width));
+        if (_mm_movemask_epi8(compareEqual128<Tile>(upper, lower)) != 0) {
+            return true;
+        }
+    }
+    return hasVerticalMatchScalar(tiles, index, compareCount, width);
+}
+
+template <typename Tile>
+TILE_TARGET_AVX2 __m128i compareEqual128Avx(__m128i upper, __m128i lower) {
+    if constexpr (sizeof(Tile) == 1) {
+        return _mm_cmpeq_epi8(upper, lower);
+    } else if constexpr (sizeof(Tile) == 2) {
+        return _mm_cmpeq_epi16(upper, lower);
+    } else {
+        return _mm_cmpeq_epi32(upper, lower);
+    }
+}
+
+template <typename Tile>
+TILE_TARGET_AVX2 __m256i compareEqual256(__m256i upper, __m256i lower) {
+    if constexpr (sizeof(Tile) == 1) {
+        return _mm256_cmpeq_epi8(upper, lower);
+    } else if constexpr (sizeof(Tile) == 2) {
+        return _mm256_cmpeq_epi16(upper, lower);
+    } else {
+        return _mm256_cmpeq_epi32(upper, lower);
+    }
+}
+
+template <typename Tile>
+TILE_TARGET_AVX2 bool hasVerticalMatchAvx2(const Tile* tiles, std::size_t compareCount, std::size_t width) {
+    constexpr std::size_t kLanes = sizeof(__m256i) / sizeof(Tile);
+
+    std::size_t index = 0;
+    for (; index + kLanes <= compareCount; index += kLanes) {
+        const __m256i upper = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tiles + index));
+        const __m256i lower = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tiles + index + width));
+        if (_mm256_movemask_epi8(compareEqual256<Tile>(upper, lower)) != 0) {
+            return true;
+        }
+    }
+
+    // Finish with a 128-bit step compiled in this AVX2 function (VEX encoded)
+    // rather than calling the SSE2 kernel, which would mix legacy SSE and AVX
+    // instructions and pay a state transition on some CPUs.
+    constexpr std::size_t kHalfLanes = kLanes / 2;
+    if (index + kHalfLanes <= compareCount) {
+        const __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + index));
+        const __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + index + width));
+        if (_mm_movemask_epi8(compareEqual128Avx<Tile>(upper, lower)) != 0) {
+            return true;
+        }
+        index += kHalfLanes;
+    }
+    return hasVerticalMatchScalar(tiles, index, compareCount, width);
+}
+
+bool cpuSupportsAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int registers[4] = {};
+    __cpuid(registers, 0);
+    if (registers[0] < 7) {
+        return false;
+    }
+
+    __cpuid(registers, 1);
+    const bool osSavesYmm = (registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesYmm) {
+        return false;
+    }
+
+    __cpuidex(registers, 7, 0);
+    return (registers[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+bool cpuSupportsSse2() {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int registers[4] = {};
+    __cpuid(registers, 1);
+    return (registers[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") != 0;
+#endif
+}
+#endif
+
+SimdLevel clampToSupportedLevel(SimdLevel requested) {
+    static const SimdLevel supported = detectSimdLevel();
+    return static_cast<int>(requested) < static_cast<int>(supported) ? requested : supported;
+}
+
+template <typename Tile>
+bool hasVerticalMatchDispatch(SimdLevel level, const Tile* tiles, int width, int height) {
+    if (tiles == nullptr || width <= 0 || height <= 1) {
+        return false;
+    }
+
+    const std::size_t columnCount = static_cast<std::size_t>(width);
+    const std::size_t compareCount = columnCount * static_cast<std::size_t>(height - 1);
+
+    switch (level) {
+#if TILE_VALIDATOR_X86
+    case SimdLevel::Avx2:
+        return hasVerticalMatchAvx2(tiles, compareCount, columnCount);
+    case SimdLevel::Sse2:
+        return hasVerticalMatchSse2(tiles, compareCount, columnCount);
+#endif
+    default:
+        return hasVerticalMatchScalar(tiles, 0, compareCount, columnCount);
+    }
+}
+
+template <typename Tile>
+int validateCandidatesImpl(
+    const Tile* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+) {
+    const SimdLevel level = clampToSupportedLevel(SimdLevel::Avx2);
+    int firstValidCandidate = -1;
+
+    for (int candidate = 0; candidate < candidateCount; ++candidate) {
+        const Tile* tiles = candidates + static_cast<std::size_t>(candidate) * candidateStride;
+        const bool hasMatch = hasVerticalMatchDispatch(level, tiles, width, height);
+        if (hasMatchOut != nullptr) {
+            hasMatchOut[candidate] = hasMatch ? 1 : 0;
+        }
+        if (!hasMatch && firstValidCandidate < 0) {
+            firstValidCandidate = candidate;
+            if (hasMatchOut == nullptr) {
+                break;
+            }
+        }
+    }
+
+    return firstValidCandidate;
+}
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#if TILE_VALIDATOR_X86
+    if (cpuSupportsAvx2()) {
+        return SimdLevel::Avx2;
+    }
+    if (cpuSupportsSse2()) {
+        return SimdLevel::Sse2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* getSimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "Scalar";
+    }
+}
+
+bool hasVerticalMatch(const std::int32_t* tiles, int width, int height) {
+    return hasVerticalMatchWithLevel(SimdLevel::Avx2, tiles, width, height);
+}
+
+bool hasVerticalMatch(const std::uint16_t* tiles, int width, int height) {
+    return hasVerticalMatchWithLevel(SimdLevel::Avx2, tiles, width, height);
+}
+
+bool hasVerticalMatch(const std::uint8_t* tiles, int width, int height) {
+    return hasVerticalMatchWithLevel(SimdLevel::Avx2, tiles, width, height);
+}
+
+bool hasVerticalMatchWithLevel(SimdLevel level, const std::int32_t* tiles, int width, int height) {
+    return hasVerticalMatchDispatch(clampToSupportedLevel(level), tiles, width, height);
+}
+
+bool hasVerticalMatchWithLevel(SimdLevel level, const std::uint16_t* tiles, int width, int height) {
+    return hasVerticalMatchDispatch(clampToSupportedLevel(level), tiles, width, height);
+}
+
+bool hasVerticalMatchWithLevel(SimdLevel level, const std::uint8_t* tiles, int width, int height) {
+    return hasVerticalMatchDispatch(clampToSupportedLevel(level), tiles, width, height);
+}
+
+int validateCandidates(
+    const std::int32_t* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+) {
+    return validateCandidatesImpl(candidates, candidateCount, candidateStride, width, height, hasMatchOut);
+}
+
+int validateCandidates(
+    const std::uint16_t* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+) {
+    return validateCandidatesImpl(candidates, candidateCount, candidateStride, width, height, hasMatchOut);
+}
+
+int validateCandidates(
+    const std::uint8_t* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+) {
+    return validateCandidatesImpl(candidates, candidateCount, candidateStride, width, height, hasMatchOut);
+}
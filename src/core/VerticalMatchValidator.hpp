@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Checks a row-major tile map for a tile that equals the tile directly below
+// it. Row r and row r + 1 are compared a whole SIMD register at a time: for a
+// flat map the comparison is simply tiles[i] == tiles[i + width] for every i
+// in [0, (height - 1) * width), so no per-element bounds test is needed.
+//
+// The widest instruction set the CPU supports (AVX2, SSE2, or plain scalar
+// code) is picked once at runtime.
+
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+SimdLevel detectSimdLevel();
+const char* getSimdLevelName(SimdLevel level);
+
+bool hasVerticalMatch(const std::int32_t* tiles, int width, int height);
+bool hasVerticalMatch(const std::uint16_t* tiles, int width, int height);
+bool hasVerticalMatch(const std::uint8_t* tiles, int width, int height);
+
+// Same check on an explicit instruction set, for benchmarks and comparisons.
+// Levels the CPU does not support fall back to the next narrower one.
+bool hasVerticalMatchWithLevel(SimdLevel level, const std::int32_t* tiles, int width, int height);
+bool hasVerticalMatchWithLevel(SimdLevel level, const std::uint16_t* tiles, int width, int height);
+bool hasVerticalMatchWithLevel(SimdLevel level, const std::uint8_t* tiles, int width, int height);
+
+// Validates candidateCount maps of the same size stored candidateStride
+// elements apart. hasMatchOut[i] is set to 1 when candidate i has a vertical
+// match and 0 otherwise. Returns the index of the first candidate without a
+// match, or -1 when every candidate has one. With a null hasMatchOut the scan
+// stops at that first valid candidate.
+int validateCandidates(
+    const std::int32_t* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+);
+int validateCandidates(
+    const std::uint16_t* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+);
+int validateCandidates(
+    const std::uint8_t* candidates,
+    int candidateCount,
+    std::size_t candidateStride,
+    int width,
+    int height,
+    std::uint8_t* hasMatchOut
+);
@@ -0,0 +1,125 @@
+#include "core/WorkStealingPool.hpp"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threadCount = std::max(1, threadCount);
+
+    queues_.reserve(threadCount);
+    for (int workerIndex = 0; workerIndex < threadCount; ++workerIndex) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    threads_.reserve(threadCount);
+    for (int workerIndex = 0; workerIndex < threadCount; ++workerIndex) {
+        threads_.emplace_back(&WorkStealingPool::workerLoop, this, workerIndex);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(batchMutex_);
+        stopping_ = true;
+    }
+    batchStarted_.notify_all();
+
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(int taskCount, const std::function<void(int taskIndex)>& task) {
+    if (taskCount <= 0) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(batchMutex_);
+
+    // Deal tasks round-robin so the workers advance through the index range
+    // together and tasks finish roughly in index order, which lets in-order
+    // consumers such as the streaming CSV exporter keep up with generation.
+    const int workerCount = threadCount();
+    for (int workerIndex = 0; workerIndex < workerCount; ++workerIndex) {
+        WorkerQueue& queue = *queues_[workerIndex];
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        for (int taskIndex = workerIndex; taskIndex < taskCount; taskIndex += workerCount) {
+            queue.tasks.push_back(taskIndex);
+        }
+    }
+
+    remainingTasks_ = taskCount;
+    batchTask_ = &task;
+    ++batchGeneration_;
+    batchStarted_.notify_all();
+
+    batchFinished_.wait(lock, [this] {
+        return remainingTasks_ == 0 && activeWorkers_ == 0;
+    });
+    batchTask_ = nullptr;
+}
+
+bool WorkStealingPool::popOrSteal(int workerIndex, int& taskIndex) {
+    {
+        WorkerQueue& ownQueue = *queues_[workerIndex];
+        std::lock_guard<std::mutex> lock(ownQueue.mutex);
+        if (!ownQueue.tasks.empty()) {
+            taskIndex = ownQueue.tasks.front();
+            ownQueue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    const int workerCount = threadCount();
+    for (int offset = 1; offset < workerCount; ++offset) {
+        WorkerQueue& victim = *queues_[(workerIndex + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            taskIndex = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int workerIndex) {
+    std::uint64_t seenGeneration = 0;
+
+    for (;;) {
+        const std::function<void(int)>* task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(batchMutex_);
+            batchStarted_.wait(lock, [&] {
+                return stopping_ || batchGeneration_ != seenGeneration;
+            });
+            if (stopping_) {
+                return;
+            }
+
+            seenGeneration = batchGeneration_;
+            task = batchTask_;
+            if (task == nullptr) {
+                continue;
+            }
+            ++activeWorkers_;
+        }
+
+        int completedTasks = 0;
+        int taskIndex = 0;
+        while (popOrSteal(workerIndex, taskIndex)) {
+            (*task)(taskIndex);
+            ++completedTasks;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(batchMutex_);
+            remainingTasks_ -= completedTasks;
+            --activeWorkers_;
+        }
+        batchFinished_.notify_all();
+    }
+}
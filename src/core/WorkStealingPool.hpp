@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool with one task deque per worker. Owners pop from the front of
+// their own deque and idle workers steal from the back of the others, so stages
+// with long retry loops do not leave the rest of the cores waiting.
+class WorkStealingPool {
+public:
+    // A threadCount of 0 or less uses one worker per hardware thread.
+    explicit WorkStealingPool(int threadCount = 0);
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool();
+
+    int threadCount() const {
+        return static_cast<int>(threads_.size());
+    }
+
+    // Runs task(0) .. task(taskCount - 1) across the workers and blocks until
+    // every task has returned. Must not be called from inside a task.
+    void parallelFor(int taskCount, const std::function<void(int taskIndex)>& task);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    bool popOrSteal(int workerIndex, int& taskIndex);
+    void workerLoop(int workerIndex);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex batchMutex_;
+    std::condition_variable batchStarted_;
+    std::condition_variable batchFinished_;
+    const std::function<void(int)>* batchTask_ = nullptr;
+    std::uint64_t batchGeneration_ = 0;
+    int remainingTasks_ = 0;
+    int activeWorkers_ = 0;
+    bool stopping_ = false;
+};
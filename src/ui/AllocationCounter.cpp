@@ -0,0 +1,160 @@
+#include "ui/AllocationCounter.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace {
+// Constant-initialized, so counting needs no TLS guard and works during
+// static initialization.
+thread_local AllocationCount threadAllocations;
+
+void countAllocation(std::size_t size) {
+    ++threadAllocations.count;
+    threadAllocations.bytes += size;
+}
+
+void* allocateCounted(std::size_t size) {
+    countAllocation(size);
+    // malloc(0) may return null; operator new must not.
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* allocateCountedAligned(std::size_t size, std::align_val_t alignment) {
+    countAllocation(size);
+    const std::size_t alignmentBytes = static_cast<std::size_t>(alignment);
+#if defined(_WIN32)
+    return _aligned_malloc(size == 0 ? 1 : size, alignmentBytes);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    const std::size_t paddedSize = (std::max<std::size_t>(size, 1) + alignmentBytes - 1) / alignmentBytes * alignmentBytes;
+    return std::aligned_alloc(alignmentBytes, paddedSize);
+#endif
+}
+
+void freeAligned(void* pointer) {
+#if defined(_WIN32)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* allocateOrThrow(std::size_t size) {
+    void* pointer = allocateCounted(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* allocateAlignedOrThrow(std::size_t size, std::align_val_t alignment) {
+    void* pointer = allocateCountedAligned(size, alignment);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* imguiAllocate(std::size_t size, void*) {
+    return allocateCounted(size);
+}
+
+void imguiFree(void* pointer, void*) {
+    std::free(pointer);
+}
+} // namespace
+
+AllocationCount getThreadAllocationCount() {
+    return threadAllocations;
+}
+
+void installImGuiAllocationCounter() {
+    ImGui::SetAllocatorFunctions(imguiAllocate, imguiFree, nullptr);
+}
+
+void* operator new(std::size_t size) {
+    return allocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateCounted(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateCounted(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateCountedAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateCountedAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(pointer);
+}
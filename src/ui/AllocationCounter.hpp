@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made by the calling thread: every operator new (the UI
+// executable replaces the global allocation functions) plus ImGui's own
+// allocator once installImGuiAllocationCounter has run. The counters are
+// thread_local, so worker threads pay one increment and the render thread
+// sees only its own allocations.
+struct AllocationCount {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+};
+
+AllocationCount getThreadAllocationCount();
+
+// Routes ImGui::MemAlloc through the counter. Call before ImGui::CreateContext.
+void installImGuiAllocationCounter();
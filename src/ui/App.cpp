@@ -1,5 +1,26 @@
 #include "ui/App.hpp"
 
+#include "core/BoundedMpmcQueue.hpp"
+#include "core/GenerationMetrics.hpp"
+#include "core/LazyStageSource.hpp"
+#include "core/ParameterSweep.hpp"
+#include "core/StageCsvExporter.hpp"
+#include "core/StageCsvImporter.hpp"
+#include "core/StageGenerator.hpp"
+#include "core/StagePack.hpp"
+#include "core/StageRandom.hpp"
+#include "core/StageStatus.hpp"
+#include "core/StageStore.hpp"
+#include "core/WorkStealingPool.hpp"
+#include "ui/AllocationCounter.hpp"
+#include "ui/FrameProfiler.hpp"
+#include "ui/FrameScheduler.hpp"
+#include "ui/KoreanFontAtlas.hpp"
+#include "ui/LogBuffer.hpp"
+#include "ui/ParameterSweepView.hpp"
+#include "ui/StageThumbnailCache.hpp"
+#include "ui/TileGridRenderer.hpp"
+
 #include <imgui.h>
 #include <backends/imgui_impl_sdl2.h>
 #include <backends/imgui_impl_sdlrenderer2.h>
@@ -7,366 +28,961 @@
 #include <SDL.h>
 
 #include <algorithm>
-#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <cfloat>
+#include <cstdint>
 #include <cstdio>
-#include <filesystem>
-#include <fstream>
-#include <random>
-#include <sstream>
+#include <functional>
+#include <memory>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace {
-static constexpr ImWchar kKoreanRanges[] = {
-    0x0020, 0x00FF,
-    0x3131, 0x3163,
-    0xAC00, 0xD7A3,
-    0,
-};
+// A fully generated StageStore, a lazy source that generates the stages the
+// Viewer asks for, or a stage pack file opened through its memory mapping.
+struct GeneratedBatch {
+    StageStore stages;
+    LazyStageSource lazyStages;
+    StagePackReader pack;
+    bool isMultiplayerMode = false;
+    std::uint64_t masterSeed = 0;
+    // Tells in-memory batches apart for stageContentHash; 0 for none.
+    std::uint64_t batchId = 0;
+    // What stages of an in-memory batch are regenerated with.
+    ShuffleSettings shuffleSettings;
+    // Failed, locked and selected stages of an in-memory batch, and which of
+    // them changed since csvRows was written.
+    StageStatusTable status;
+    // Rows of the last CSV this batch was written to, if any.
+    StageCsvRowIndex csvRows;
+
+    // The pack stage the Viewer shows, unpacked once when it is selected.
+    std::vector<Tile> packStageTiles;
+    int packStageIndex = -1;
+    bool packStageChecksumValid = false;
+
+    bool isLazy() const {
+        return !lazyStages.empty();
+    }
 
-bool loadKoreanFontWithFallback() {
-    ImGuiIO& io = ImGui::GetIO();
-    io.Fonts->Clear();
-
-    const std::vector<std::string> candidates = {
-#if defined(_WIN32)
-        "C:/Windows/Fonts/malgun.ttf",
-        "C:/Windows/Fonts/NanumGothic.ttf",
-#elif defined(__APPLE__)
-        "/System/Library/Fonts/AppleSDGothicNeo.ttc",
-        "/Library/Fonts/NanumGothic.ttf",
-#else
-        "/usr/share/fonts/truetype/nanum/NanumGothic.ttf",
-        "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
-        "/usr/share/fonts/truetype/noto/NotoSansCJK-Regular.ttc",
-#endif
-    };
-
-    for (const auto& path : candidates) {
-        if (!std::filesystem::exists(path)) {
-            continue;
+    bool isPack() const {
+        return pack.isOpen();
+    }
+
+    // Only stages held in memory can be regenerated one by one.
+    bool canRegenerateStages() const {
+        return !stages.empty() && !isLazy() && !isPack() && status.stageCount() == stages.stageCount();
+    }
+
+    bool empty() const {
+        return stages.empty() && lazyStages.empty() && pack.stageCount() == 0;
+    }
+
+    int stageCount() const {
+        if (isPack()) {
+            return pack.stageCount();
         }
+        return isLazy() ? lazyStages.stageCount() : stages.stageCount();
+    }
 
-        if (io.Fonts->AddFontFromFileTTF(path.c_str(), 18.0f, nullptr, kKoreanRanges) != nullptr) {
-            return true;
+    int mapCount(int stageIndex) const {
+        if (isPack()) {
+            return pack.mapCountPerStage();
         }
+        return isLazy() ? lazyStages.mapCountPerStage() : stages.stage(stageIndex).mapCount;
     }
 
-    io.Fonts->AddFontDefault();
-    return false;
-}
+    MapView map(int stageIndex, int mapIndex) {
+        if (isPack()) {
+            selectPackStage(stageIndex);
+            MapView view;
+            view.width = pack.mapWidth();
+            view.height = pack.mapHeight();
+            view.tiles = packStageTiles.data() + static_cast<std::size_t>(mapIndex) * view.tileCount();
+            return view;
+        }
+        return isLazy() ? lazyStages.map(stageIndex, mapIndex) : stages.map(stageIndex, mapIndex);
+    }
+
+    StageThumbnailLayout thumbnailLayout(int stageIndex) const {
+        if (isPack()) {
+            return StageThumbnailLayout{pack.mapWidth(), pack.mapHeight(), pack.mapCountPerStage()};
+        }
+        if (isLazy()) {
+            const StageSourceSettings& settings = lazyStages.settings();
+            return StageThumbnailLayout{settings.mapWidth, settings.mapHeight, lazyStages.mapCountPerStage()};
+        }
+        const StageRecord& record = stages.stage(stageIndex);
+        return StageThumbnailLayout{record.mapWidth, record.mapHeight, record.mapCount};
+    }
+
+    // Identifies the tiles stage stageIndex holds right now without reading
+    // them, so it costs the same for any map size: the pack's CRC-32, the
+    // settings that determine every stage of a lazy batch, or the batch id
+    // and how often the stage was regenerated.
+    std::uint64_t stageContentHash(int stageIndex) const {
+        if (isPack()) {
+            return splitMix64(masterSeed ^ pack.stageChecksum(stageIndex));
+        }
+        if (isLazy()) {
+            const StageSourceSettings& settings = lazyStages.settings();
+            std::uint64_t hash = splitMix64(settings.masterSeed);
+            for (const std::uint64_t value : {
+                     static_cast<std::uint64_t>(settings.mapWidth),
+                     static_cast<std::uint64_t>(settings.mapHeight),
+                     static_cast<std::uint64_t>(settings.isMultiplayerMode),
+                     static_cast<std::uint64_t>(settings.shuffleSettings.shuffleCount),
+                     static_cast<std::uint64_t>(settings.shuffleSettings.kernel),
+                     static_cast<std::uint64_t>(settings.shuffleSettings.rngBackend)}) {
+                hash = splitMix64(hash ^ value);
+            }
+            return hash;
+        }
+        return splitMix64(splitMix64(batchId) ^ status.revision(stageIndex));
+    }
 
-struct GeneratedMap {
-    int width = 0;
-    int height = 0;
-    std::vector<int> tiles;
+    // Tiles of stage stageIndex for its thumbnail, read into scratch: the
+    // Viewer's pack stage and lazy cache stay put, and a batch may keep its
+    // tiles one byte each.
+    const Tile* readThumbnailTiles(int stageIndex, std::vector<Tile>& scratch) const {
+        if (isPack()) {
+            scratch.resize(pack.stageTileCount());
+            return pack.readStageTiles(stageIndex, scratch.data()) ? scratch.data() : nullptr;
+        }
+        if (isLazy()) {
+            const StageSourceSettings& settings = lazyStages.settings();
+            scratch.resize(static_cast<std::size_t>(settings.mapWidth) * settings.mapHeight * lazyStages.mapCountPerStage());
+            generateStageTiles(
+                scratch.data(),
+                settings.mapWidth,
+                settings.mapHeight,
+                settings.isMultiplayerMode,
+                stageIndex,
+                settings.shuffleSettings,
+                settings.masterSeed,
+                checkStageConfigurationFeasibility(settings.mapWidth, settings.mapHeight, settings.isMultiplayerMode).isPossible
+            );
+            return scratch.data();
+        }
+        scratch.resize(stages.stageTileCount(stageIndex));
+        stages.readStageTiles(stageIndex, scratch.data());
+        return scratch.data();
+    }
+
+    void selectPackStage(int stageIndex) {
+        if (stageIndex == packStageIndex) {
+            return;
+        }
+
+        packStageIndex = stageIndex;
+        packStageTiles.assign(pack.stageTileCount(), Tile{0});
+        const bool unpacked = pack.readStageTiles(stageIndex, packStageTiles.data());
+        packStageChecksumValid = unpacked && pack.verifyStage(stageIndex);
+    }
 };
 
-struct StageData {
-    std::vector<GeneratedMap> maps;
+struct GenerationRequest {
+    int stageCount = 1;
+    int mapWidth = 3;
+    int mapHeight = 2;
+    int shuffleCount = 1;
+    ShuffleKernel shuffleKernel = ShuffleKernel::Fast;
+    RngBackend rngBackend = RngBackend::Mt19937;
+    bool isMultiplayerMode = false;
+    bool autoMapEnabled = false;
+    // Set up a LazyStageSource instead of generating every stage.
+    bool lazyGeneration = false;
+    // Regenerate stages that repeat an earlier one (full batches only).
+    bool rejectDuplicateStages = true;
+    std::uint64_t masterSeed = 0;
+    std::string exportTitle;
+    // Only writes lazyBatchToExport to a file; nothing is generated for the Viewer.
+    bool exportLazyBatchOnly = false;
+    bool exportAsStagePack = false;
+    StageSourceSettings lazyBatchToExport;
+    // Reads and validates this CSV instead of generating; nothing else is used.
+    std::string importCsvPath;
+    // Samples sweepSettings instead of generating and saves the table under
+    // exportTitle; stageCount is the number of cells.
+    bool runParameterSweep = false;
+    ParameterSweepSettings sweepSettings;
+    // Regenerates these stages of batchToFix in place and hands the batch
+    // back instead of generating; stageCount is the number of stages.
+    std::vector<int> stagesToRegenerate;
+    GeneratedBatch batchToFix;
+    // Logs phase timings and generator counters after the run, and saves them
+    // next to the CSV it wrote or read.
+    bool logMetrics = false;
 };
 
-int getMapCountPerStage(bool isMultiplayerMode) {
-    return isMultiplayerMode ? 2 : 1;
-}
+enum class GenerationEventKind {
+    Log,
+    Progress,
+    // A CSV import has counted its rows; totalStageCount replaces the request's.
+    StageCountKnown,
+};
 
-std::vector<GeneratedMap> createMapsForStage(int mapWidth, int mapHeight, int mapCountPerStage) {
-    std::vector<GeneratedMap> maps;
-    maps.reserve(mapCountPerStage);
+struct GenerationEvent {
+    GenerationEventKind kind = GenerationEventKind::Log;
+    int completedStageCount = 0;
+    int totalStageCount = 0;
+    std::string message;
+};
 
-    for (int mapIndex = 0; mapIndex < mapCountPerStage; ++mapIndex) {
-        GeneratedMap map;
-        map.width = mapWidth;
-        map.height = mapHeight;
-        map.tiles.reserve(mapWidth * mapHeight);
+// Runs createStages/shuffleStageMaps (and the auto-map CSV export) on a worker
+// thread. The render thread drains events every frame and takes the finished
+// stages in one move once the worker has published them.
+class GenerationJob {
+public:
+    GenerationJob() = default;
+    GenerationJob(const GenerationJob&) = delete;
+    GenerationJob& operator=(const GenerationJob&) = delete;
+
+    ~GenerationJob() {
+        cancel();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
 
-        for (int row = 0; row < mapHeight; ++row) {
-            for (int col = 0; col < mapWidth; ++col) {
-                map.tiles.push_back(col + 1);
-            }
+    bool start(GenerationRequest request) {
+        if (isRunning()) {
+            return false;
+        }
+        if (worker_.joinable()) {
+            worker_.join();
         }
 
-        maps.push_back(std::move(map));
+        totalStageCount_ = request.stageCount;
+        latestCompletedStageCount_ = 0;
+        progressUnit_ = request.runParameterSweep ? "cell(s)" : "stage(s)";
+        cancelRequested_.store(false, std::memory_order_relaxed);
+        finished_.store(false, std::memory_order_relaxed);
+        wakePending_.store(false, std::memory_order_relaxed);
+        running_ = true;
+        worker_ = std::thread(&GenerationJob::runWorker, this, std::move(request));
+        return true;
     }
 
-    return maps;
-}
+    void cancel() {
+        cancelRequested_.store(true, std::memory_order_relaxed);
+    }
 
-std::vector<StageData> createStages(
-    int stageCount,
-    int mapWidth,
-    int mapHeight,
-    bool isMultiplayerMode
-) {
-    const int mapCountPerStage = getMapCountPerStage(isMultiplayerMode);
-    std::vector<StageData> stages;
-    stages.reserve(stageCount);
+    bool isRunning() const {
+        return running_;
+    }
 
-    for (int stageIndex = 0; stageIndex < stageCount; ++stageIndex) {
-        StageData stage;
-        stage.maps = createMapsForStage(mapWidth, mapHeight, mapCountPerStage);
-        stages.push_back(std::move(stage));
+    bool isCancelRequested() const {
+        return cancelRequested_.load(std::memory_order_relaxed);
     }
 
-    return stages;
-}
+    int totalStageCount() const {
+        return totalStageCount_;
+    }
 
-void shuffleMapTiles(GeneratedMap& map, int shuffleCount, std::mt19937& rng) {
-    for (int shuffleIndex = 0; shuffleIndex < shuffleCount; ++shuffleIndex) {
-        std::shuffle(map.tiles.begin(), map.tiles.end(), rng);
+    int completedStageCount() const {
+        return latestCompletedStageCount_;
     }
-}
 
-bool hasVerticalMatchingTiles(const GeneratedMap& map) {
-    for (int row = 0; row < map.height; ++row) {
-        for (int col = 0; col < map.width; ++col) {
-            const int tileIndex = (row * map.width) + col;
-            const int currentTile = map.tiles[tileIndex];
+    // What completedStageCount() counts: stages, or cells of a sweep.
+    const char* progressUnit() const {
+        return progressUnit_;
+    }
 
-            if (row + 1 < map.height) {
-                const int belowTile = map.tiles[tileIndex + map.width];
-                if (currentTile == belowTile) {
-                    return true;
-                }
-            }
-        }
+    // Called from the worker (at most once between two poll() calls) when it
+    // has queued something for the render thread, so an idle render loop
+    // blocked waiting for input wakes up. Must be set before start().
+    void setWakeCallback(std::function<void()> wake) {
+        wake_ = std::move(wake);
     }
 
-    return false;
-}
+    // Forwards queued log lines to onLog. Returns true exactly once per job,
+    // when the worker has finished and its result has been moved into the
+    // caller's variables.
+    bool poll(const std::function<void(const std::string&)>& onLog, GeneratedBatch& batch) {
+        if (!running_) {
+            return false;
+        }
 
-bool hasVerticalMatchingTilesInAnyMap(const StageData& stage) {
-    for (const GeneratedMap& map : stage.maps) {
-        if (hasVerticalMatchingTiles(map)) {
-            return true;
+        // Re-arm the wake-up before draining: anything pushed after this
+        // point either gets drained below or wakes the render thread again.
+        wakePending_.store(false, std::memory_order_seq_cst);
+
+        // Read the flag before draining so every event the worker pushed
+        // before finishing is seen in this same call.
+        const bool finished = finished_.load(std::memory_order_acquire);
+
+        GenerationEvent event;
+        while (events_.tryPop(event)) {
+            if (event.kind == GenerationEventKind::Progress) {
+                latestCompletedStageCount_ = std::max(latestCompletedStageCount_, event.completedStageCount);
+            } else if (event.kind == GenerationEventKind::StageCountKnown) {
+                totalStageCount_ = event.totalStageCount;
+            } else {
+                onLog(event.message);
+            }
         }
-    }
 
-    return false;
-}
+        if (!finished) {
+            return false;
+        }
+
+        worker_.join();
+        running_ = false;
 
-bool shuffleMapTilesAvoidingVerticalMatches(GeneratedMap& map, int shuffleCount, std::mt19937& rng) {
-    static constexpr int kMaxShuffleAttempts = 3000;
+        if (!resultAvailable_) {
+            return false;
+        }
 
-    std::vector<int> originalTiles = map.tiles;
-    for (int attempt = 0; attempt < kMaxShuffleAttempts; ++attempt) {
-        map.tiles = originalTiles;
-        shuffleMapTiles(map, shuffleCount, rng);
+        std::swap(batch, result_);
+        result_ = GeneratedBatch{};
+        resultAvailable_ = false;
+        return true;
+    }
 
-        if (!hasVerticalMatchingTiles(map)) {
-            return true;
+    // Moves out the result of a finished sweep, once; poll() never reports
+    // a sweep because it leaves the Viewer's stages alone.
+    bool takeSweepResult(ParameterSweepResult& result) {
+        if (running_ || !sweepResultAvailable_) {
+            return false;
         }
+
+        result = std::move(sweepResult_);
+        sweepResult_ = ParameterSweepResult{};
+        sweepResultAvailable_ = false;
+        return true;
     }
 
-    map.tiles = std::move(originalTiles);
-    shuffleMapTiles(map, shuffleCount, rng);
-    return false;
-}
+private:
+    static constexpr std::size_t kEventQueueCapacity = 1024;
 
-bool shuffleMultiplayerTileNumbersAcrossMapsAvoidingVerticalMatches(
-    StageData& stage,
-    int shuffleCount,
-    std::mt19937& rng
-) {
-    static constexpr int kMaxShuffleAttempts = 3000;
+    void pushLog(std::string message) {
+        GenerationEvent event;
+        event.kind = GenerationEventKind::Log;
+        event.message = std::move(message);
 
-    if (stage.maps.size() < 2) {
-        return !hasVerticalMatchingTilesInAnyMap(stage);
+        // Log lines must not be dropped, so wait for the render thread to
+        // drain the queue. Give up only when the job is being torn down.
+        while (!events_.tryPush(event)) {
+            if (isCancelRequested()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        wakeRenderThread();
     }
 
-    std::vector<int> originalNumbers;
-    for (size_t mapIndex = 0; mapIndex < stage.maps.size(); ++mapIndex) {
-        const int mapOffset = static_cast<int>(mapIndex) * 100;
-        for (const int tile : stage.maps[mapIndex].tiles) {
-            originalNumbers.push_back(tile + mapOffset);
+    void pushProgress(int completedStageCount) {
+        GenerationEvent event;
+        event.kind = GenerationEventKind::Progress;
+        event.completedStageCount = completedStageCount;
+
+        // Progress is cumulative; a dropped update is superseded by the next.
+        if (events_.tryPush(std::move(event))) {
+            wakeRenderThread();
         }
     }
 
-    for (int attempt = 0; attempt < kMaxShuffleAttempts; ++attempt) {
-        std::vector<int> shuffledNumbers = originalNumbers;
-        for (int shuffleIndex = 0; shuffleIndex < shuffleCount; ++shuffleIndex) {
-            std::shuffle(shuffledNumbers.begin(), shuffledNumbers.end(), rng);
-        }
+    void pushStageCountKnown(int totalStageCount) {
+        GenerationEvent event;
+        event.kind = GenerationEventKind::StageCountKnown;
+        event.totalStageCount = totalStageCount;
 
-        size_t poolIndex = 0;
-        for (GeneratedMap& map : stage.maps) {
-            for (int& tile : map.tiles) {
-                tile = shuffledNumbers[poolIndex++];
+        // Sent once, before any progress, so it is not dropped.
+        while (!events_.tryPush(event)) {
+            if (isCancelRequested()) {
+                return;
             }
+            std::this_thread::yield();
         }
+        wakeRenderThread();
+    }
 
-        if (!hasVerticalMatchingTilesInAnyMap(stage)) {
-            return true;
+    void wakeRenderThread() {
+        if (wake_ && !wakePending_.exchange(true, std::memory_order_seq_cst)) {
+            wake_();
         }
     }
 
-    return false;
-}
+    void publishFinished() {
+        finished_.store(true, std::memory_order_release);
+        wakeRenderThread();
+    }
 
-std::string normalizeExportTitle(const std::string& rawTitle) {
-    std::string normalizedTitle;
-    normalizedTitle.reserve(rawTitle.size());
+    // Logs what the instrumentation recorded since the run reset it and saves
+    // it next to dataPath, unless that is empty.
+    void logMetrics(const GenerationRunInfo& run, const std::string& dataPath) {
+        const GenerationMetricsSnapshot metrics = snapshotGenerationMetrics();
+        for (std::string& line : formatGenerationMetrics(metrics, run)) {
+            pushLog(std::move(line));
+        }
+        if (dataPath.empty()) {
+            return;
+        }
 
-    for (char ch : rawTitle) {
-        if (std::isalnum(static_cast<unsigned char>(ch))) {
-            normalizedTitle.push_back(ch);
-        } else if (std::isspace(static_cast<unsigned char>(ch)) || ch == '-' || ch == '_') {
-            normalizedTitle.push_back('_');
+        const std::string metricsPath = getMetricsFileName(dataPath);
+        if (writeGenerationMetricsJson(metrics, run, metricsPath)) {
+            pushLog("[INFO] Metrics written to '" + metricsPath + "'.");
+        } else {
+            pushLog("[WARN] Failed to write '" + metricsPath + "'.");
         }
     }
 
-    while (!normalizedTitle.empty() && normalizedTitle.front() == '_') {
-        normalizedTitle.erase(normalizedTitle.begin());
-    }
-    while (!normalizedTitle.empty() && normalizedTitle.back() == '_') {
-        normalizedTitle.pop_back();
+    GenerationRunInfo describeRun(
+        const char* label,
+        const GenerationRequest& request,
+        std::chrono::steady_clock::time_point start
+    ) const {
+        GenerationRunInfo run;
+        run.label = label;
+        run.stageCount = request.stageCount;
+        run.mapWidth = request.mapWidth;
+        run.mapHeight = request.mapHeight;
+        run.isMultiplayerMode = request.isMultiplayerMode;
+        run.masterSeed = request.masterSeed;
+        run.workerThreadCount = pool_.threadCount();
+        run.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return run;
     }
 
-    return normalizedTitle;
-}
+    void runWorker(GenerationRequest request) {
+        // The Viewer's on-demand stages record too; this only drops what
+        // accumulated since the last run.
+        if (request.logMetrics) {
+            resetGenerationMetrics();
+        }
+        const auto runStart = std::chrono::steady_clock::now();
+
+        GenerationControl control;
+        control.cancelRequested = &cancelRequested_;
+        control.onStageCompleted = [this](int completedStageCount) {
+            pushProgress(completedStageCount);
+        };
+
+        if (request.exportLazyBatchOnly) {
+            const bool isMultiplayerMode = request.lazyBatchToExport.isMultiplayerMode;
+            const std::string outputPath = request.exportAsStagePack
+                ? getStagePackFileName(isMultiplayerMode, request.exportTitle)
+                : getStageCsvFileName(isMultiplayerMode, request.exportTitle);
+            pushLog(
+                "[INFO] Generating and exporting " + std::to_string(request.lazyBatchToExport.stageCount) +
+                " stage(s) window by window..."
+            );
+            if (exportLazyBatch(request.lazyBatchToExport, outputPath, request.exportAsStagePack, control)) {
+                const char* exportedWhat = request.exportAsStagePack ? "Stage pack" : "Stage CSV";
+                pushLog("[INFO] " + std::string(exportedWhat) + " exported to '" + outputPath + "'.");
+            }
+            publishFinished();
+            return;
+        }
 
-std::string getStageCsvFileName(bool isMultiplayerMode, const std::string& exportTitle) {
-    const std::string baseName = isMultiplayerMode ? "stages_multi_mode" : "stages_single_mode";
-    const std::string normalizedTitle = normalizeExportTitle(exportTitle);
+        if (!request.stagesToRegenerate.empty()) {
+            runRegeneration(std::move(request.batchToFix), request.stagesToRegenerate, control);
+            return;
+        }
 
-    if (normalizedTitle.empty()) {
-        return baseName + ".csv";
-    }
+        ShuffleSettings shuffleSettings;
+        shuffleSettings.shuffleCount = request.shuffleCount;
+        shuffleSettings.kernel = request.shuffleKernel;
+        shuffleSettings.rngBackend = request.rngBackend;
 
-    return baseName + "_" + normalizedTitle + ".csv";
-}
+        if (!request.importCsvPath.empty()) {
+            runCsvImport(request.importCsvPath, shuffleSettings, request.logMetrics, control);
+            return;
+        }
 
-std::string serializeMapForCsv(const GeneratedMap& map) {
-    std::ostringstream serializedMap;
+        if (request.runParameterSweep) {
+            runSweep(request.sweepSettings, request.exportTitle, control);
+            return;
+        }
 
-    for (int col = 0; col < map.width; ++col) {
-        if (col > 0) {
-            serializedMap << '^';
+        const int mapCountPerStage = getMapCountPerStage(request.isMultiplayerMode);
+        if (request.autoMapEnabled) {
+            shuffleSettings.shuffleCount = generateAutoMapShuffleCount(request.masterSeed);
+            pushLog("[INFO] Create Auto Map mode is enabled (random shuffle + auto CSV export).");
+            pushLog("[INFO] Create Auto Map randomized shuffle count to " + std::to_string(shuffleSettings.shuffleCount) + ".");
+        } else {
+            pushLog("[INFO] Shuffle count set to " + std::to_string(shuffleSettings.shuffleCount) + ".");
+        }
+        pushLog(
+            "[INFO] Master seed " + std::to_string(request.masterSeed) + ", " +
+            std::to_string(pool_.threadCount()) + " worker thread(s)."
+        );
+        if (shuffleSettings.kernel == ShuffleKernel::Fast) {
+            pushLog(
+                "[INFO] Fast shuffle kernel: one uniform pass (" +
+                std::string(shuffleSettings.rngBackend == RngBackend::Xoshiro256StarStar ? "xoshiro256**" : "mt19937") +
+                ") stands in for " + std::to_string(shuffleSettings.shuffleCount) + " pass(es)."
+            );
+        } else {
+            pushLog(
+                "[INFO] Legacy exact shuffle kernel: " + std::to_string(shuffleSettings.shuffleCount) +
+                " mt19937 pass(es) per map."
+            );
+        }
+
+        const ArrangementFeasibility feasibility = checkStageConfigurationFeasibility(
+            request.mapWidth,
+            request.mapHeight,
+            request.isMultiplayerMode
+        );
+        if (!feasibility.isPossible) {
+            pushLog(
+                "[WARN] " + describeImpossibleArrangement(feasibility) +
+                " Maps are shuffled without avoiding vertical matches."
+            );
         }
 
-        for (int row = 0; row < map.height; ++row) {
-            if (row > 0) {
-                serializedMap << '#';
+        const DistinctArrangementCount distinctStages = countDistinctStageArrangements(
+            request.mapWidth,
+            request.mapHeight,
+            request.isMultiplayerMode,
+            static_cast<std::uint64_t>(request.stageCount)
+        );
+        if (distinctStages.isExact) {
+            pushLog("[WARN] " + describeStageShortage(distinctStages, request.stageCount));
+        }
+
+        if (request.lazyGeneration) {
+            if (request.rejectDuplicateStages) {
+                pushLog("[INFO] Stages generated on demand are not checked for duplicates.");
             }
+            runLazyGeneration(request, shuffleSettings, runStart, control);
+            return;
+        }
 
-            const int tileIndex = row * map.width + col;
-            serializedMap << map.tiles[tileIndex];
+        std::unique_ptr<DuplicateStageFilter> duplicateFilter;
+        if (request.rejectDuplicateStages) {
+            duplicateFilter = std::make_unique<DuplicateStageFilter>(request.stageCount);
+            duplicateFilter->distinctStages = distinctStages;
         }
-    }
 
-    return serializedMap.str();
-}
+        StageStore stages = createStages(
+            request.stageCount,
+            request.mapWidth,
+            request.mapHeight,
+            request.isMultiplayerMode
+        );
 
-bool exportStagesToCsv(
-    const std::vector<StageData>& stages,
-    bool isMultiplayerMode,
-    const std::string& exportTitle,
-    std::string& outputPath
-) {
-    outputPath = getStageCsvFileName(isMultiplayerMode, exportTitle);
-    std::ofstream csvFile(outputPath);
-    if (!csvFile.is_open()) {
-        return false;
-    }
+        // Create Auto Map writes the CSV while the pool is still generating.
+        StreamingCsvExporter csvExporter;
+        StageCsvRowIndex csvRows;
+        const std::string outputCsvPath = getStageCsvFileName(request.isMultiplayerMode, request.exportTitle);
+        const bool csvExportStarted = request.autoMapEnabled &&
+            csvExporter.start(stages, request.isMultiplayerMode, request.masterSeed, outputCsvPath, &csvRows);
+        if (csvExportStarted) {
+            control.onStageGenerated = [&csvExporter](int stageIndex) {
+                csvExporter.markStageReady(stageIndex);
+            };
+        }
 
-    if (isMultiplayerMode) {
-        csvFile << "stage,width,height,map1,map2\n";
+        const int invalidMapCount = shuffleStageMaps(
+            stages,
+            shuffleSettings,
+            request.isMultiplayerMode,
+            request.masterSeed,
+            pool_,
+            control,
+            0,
+            duplicateFilter.get()
+        );
 
-        for (size_t stageIndex = 0; stageIndex < stages.size(); ++stageIndex) {
-            const StageData& stage = stages[stageIndex];
-            if (stage.maps.empty()) {
-                continue;
-            }
+        if (control.isCancelled()) {
+            csvExporter.abort();
+            pushLog("[WARN] Generation cancelled. Previously generated stages were kept.");
+            publishFinished();
+            return;
+        }
 
-            const GeneratedMap& firstMap = stage.maps[0];
-            const std::string secondMapCsv = (stage.maps.size() >= 2)
-                ? serializeMapForCsv(stage.maps[1])
-                : "";
+        pushLog("[INFO] Done.");
+        pushLog(
+            "[INFO] Created " + std::to_string(request.stageCount) +
+            " stage(s), each with " + std::to_string(mapCountPerStage) + " map(s), in " +
+            std::to_string(stages.memoryUsageBytes() / 1024) + " KiB of tile storage."
+        );
 
-            csvFile
-                << static_cast<int>(stageIndex) + 1 << ','
-                << firstMap.width << ','
-                << firstMap.height << ','
-                << serializeMapForCsv(firstMap) << ','
-                << secondMapCsv << '\n';
+        if (!request.autoMapEnabled) {
+            pushLog(
+                "[INFO] Shuffled " +
+                std::string(request.isMultiplayerMode ? "all maps" : "single map per stage") +
+                " " + std::to_string(shuffleSettings.shuffleCount) + " time(s)."
+            );
         }
-    } else {
-        csvFile << "stage,width,height,map\n";
 
-        for (size_t stageIndex = 0; stageIndex < stages.size(); ++stageIndex) {
-            const StageData& stage = stages[stageIndex];
-            if (stage.maps.empty()) {
-                continue;
+        if (invalidMapCount > 0) {
+            pushLog(
+                "[WARN] " + std::to_string(invalidMapCount) +
+                " map(s) could not avoid vertically adjacent equal numbers."
+            );
+        }
+        if (duplicateFilter) {
+            pushLog(
+                std::string(duplicateFilter->unresolvedDuplicateCount > 0 ? "[WARN] " : "[INFO] ") +
+                describeDuplicateStages(*duplicateFilter, request.stageCount)
+            );
+        }
+
+        if (request.autoMapEnabled) {
+            const bool csvExported = csvExportStarted && csvExporter.finish();
+
+            if (csvExported) {
+                pushLog("[INFO] Create Auto Map exported CSV to '" + outputCsvPath + "'.");
+                result_.csvRows = std::move(csvRows);
+            } else {
+                pushLog("[ERROR] Create Auto Map failed to export CSV.");
             }
+        }
+        if (request.logMetrics) {
+            const bool csvWritten = request.autoMapEnabled && csvExportStarted;
+            logMetrics(describeRun("generate", request, runStart), csvWritten ? outputCsvPath : std::string());
+        }
 
-            const GeneratedMap& map = stage.maps[0];
-            csvFile
-                << static_cast<int>(stageIndex) + 1 << ','
-                << map.width << ','
-                << map.height << ','
-                << serializeMapForCsv(map) << '\n';
+        // shuffleStageMaps only counts the failed stages; finding them costs a
+        // pass over the batch, so it is skipped when there are none.
+        result_.status.reset(stages.stageCount());
+        if (invalidMapCount > 0) {
+            result_.status.markFailedStages(stages, pool_);
         }
+        result_.stages = std::move(stages);
+        result_.isMultiplayerMode = request.isMultiplayerMode;
+        result_.masterSeed = request.masterSeed;
+        result_.batchId = ++lastBatchId_;
+        result_.shuffleSettings = shuffleSettings;
+        resultAvailable_ = true;
+        publishFinished();
     }
 
-    return true;
-}
-
-int shuffleStageMaps(std::vector<StageData>& stages, int shuffleCount, bool isMultiplayerMode) {
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    int invalidMapCount = 0;
+    // Regenerates stages of a batch the render thread handed over and hands
+    // it back, also when cancelled: the stages regenerated so far are kept.
+    void runRegeneration(GeneratedBatch batch, const std::vector<int>& stageIndices, const GenerationControl& control) {
+        pushLog(
+            "[INFO] Regenerating " + std::to_string(stageIndices.size()) + " stage(s) from revision seeds of master seed " +
+            std::to_string(batch.masterSeed) + "..."
+        );
+        const auto regenerationStart = std::chrono::steady_clock::now();
+        const StageRegenerationResult regenerated = regenerateStages(
+            batch.stages,
+            batch.status,
+            stageIndices,
+            batch.shuffleSettings,
+            batch.isMultiplayerMode,
+            batch.masterSeed,
+            pool_,
+            control
+        );
+        const double regenerationSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - regenerationStart).count();
 
-    for (StageData& stage : stages) {
-        if (stage.maps.empty()) {
-            continue;
+        if (control.isCancelled()) {
+            pushLog("[WARN] Regeneration cancelled. Stages regenerated so far were kept.");
+        }
+        char summary[160];
+        std::snprintf(
+            summary,
+            sizeof(summary),
+            "[INFO] Regenerated %d stage(s) in %.3f s; %d failed stage(s) left in the batch.",
+            regenerated.regeneratedStageCount,
+            regenerationSeconds,
+            batch.status.failedCount()
+        );
+        pushLog(summary);
+        if (regenerated.failedStageCount > 0) {
+            pushLog(
+                "[WARN] " + std::to_string(regenerated.failedStageCount) +
+                " regenerated stage(s) could not avoid vertically adjacent equal numbers."
+            );
+        }
+        if (regenerated.lockedStageCount > 0) {
+            pushLog("[INFO] " + std::to_string(regenerated.lockedStageCount) + " locked stage(s) were left as they are.");
+        }
+        if (regenerated.skippedStageCount > 0) {
+            pushLog(
+                "[WARN] " + std::to_string(regenerated.skippedStageCount) + " stage(s) do not have " +
+                std::to_string(getMapCountPerStage(batch.isMultiplayerMode)) + " map(s) and were left as they are."
+            );
+        }
+        if (batch.status.dirtyCount() > 0) {
+            pushLog(
+                "[INFO] " + std::to_string(batch.status.dirtyCount()) +
+                " stage(s) changed since the last CSV export; Create CSV File rewrites only their rows."
+            );
         }
 
-        if (isMultiplayerMode) {
-            for (GeneratedMap& map : stage.maps) {
-                shuffleMapTiles(map, shuffleCount, rng);
-            }
+        result_ = std::move(batch);
+        resultAvailable_ = true;
+        publishFinished();
+    }
 
-            if (!shuffleMultiplayerTileNumbersAcrossMapsAvoidingVerticalMatches(stage, shuffleCount, rng)) {
-                ++invalidMapCount;
+    // Only the CSV export (Create Auto Map) generates the whole batch, one
+    // window at a time; the Viewer generates the stages it shows.
+    void runLazyGeneration(
+        const GenerationRequest& request,
+        const ShuffleSettings& shuffleSettings,
+        std::chrono::steady_clock::time_point runStart,
+        const GenerationControl& control
+    ) {
+        StageSourceSettings settings;
+        settings.stageCount = request.stageCount;
+        settings.mapWidth = request.mapWidth;
+        settings.mapHeight = request.mapHeight;
+        settings.isMultiplayerMode = request.isMultiplayerMode;
+        settings.shuffleSettings = shuffleSettings;
+        settings.masterSeed = request.masterSeed;
+
+        if (request.autoMapEnabled) {
+            const std::string outputCsvPath = getStageCsvFileName(request.isMultiplayerMode, request.exportTitle);
+            if (exportLazyBatch(settings, outputCsvPath, false, control)) {
+                pushLog("[INFO] Create Auto Map exported CSV to '" + outputCsvPath + "'.");
+                if (request.logMetrics) {
+                    logMetrics(describeRun("lazy", request, runStart), outputCsvPath);
+                }
             }
-            continue;
+            if (control.isCancelled()) {
+                publishFinished();
+                return;
+            }
+        } else {
+            pushProgress(request.stageCount);
         }
 
-        if (!shuffleMapTilesAvoidingVerticalMatches(stage.maps[0], shuffleCount, rng)) {
-            ++invalidMapCount;
+        result_.lazyStages = LazyStageSource(settings);
+        result_.isMultiplayerMode = request.isMultiplayerMode;
+        result_.masterSeed = request.masterSeed;
+        pushLog(
+            "[INFO] " + std::to_string(request.stageCount) + " stage(s) are generated on demand; the Viewer keeps the " +
+            std::to_string(LazyStageSource::kDefaultCacheCapacity) + " most recently viewed in " +
+            std::to_string(result_.lazyStages.memoryUsageBytes() / 1024) + " KiB."
+        );
+        resultAvailable_ = true;
+        publishFinished();
+    }
+
+    // Loads the stages of a CSV into the Viewer and logs every vertical-match
+    // violation it holds, up to kMaxLoggedImportIssues of each kind.
+    void runCsvImport(
+        const std::string& path,
+        const ShuffleSettings& shuffleSettings,
+        bool recordMetrics,
+        const GenerationControl& control
+    ) {
+        static constexpr std::size_t kMaxLoggedImportIssues = 200;
+
+        StageCsvImportOptions options;
+        options.maxReportedIssues = kMaxLoggedImportIssues;
+        options.onStageCountKnown = [this](int stageCount) {
+            pushStageCountKnown(stageCount);
+        };
+
+        pushLog("[INFO] Importing '" + path + "'...");
+        const auto importStart = std::chrono::steady_clock::now();
+        StageCsvImportResult imported = importStagesCsv(path, pool_, options, control);
+        const double importSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - importStart).count();
+
+        if (imported.cancelled) {
+            pushLog("[WARN] Import cancelled. Previously generated stages were kept.");
+            publishFinished();
+            return;
         }
+        if (!imported.opened) {
+            pushLog("[ERROR] Failed to import stage CSV: " + imported.error);
+            publishFinished();
+            return;
+        }
+
+        for (const StageCsvParseError& error : imported.parseErrors) {
+            pushLog("[ERROR] Line " + std::to_string(error.lineNumber) + ": " + error.message);
+        }
+        for (const StageCellViolation& violation : imported.violations) {
+            pushLog(
+                "[WARN] Stage " + std::to_string(violation.stageNumber) + " map " + std::to_string(violation.mapNumber) +
+                ": rows " + std::to_string(violation.row) + " and " + std::to_string(violation.row + 1) +
+                " of column " + std::to_string(violation.column) + " both hold " + std::to_string(violation.tile) + "."
+            );
+        }
+
+        char summary[192];
+        std::snprintf(
+            summary,
+            sizeof(summary),
+            "[INFO] Imported %d %s-mode stage(s) of %d x %d (%.1f MB in %.3f s).",
+            imported.stageCount,
+            imported.isMultiplayerMode ? "multi" : "single",
+            imported.mapWidth,
+            imported.mapHeight,
+            static_cast<double>(imported.fileBytes) / (1024.0 * 1024.0),
+            importSeconds
+        );
+        pushLog(summary);
+        const bool clean = imported.violationCount == 0 && imported.parseErrorCount == 0;
+        pushLog(
+            std::string(clean ? "[INFO] " : "[WARN] ") + std::to_string(imported.violationCount) + " vertical match(es) in " +
+            std::to_string(imported.violatingMapCount) + " map(s), " + std::to_string(imported.parseErrorCount) +
+            " unreadable row(s)."
+        );
+        if (recordMetrics) {
+            GenerationRunInfo run;
+            run.label = "import";
+            run.stageCount = imported.stageCount;
+            run.mapWidth = imported.mapWidth;
+            run.mapHeight = imported.mapHeight;
+            run.isMultiplayerMode = imported.isMultiplayerMode;
+            run.masterSeed = imported.masterSeed;
+            run.workerThreadCount = pool_.threadCount();
+            run.wallSeconds = importSeconds;
+            logMetrics(run, path);
+        }
+
+        if (imported.stageCount == 0) {
+            pushLog("[WARN] The file holds no stages.");
+            publishFinished();
+            return;
+        }
+
+        result_.status.reset(imported.stages.stageCount());
+        if (imported.violationCount > 0) {
+            result_.status.markFailedStages(imported.stages, pool_);
+        }
+        result_.stages = std::move(imported.stages);
+        result_.isMultiplayerMode = imported.isMultiplayerMode;
+        result_.masterSeed = imported.masterSeed;
+        result_.batchId = ++lastBatchId_;
+        result_.shuffleSettings = shuffleSettings;
+        resultAvailable_ = true;
+        publishFinished();
     }
 
-    return invalidMapCount;
-}
+    // Samples every cell on the pool and writes the table next to the stage
+    // CSVs; the cells sampled before a cancel are still shown.
+    void runSweep(const ParameterSweepSettings& settings, const std::string& exportTitle, const GenerationControl& control) {
+        pushLog(
+            "[INFO] Sweeping widths " + std::to_string(settings.minMapWidth) + "-" + std::to_string(settings.maxMapWidth) +
+            ", heights " + std::to_string(settings.minMapHeight) + "-" + std::to_string(settings.maxMapHeight) +
+            ", " + std::to_string(settings.samplesPerCell) + " stage(s) per cell, master seed " +
+            std::to_string(settings.masterSeed) + "..."
+        );
+        ParameterSweepResult result = runParameterSweep(settings, pool_, control);
 
-int generateAutoMapShuffleCount() {
-    static constexpr int kAutoMapMinShuffleCount = 20;
-    static constexpr int kAutoMapMaxShuffleCount = 100000;
+        char summary[128];
+        std::snprintf(summary, sizeof(summary), "[INFO] Sampled %zu cell(s) in %.3f s.", result.cells.size(), result.wallSeconds);
+        if (result.cancelled) {
+            pushLog("[WARN] Parameter sweep cancelled. Cells not sampled yet are left empty.");
+        } else {
+            pushLog(summary);
+            const std::string outputPath = getParameterSweepFileName(exportTitle);
+            if (writeParameterSweepCsv(result, outputPath)) {
+                pushLog("[INFO] Parameter sweep written to '" + outputPath + "'.");
+            } else {
+                pushLog("[ERROR] Failed to write '" + outputPath + "'.");
+            }
+        }
 
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_int_distribution<int> distribution(kAutoMapMinShuffleCount, kAutoMapMaxShuffleCount);
-    return distribution(rng);
-}
+        sweepResult_ = std::move(result);
+        sweepResultAvailable_ = true;
+        publishFinished();
+    }
+
+    // Logs failures and cancellation itself; returns true if the CSV was written.
+    bool exportLazyBatch(
+        const StageSourceSettings& settings,
+        const std::string& outputPath,
+        bool asStagePack,
+        const GenerationControl& control
+    ) {
+        int invalidMapCount = 0;
+        const bool exported = asStagePack
+            ? writeLazyStagesPack(settings, outputPath, pool_, control, invalidMapCount)
+            : writeLazyStagesCsv(settings, outputPath, pool_, control, invalidMapCount);
+        if (control.isCancelled()) {
+            pushLog("[WARN] Generation cancelled. Previously generated stages were kept.");
+            return false;
+        }
+
+        if (invalidMapCount > 0) {
+            pushLog(
+                "[WARN] " + std::to_string(invalidMapCount) +
+                " map(s) could not avoid vertically adjacent equal numbers."
+            );
+        }
+        if (!exported) {
+            pushLog(asStagePack ? "[ERROR] Failed to export stage pack file." : "[ERROR] Failed to export stage CSV file.");
+        }
+        return exported;
+    }
+
+    WorkStealingPool pool_;
+    std::thread worker_;
+    std::atomic<bool> cancelRequested_{false};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> wakePending_{false};
+    std::function<void()> wake_;
+    BoundedMpmcQueue<GenerationEvent, kEventQueueCapacity> events_;
+
+    // Owned by the render thread.
+    bool running_ = false;
+    int totalStageCount_ = 0;
+    int latestCompletedStageCount_ = 0;
+    const char* progressUnit_ = "stage(s)";
+
+    // Written by the worker before finished_ is released, read after.
+    GeneratedBatch result_;
+    bool resultAvailable_ = false;
+    // Only touched by the worker; jobs never overlap.
+    std::uint64_t lastBatchId_ = 0;
+    ParameterSweepResult sweepResult_;
+    bool sweepResultAvailable_ = false;
+};
 
 } // namespace
 
 int AppUI::run() {
+    const auto launchTime = std::chrono::steady_clock::now();
     int stageCount = 1;
     int shuffleCount = 1;
+    int shuffleKernelIndex = 0;
+    int rngBackendIndex = 0;
     int mapWidth = 3;
     int mapHeight = 2;
     bool isMultiplayerMode = false;
-    bool generatedForMultiplayerMode = false;
-    std::vector<StageData> generatedStages;
+    std::uint64_t masterSeed = generateMasterSeed();
+    bool randomizeSeedEachRun = true;
+    GeneratedBatch generatedBatch;
     int currentStageIndex = 0;
+    // The Viewer's stage while its batch is away being regenerated, or -1.
+    int regeneratingFromStageIndex = -1;
     std::string exportTitle;
     bool autoMapEnabled = false;
-    std::vector<std::string> generationLogs = {
-        "[INFO] Ready.",
-        "[INFO] Waiting for generation tasks..."
-    };
+    bool lazyGenerationEnabled = false;
+    bool rejectDuplicateStages = true;
+    bool logGenerationMetrics = false;
+    int jumpToStageNumber = 1;
+    char stagePackPath[512] = "";
+    char stageCsvPath[512] = "";
+    LogBuffer generationLogs;
+    generationLogs.append("[INFO] Ready.");
+    generationLogs.append("[INFO] Waiting for generation tasks...");
+    LogFilter generationLogFilter;
+    bool showInfoLogs = true;
+    bool showWarningLogs = true;
+    bool showErrorLogs = true;
+    char logSearchText[128] = "";
+    GenerationJob generationJob;
+    TileLabelCache tileLabelCache;
+    int feasibilityMapWidth = 0;
+    int feasibilityMapHeight = 0;
+    bool feasibilityMultiplayerMode = false;
+    int feasibilityStageCount = 0;
+    ArrangementFeasibility feasibility;
+    DistinctArrangementCount distinctStages;
+    ParameterSweepSettings sweepSettings;
+    ParameterSweepResult sweepResult;
+    ParameterSweepViewState sweepViewState;
+    bool showParameterSweep = false;
+    bool showStageGallery = false;
+    int galleryThumbnailSize = 96;
+    std::vector<Tile> thumbnailTiles;
 
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         SDL_Log("SDL_Init failed: %s", SDL_GetError());
@@ -400,10 +1016,13 @@ int AppUI::run() {
     }
 
     IMGUI_CHECKVERSION();
+    installImGuiAllocationCounter();
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
 
-    const bool koreanFontLoaded = loadKoreanFontWithFallback();
+    KoreanFontAtlas fontAtlas;
+    const bool koreanFontLoaded = fontAtlas.load(18.0f);
+    const double initialFontBuildMs = fontAtlas.lastBuildMs();
 
     if (!ImGui_ImplSDL2_InitForSDLRenderer(window, renderer)) {
         SDL_Log("ImGui_ImplSDL2_InitForSDLRenderer failed");
@@ -424,11 +1043,41 @@ int AppUI::run() {
         return 1;
     }
 
+    StageThumbnailCache thumbnailCache(renderer);
+
+    // The generation worker posts this (at most once per frame) when it has
+    // queued logs or progress, so an idle loop blocked on input wakes up.
+    const Uint32 generationWakeEventType = SDL_RegisterEvents(1);
+    if (generationWakeEventType != static_cast<Uint32>(-1)) {
+        generationJob.setWakeCallback([generationWakeEventType] {
+            SDL_Event wakeEvent = {};
+            wakeEvent.type = generationWakeEventType;
+            SDL_PushEvent(&wakeEvent);
+        });
+    }
+
+    // Caret blink and other time-driven redraws while nothing else happens.
+    constexpr int kAnimationFrameIntervalMs = 100;
+
+    FrameScheduler frameScheduler;
+    bool showFrameRate = false;
+    FrameProfiler frameProfiler;
+    bool showPerformanceHud = false;
+    double timeToFirstFrameMs = 0.0;
+
     bool running = true;
     while (running) {
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        const int waitTimeoutMs = frameScheduler.waitTimeoutMs(FrameScheduler::Clock::now());
+        bool hasEvent = (waitTimeoutMs == 0)
+            ? SDL_PollEvent(&event) != 0
+            : SDL_WaitEventTimeout(&event, waitTimeoutMs) != 0;
+        while (hasEvent) {
+            frameScheduler.onEvent();
             ImGui_ImplSDL2_ProcessEvent(&event);
+            if (event.type == SDL_TEXTINPUT) {
+                fontAtlas.requestGlyphs(event.text.text);
+            }
             if (event.type == SDL_QUIT) {
                 running = false;
             }
@@ -437,11 +1086,44 @@ int AppUI::run() {
                 event.window.windowID == SDL_GetWindowID(window)) {
                 running = false;
             }
+            hasEvent = SDL_PollEvent(&event) != 0;
+        }
+
+        // Without generation wake-ups (registration failed) keep polling the
+        // job while it runs.
+        if (generationJob.isRunning() && generationWakeEventType == static_cast<Uint32>(-1)) {
+            frameScheduler.onEvent();
+        }
+        if (!frameScheduler.shouldRenderFrame(FrameScheduler::Clock::now())) {
+            continue;
+        }
+        frameProfiler.beginFrame();
+
+        const bool generationFinished = generationJob.poll(
+            [&](const std::string& log) {
+                generationLogs.append(log);
+                fontAtlas.requestGlyphs(log);
+            },
+            generatedBatch
+        );
+        if (generationFinished) {
+            currentStageIndex = std::max(0, regeneratingFromStageIndex);
         }
+        if (!generationJob.isRunning()) {
+            regeneratingFromStageIndex = -1;
+        }
+        if (generationJob.takeSweepResult(sweepResult)) {
+            showParameterSweep = true;
+        }
+
+        // Glyphs requested during the previous frame are baked before this one.
+        fontAtlas.rebuildIfNeeded();
+        frameProfiler.lap(FrameSection::Update);
 
         ImGui_ImplSDLRenderer2_NewFrame();
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
+        frameProfiler.lap(FrameSection::NewFrame);
 
         ImGui::Begin("Control Panel");
         ImGui::TextUnformatted("Stage Count");
@@ -458,6 +1140,13 @@ int AppUI::run() {
             shuffleCount = 1;
         }
 
+        static const char* const kShuffleKernelNames[] = {"Fast (one equivalent pass)", "Legacy exact (N passes)"};
+        static const char* const kRngBackendNames[] = {"mt19937", "xoshiro256**"};
+        ImGui::Combo("Shuffle Kernel", &shuffleKernelIndex, kShuffleKernelNames, IM_ARRAYSIZE(kShuffleKernelNames));
+        ImGui::BeginDisabled(shuffleKernelIndex != 0);
+        ImGui::Combo("Random Generator", &rngBackendIndex, kRngBackendNames, IM_ARRAYSIZE(kRngBackendNames));
+        ImGui::EndDisabled();
+
         const int mapCountPerStage = getMapCountPerStage(isMultiplayerMode);
         ImGui::Text(
             "Each stage contains %d map(s) in %s mode.",
@@ -472,22 +1161,24 @@ int AppUI::run() {
         if (mapWidth < 1) {
             mapWidth = 1;
         }
-        if (mapHeight < 1) {
-            mapHeight = 1;
+        if (mapWidth > kMaxMapWidth) {
+            // Tile numbers must fit in 16 bits.
+            mapWidth = kMaxMapWidth;
         }
+        mapHeight = std::clamp(mapHeight, 1, getMaxMapHeight(mapWidth, mapCountPerStage));
 
         ImGui::Separator();
         ImGui::TextUnformatted("Mode");
         const bool previousMultiplayerMode = isMultiplayerMode;
         ImGui::Checkbox("Multiplayer", &isMultiplayerMode);
         if (previousMultiplayerMode != isMultiplayerMode) {
-            if (!generatedStages.empty()) {
-                currentStageIndex = std::clamp(currentStageIndex, 0, static_cast<int>(generatedStages.size()) - 1);
+            if (!generatedBatch.empty()) {
+                currentStageIndex = std::clamp(currentStageIndex, 0, generatedBatch.stageCount() - 1);
             } else {
                 currentStageIndex = 0;
             }
 
-            generationLogs.push_back(
+            generationLogs.append(
                 "[INFO] Mode switched to " +
                 std::string(isMultiplayerMode ? "Multi" : "Single") +
                 ". Existing stages are unchanged. Press 'Start Making Stages' to regenerate with " +
@@ -497,6 +1188,42 @@ int AppUI::run() {
 
         ImGui::TextUnformatted(isMultiplayerMode ? "Current: Multi Mode" : "Current: Single Mode");
 
+        if (feasibilityMapWidth != mapWidth ||
+            feasibilityMapHeight != mapHeight ||
+            feasibilityMultiplayerMode != isMultiplayerMode ||
+            feasibilityStageCount != stageCount) {
+            feasibilityMapWidth = mapWidth;
+            feasibilityMapHeight = mapHeight;
+            feasibilityMultiplayerMode = isMultiplayerMode;
+            feasibilityStageCount = stageCount;
+            feasibility = checkStageConfigurationFeasibility(mapWidth, mapHeight, isMultiplayerMode);
+            distinctStages = feasibility.isPossible
+                ? countDistinctStageArrangements(mapWidth, mapHeight, isMultiplayerMode, static_cast<std::uint64_t>(stageCount))
+                : DistinctArrangementCount{};
+        }
+        if (!feasibility.isPossible) {
+            ImGui::TextColored(
+                ImVec4(1.0f, 0.4f, 0.3f, 1.0f),
+                "Impossible layout: %s",
+                describeImpossibleArrangement(feasibility).c_str()
+            );
+        } else if (distinctStages.isExact) {
+            ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "%s", describeStageShortage(distinctStages, stageCount).c_str());
+        }
+
+        ImGui::Separator();
+        ImGui::TextUnformatted("Seed");
+        ImGui::BeginDisabled(randomizeSeedEachRun);
+        ImGui::InputScalar("Master Seed", ImGuiDataType_U64, &masterSeed);
+        ImGui::EndDisabled();
+        ImGui::Checkbox("Randomize Seed Each Run", &randomizeSeedEachRun);
+        if (!generatedBatch.empty()) {
+            ImGui::Text(
+                "Current stages were generated with seed %llu.",
+                static_cast<unsigned long long>(generatedBatch.masterSeed)
+            );
+        }
+
         ImGui::Separator();
         ImGui::TextUnformatted("Create Map");
         ImGui::Text(
@@ -507,143 +1234,530 @@ int AppUI::run() {
         );
         ImGui::Checkbox("Enable Create Auto Map", &autoMapEnabled);
         ImGui::TextUnformatted("If enabled, Start Making Stages uses random shuffle (20-100000) and auto-exports CSV.");
-
+        ImGui::Checkbox("Generate Stages On Demand", &lazyGenerationEnabled);
+        ImGui::TextUnformatted(
+            "If enabled, the Viewer generates only the stages it shows; memory stays constant for any stage count."
+        );
+        ImGui::BeginDisabled(lazyGenerationEnabled);
+        ImGui::Checkbox("Reject Duplicate Stages", &rejectDuplicateStages);
+        ImGui::EndDisabled();
+        ImGui::TextUnformatted("If enabled, a stage equal to an earlier one is regenerated (not available on demand).");
+        ImGui::Checkbox("Log Generation Metrics", &logGenerationMetrics);
+        ImGui::TextUnformatted("If enabled, phase timings and counters are logged and saved as .metrics.json next to the CSV.");
+
+        const bool generationRunning = generationJob.isRunning();
+        ImGui::BeginDisabled(generationRunning);
         if (ImGui::Button("Start Making Stages")) {
-            generationLogs.clear();
-            generationLogs.push_back("[INFO] Generating " + std::to_string(stageCount) + " stage(s)...");
-
-            if (autoMapEnabled) {
-                const int autoMapShuffleCount = generateAutoMapShuffleCount();
-                generationLogs.push_back(
-                    "[INFO] Create Auto Map mode is enabled (random shuffle + auto CSV export)."
-                );
-                generationLogs.push_back(
-                    "[INFO] Create Auto Map randomized shuffle count to " +
-                    std::to_string(autoMapShuffleCount) + "."
-                );
+            if (randomizeSeedEachRun) {
+                masterSeed = generateMasterSeed();
+            }
 
-                generatedStages = createStages(stageCount, mapWidth, mapHeight, isMultiplayerMode);
-                const int invalidMapCount = shuffleStageMaps(generatedStages, autoMapShuffleCount, isMultiplayerMode);
-                generatedForMultiplayerMode = isMultiplayerMode;
-                currentStageIndex = 0;
+            generationLogs.clear();
+            generationLogs.append("[INFO] Generating " + std::to_string(stageCount) + " stage(s)...");
+
+            GenerationRequest request;
+            request.stageCount = stageCount;
+            request.mapWidth = mapWidth;
+            request.mapHeight = mapHeight;
+            request.shuffleCount = shuffleCount;
+            request.shuffleKernel = shuffleKernelIndex == 0 ? ShuffleKernel::Fast : ShuffleKernel::LegacyExact;
+            request.rngBackend = rngBackendIndex == 0 ? RngBackend::Mt19937 : RngBackend::Xoshiro256StarStar;
+            request.isMultiplayerMode = isMultiplayerMode;
+            request.autoMapEnabled = autoMapEnabled;
+            request.lazyGeneration = lazyGenerationEnabled;
+            request.rejectDuplicateStages = rejectDuplicateStages;
+            request.logMetrics = logGenerationMetrics;
+            request.masterSeed = masterSeed;
+            request.exportTitle = exportTitle;
+            generationJob.start(std::move(request));
+        }
+        ImGui::EndDisabled();
+
+        if (generationRunning) {
+            const int totalStages = std::max(1, generationJob.totalStageCount());
+            const int completedStages = generationJob.completedStageCount();
+            char progressOverlay[64] = {};
+            std::snprintf(
+                progressOverlay,
+                sizeof(progressOverlay),
+                "%d / %d %s",
+                completedStages,
+                totalStages,
+                generationJob.progressUnit()
+            );
+            ImGui::ProgressBar(
+                static_cast<float>(completedStages) / static_cast<float>(totalStages),
+                ImVec2(-FLT_MIN, 0.0f),
+                progressOverlay
+            );
 
-                std::string outputCsvPath;
-                const bool csvExported = exportStagesToCsv(
-                    generatedStages,
-                    generatedForMultiplayerMode,
-                    exportTitle,
-                    outputCsvPath
-                );
+            ImGui::BeginDisabled(generationJob.isCancelRequested());
+            if (ImGui::Button("Cancel")) {
+                generationJob.cancel();
+                generationLogs.append("[INFO] Cancelling generation...");
+            }
+            ImGui::EndDisabled();
+        }
+        ImGui::Separator();
+        ImGui::TextUnformatted("Export");
+        char exportTitleBuffer[128] = {};
+        std::snprintf(exportTitleBuffer, sizeof(exportTitleBuffer), "%s", exportTitle.c_str());
+        if (ImGui::InputText("Export Title", exportTitleBuffer, sizeof(exportTitleBuffer))) {
+            exportTitle = exportTitleBuffer;
+            // Pasted text arrives without SDL_TEXTINPUT events.
+            if (fontAtlas.requestGlyphs(exportTitle)) {
+                frameScheduler.onEvent();
+            }
+        }
 
-                generationLogs.push_back("[INFO] Done.");
-                generationLogs.push_back(
-                    "[INFO] Created " + std::to_string(stageCount) +
-                    " stage(s), each with " + std::to_string(mapCountPerStage) + " map(s)."
+        ImGui::BeginDisabled(generationRunning);
+        const bool createCsvClicked = ImGui::Button("Create CSV File");
+        ImGui::SameLine();
+        const bool createPackClicked = ImGui::Button("Create Stage Pack File");
+        ImGui::EndDisabled();
+        if (createCsvClicked || createPackClicked) {
+            const bool asStagePack = createPackClicked;
+            const char* const formatName = asStagePack ? "stage pack" : "stage CSV";
+            if (generatedBatch.empty()) {
+                generationLogs.append("[WARN] No stages to export. Generate stages first.");
+            } else if (generatedBatch.isLazy()) {
+                // Runs on the generation worker like a new batch: exporting
+                // means generating every stage.
+                GenerationRequest request;
+                request.stageCount = generatedBatch.stageCount();
+                request.exportTitle = exportTitle;
+                request.exportLazyBatchOnly = true;
+                request.exportAsStagePack = asStagePack;
+                request.lazyBatchToExport = generatedBatch.lazyStages.settings();
+                generationJob.start(std::move(request));
+            } else if (generatedBatch.isPack() && asStagePack) {
+                generationLogs.append(
+                    "[WARN] These stages were opened from '" + generatedBatch.pack.path() + "' and are already a stage pack."
                 );
-
-                if (invalidMapCount > 0) {
-                    generationLogs.push_back(
-                        "[WARN] " + std::to_string(invalidMapCount) +
-                        " map(s) could not avoid vertically adjacent equal numbers after many retries."
+            } else {
+                std::string outputPath;
+                bool exported = false;
+                // Set when only the changed rows of an earlier CSV were rewritten.
+                int rewrittenRowCount = -1;
+                if (generatedBatch.isPack()) {
+                    // Unpacks one window at a time straight from the mapping.
+                    static constexpr int kPackExportWindowStages = 4096;
+                    const StagePackReader& pack = generatedBatch.pack;
+                    outputPath = getStageCsvFileName(generatedBatch.isMultiplayerMode, exportTitle);
+                    exported = writeStagesCsvByWindow(
+                        pack.stageCount(),
+                        kPackExportWindowStages,
+                        generatedBatch.isMultiplayerMode,
+                        generatedBatch.masterSeed,
+                        outputPath,
+                        [&pack](int firstStageIndex, int windowStageCount, StageStore& window) {
+                            return pack.readStageWindow(firstStageIndex, windowStageCount, window);
+                        }
+                    );
+                } else if (asStagePack) {
+                    exported = exportStagesToPack(
+                        generatedBatch.stages,
+                        generatedBatch.isMultiplayerMode,
+                        generatedBatch.masterSeed,
+                        exportTitle,
+                        outputPath
                     );
+                } else {
+                    // A file this batch was already written to only needs the
+                    // rows of the stages regenerated since.
+                    StageStatusTable& stageStatus = generatedBatch.status;
+                    outputPath = getStageCsvFileName(generatedBatch.isMultiplayerMode, exportTitle);
+                    if (generatedBatch.csvRows.outputPath == outputPath &&
+                        rewriteStagesCsvRows(generatedBatch.stages, stageStatus.dirtyStages(), generatedBatch.csvRows)) {
+                        rewrittenRowCount = stageStatus.dirtyCount();
+                        exported = true;
+                    } else {
+                        exported = exportStagesToCsv(
+                            generatedBatch.stages,
+                            generatedBatch.isMultiplayerMode,
+                            generatedBatch.masterSeed,
+                            exportTitle,
+                            outputPath,
+                            &generatedBatch.csvRows
+                        );
+                    }
+                    if (exported) {
+                        stageStatus.clearDirty();
+                    }
                 }
 
-                if (csvExported) {
-                    generationLogs.push_back("[INFO] Create Auto Map exported CSV to '" + outputCsvPath + "'.");
+                if (rewrittenRowCount == 0) {
+                    generationLogs.append("[INFO] '" + outputPath + "' already holds these stages.");
+                } else if (rewrittenRowCount > 0) {
+                    generationLogs.append(
+                        "[INFO] Rewrote " + std::to_string(rewrittenRowCount) + " changed row(s) of '" + outputPath +
+                        "' in place."
+                    );
+                } else if (exported) {
+                    generationLogs.append(
+                        std::string("[INFO] ") + (asStagePack ? "Stage pack" : "Stage CSV") + " exported to '" + outputPath + "'."
+                    );
                 } else {
-                    generationLogs.push_back("[ERROR] Create Auto Map failed to export CSV.");
+                    generationLogs.append(std::string("[ERROR] Failed to export ") + formatName + " file.");
                 }
-            } else {
-                generationLogs.push_back(
-                    "[INFO] Shuffle count set to " + std::to_string(shuffleCount) + "."
-                );
+            }
+        }
+
+        ImGui::Separator();
+        ImGui::TextUnformatted("Fix Up Stages");
+        const bool canRegenerateStages = generatedBatch.canRegenerateStages();
+        const StageStatusTable& stageStatus = generatedBatch.status;
+        if (canRegenerateStages) {
+            ImGui::Text(
+                "%d failed, %d locked, %d selected, %d changed since the last CSV export.",
+                stageStatus.failedCount(),
+                stageStatus.lockedCount(),
+                stageStatus.selectedCount(),
+                stageStatus.dirtyCount()
+            );
+        } else {
+            ImGui::TextUnformatted("Available for generated or imported stages held in memory.");
+        }
+
+        std::vector<int> stagesToRegenerate;
+        char regenerateLabel[64];
+        ImGui::BeginDisabled(generationRunning || !canRegenerateStages || stageStatus.failedCount() == 0);
+        std::snprintf(
+            regenerateLabel,
+            sizeof(regenerateLabel),
+            "Regenerate Failed (%d)###RegenerateFailed",
+            stageStatus.failedCount()
+        );
+        if (ImGui::Button(regenerateLabel)) {
+            stagesToRegenerate = stageStatus.failedStages();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(generationRunning || !canRegenerateStages || stageStatus.selectedCount() == 0);
+        std::snprintf(
+            regenerateLabel,
+            sizeof(regenerateLabel),
+            "Regenerate Selected (%d)###RegenerateSelected",
+            stageStatus.selectedCount()
+        );
+        if (ImGui::Button(regenerateLabel)) {
+            stagesToRegenerate = stageStatus.selectedStages();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        const int unlockedStageCount = canRegenerateStages ? stageStatus.stageCount() - stageStatus.lockedCount() : 0;
+        ImGui::BeginDisabled(generationRunning || unlockedStageCount == 0);
+        std::snprintf(
+            regenerateLabel,
+            sizeof(regenerateLabel),
+            "Regenerate Unlocked (%d)###RegenerateUnlocked",
+            unlockedStageCount
+        );
+        if (ImGui::Button(regenerateLabel)) {
+            stagesToRegenerate = stageStatus.unlockedStages();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!canRegenerateStages || stageStatus.selectedCount() == 0);
+        if (ImGui::Button("Clear Selection")) {
+            generatedBatch.status.clearSelection();
+        }
+        ImGui::EndDisabled();
+        ImGui::TextUnformatted(
+            "Ctrl+click thumbnails in the Stage Gallery to select stages; locked stages are never regenerated."
+        );
 
-                generatedStages = createStages(stageCount, mapWidth, mapHeight, isMultiplayerMode);
-                const int invalidMapCount = shuffleStageMaps(generatedStages, shuffleCount, isMultiplayerMode);
-                generatedForMultiplayerMode = isMultiplayerMode;
+        if (!stagesToRegenerate.empty()) {
+            generationLogs.append("[INFO] Regenerating " + std::to_string(stagesToRegenerate.size()) + " stage(s)...");
+
+            // The batch goes to the worker and comes back when it is done, so
+            // the Viewer never reads stages while they are being rewritten.
+            GenerationRequest request;
+            request.stageCount = static_cast<int>(stagesToRegenerate.size());
+            request.stagesToRegenerate = std::move(stagesToRegenerate);
+            request.batchToFix = std::move(generatedBatch);
+            generatedBatch = GeneratedBatch{};
+            regeneratingFromStageIndex = currentStageIndex;
+            generationJob.start(std::move(request));
+        }
+
+        ImGui::Separator();
+        ImGui::TextUnformatted("Open Stage Pack");
+        if (ImGui::InputText("Pack Path", stagePackPath, sizeof(stagePackPath)) && fontAtlas.requestGlyphs(stagePackPath)) {
+            frameScheduler.onEvent();
+        }
+        ImGui::BeginDisabled(generationRunning);
+        if (ImGui::Button("Open Stage Pack")) {
+            const auto openStart = std::chrono::steady_clock::now();
+            GeneratedBatch openedBatch;
+            std::string openError;
+            if (openedBatch.pack.open(stagePackPath, openError)) {
+                openedBatch.isMultiplayerMode = openedBatch.pack.isMultiplayerMode();
+                openedBatch.masterSeed = openedBatch.pack.masterSeed();
+                generatedBatch = std::move(openedBatch);
                 currentStageIndex = 0;
 
-                generationLogs.push_back("[INFO] Done.");
-                generationLogs.push_back(
-                    "[INFO] Created " + std::to_string(stageCount) +
-                    " stage(s), each with " + std::to_string(mapCountPerStage) + " map(s)."
-                );
-                generationLogs.push_back(
-                    "[INFO] Shuffled " +
-                    std::string(isMultiplayerMode ? "all maps" : "single map per stage") +
-                    " " + std::to_string(shuffleCount) + " time(s)."
+                char openLog[160];
+                std::snprintf(
+                    openLog,
+                    sizeof(openLog),
+                    " in %.2f ms: %d %s-mode stage(s) of %d x %d, %d byte(s) per tile.",
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count(),
+                    generatedBatch.pack.stageCount(),
+                    generatedBatch.isMultiplayerMode ? "multi" : "single",
+                    generatedBatch.pack.mapWidth(),
+                    generatedBatch.pack.mapHeight(),
+                    generatedBatch.pack.tileBytes()
                 );
-
-                if (invalidMapCount > 0) {
-                    generationLogs.push_back(
-                        "[WARN] " + std::to_string(invalidMapCount) +
-                        " map(s) could not avoid vertically adjacent equal numbers after many retries."
-                    );
-                }
+                generationLogs.append("[INFO] Opened '" + generatedBatch.pack.path() + "'" + openLog);
+            } else {
+                generationLogs.append("[ERROR] Failed to open stage pack: " + openError);
             }
         }
+        ImGui::EndDisabled();
+
         ImGui::Separator();
-        ImGui::TextUnformatted("Export");
-        char exportTitleBuffer[128] = {};
-        std::snprintf(exportTitleBuffer, sizeof(exportTitleBuffer), "%s", exportTitle.c_str());
-        if (ImGui::InputText("Export Title", exportTitleBuffer, sizeof(exportTitleBuffer))) {
-            exportTitle = exportTitleBuffer;
+        ImGui::TextUnformatted("Import Stage CSV");
+        if (ImGui::InputText("CSV Path", stageCsvPath, sizeof(stageCsvPath)) && fontAtlas.requestGlyphs(stageCsvPath)) {
+            frameScheduler.onEvent();
         }
-
-        if (ImGui::Button("Create CSV File")) {
-            if (generatedStages.empty()) {
-                generationLogs.push_back("[WARN] No stages to export. Generate stages first.");
+        ImGui::BeginDisabled(generationRunning);
+        if (ImGui::Button("Import and Validate CSV")) {
+            if (stageCsvPath[0] == '\0') {
+                generationLogs.append("[WARN] Enter the path of a stage CSV file first.");
             } else {
-                std::string outputCsvPath;
-                const bool csvExported = exportStagesToCsv(
-                    generatedStages,
-                    generatedForMultiplayerMode,
-                    exportTitle,
-                    outputCsvPath
-                );
+                generationLogs.clear();
+
+                // Runs on the generation worker; the stage count is filled in
+                // once the importer has counted the rows.
+                // Stages regenerated later use the shuffle settings above.
+                GenerationRequest request;
+                request.stageCount = 0;
+                request.importCsvPath = stageCsvPath;
+                request.shuffleCount = shuffleCount;
+                request.shuffleKernel = shuffleKernelIndex == 0 ? ShuffleKernel::Fast : ShuffleKernel::LegacyExact;
+                request.rngBackend = rngBackendIndex == 0 ? RngBackend::Mt19937 : RngBackend::Xoshiro256StarStar;
+                request.logMetrics = logGenerationMetrics;
+                generationJob.start(std::move(request));
+            }
+        }
+        ImGui::EndDisabled();
+        ImGui::TextUnformatted("Reads a CSV written by Create CSV File and reports every vertical match in it.");
 
-                if (csvExported) {
-                    generationLogs.push_back("[INFO] Stage CSV exported to '" + outputCsvPath + "'.");
-                } else {
-                    generationLogs.push_back("[ERROR] Failed to export stage CSV file.");
-                }
+        ImGui::Separator();
+        ImGui::TextUnformatted("Parameter Sweep");
+        int sweepWidths[2] = {sweepSettings.minMapWidth, sweepSettings.maxMapWidth};
+        int sweepHeights[2] = {sweepSettings.minMapHeight, sweepSettings.maxMapHeight};
+        if (ImGui::InputInt2("Widths (min, max)", sweepWidths)) {
+            sweepSettings.minMapWidth = sweepWidths[0];
+            sweepSettings.maxMapWidth = sweepWidths[1];
+        }
+        if (ImGui::InputInt2("Heights (min, max)", sweepHeights)) {
+            sweepSettings.minMapHeight = sweepHeights[0];
+            sweepSettings.maxMapHeight = sweepHeights[1];
+        }
+        sweepSettings.minMapWidth = std::clamp(sweepSettings.minMapWidth, 1, kMaxMapWidth);
+        sweepSettings.maxMapWidth = std::clamp(sweepSettings.maxMapWidth, sweepSettings.minMapWidth, kMaxMapWidth);
+        const int sweepHeightLimit = getMaxMapHeight(sweepSettings.maxMapWidth, getMapCountPerStage(true));
+        sweepSettings.minMapHeight = std::clamp(sweepSettings.minMapHeight, 1, sweepHeightLimit);
+        sweepSettings.maxMapHeight = std::clamp(sweepSettings.maxMapHeight, sweepSettings.minMapHeight, sweepHeightLimit);
+        ImGui::InputInt("Stages per Cell", &sweepSettings.samplesPerCell);
+        if (sweepSettings.samplesPerCell < 1) {
+            sweepSettings.samplesPerCell = 1;
+        }
+        ImGui::Checkbox("Single Mode", &sweepSettings.includeSingleMode);
+        ImGui::SameLine();
+        ImGui::Checkbox("Multi Mode", &sweepSettings.includeMultiMode);
+        ImGui::BeginDisabled(generationRunning || !(sweepSettings.includeSingleMode || sweepSettings.includeMultiMode));
+        if (ImGui::Button("Run Parameter Sweep")) {
+            if (randomizeSeedEachRun) {
+                masterSeed = generateMasterSeed();
             }
+            generationLogs.clear();
+
+            // Uses the shuffle settings and seed above, like Start Making Stages.
+            GenerationRequest request;
+            request.runParameterSweep = true;
+            request.sweepSettings = sweepSettings;
+            ShuffleSettings& sweepShuffle = request.sweepSettings.shuffleSettings;
+            sweepShuffle.shuffleCount = shuffleCount;
+            sweepShuffle.kernel = shuffleKernelIndex == 0 ? ShuffleKernel::Fast : ShuffleKernel::LegacyExact;
+            sweepShuffle.rngBackend = rngBackendIndex == 0 ? RngBackend::Mt19937 : RngBackend::Xoshiro256StarStar;
+            request.sweepSettings.masterSeed = masterSeed;
+            request.stageCount = static_cast<int>(createParameterSweepCells(request.sweepSettings).size());
+            request.exportTitle = exportTitle;
+            generationJob.start(std::move(request));
         }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::Checkbox("Show Sweep", &showParameterSweep);
+        ImGui::TextUnformatted("Samples every size and mode in the ranges, shows acceptance and time per stage as a heatmap,");
+        ImGui::TextUnformatted("and saves the table as parameter_sweep.csv. Click a cell to use its size and mode.");
 
         ImGui::Separator();
         ImGui::Text("Korean font loaded: %s", koreanFontLoaded ? "Yes" : "No (fallback)");
+        ImGui::Text(
+            "Font atlas: %d glyphs (startup %.1f ms, last build %.1f ms)",
+            fontAtlas.glyphCount(),
+            initialFontBuildMs,
+            fontAtlas.lastBuildMs()
+        );
+        ImGui::Text("Time to first frame: %.1f ms", timeToFirstFrameMs);
+        ImGui::Checkbox("Show Frame Rate", &showFrameRate);
+        if (showFrameRate) {
+            // Counts frames actually built; near 0 while the window is idle.
+            ImGui::Text("Effective frame rate: %d fps", frameScheduler.effectiveFrameRate(FrameScheduler::Clock::now()));
+        }
+        ImGui::Checkbox("Show Performance HUD", &showPerformanceHud);
         ImGui::End();
+        frameProfiler.lap(FrameSection::ControlPanel);
 
         ImGui::Begin("Generation Logs");
-        for (const std::string& log : generationLogs) {
-            ImGui::TextUnformatted(log.c_str());
+        ImGui::Checkbox("Info", &showInfoLogs);
+        ImGui::SameLine();
+        ImGui::Checkbox("Warn", &showWarningLogs);
+        ImGui::SameLine();
+        ImGui::Checkbox("Error", &showErrorLogs);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200.0f);
+        if (ImGui::InputText("Search", logSearchText, sizeof(logSearchText)) && fontAtlas.requestGlyphs(logSearchText)) {
+            frameScheduler.onEvent();
+        }
+
+        generationLogFilter.setSeverityMask(
+            (showInfoLogs ? LogFilter::severityBit(LogSeverity::Info) : 0u) |
+            (showWarningLogs ? LogFilter::severityBit(LogSeverity::Warning) : 0u) |
+            (showErrorLogs ? LogFilter::severityBit(LogSeverity::Error) : 0u)
+        );
+        generationLogFilter.setQuery(logSearchText);
+        const std::vector<std::uint64_t>& visibleLogs = generationLogFilter.update(generationLogs);
+
+        ImGui::SameLine();
+        ImGui::Text("%zu / %zu line(s)", visibleLogs.size(), generationLogs.size());
+        if (generationLogs.droppedCount() > 0) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(%llu older line(s) dropped)", static_cast<unsigned long long>(generationLogs.droppedCount()));
+        }
+        ImGui::Separator();
+
+        ImGui::BeginChild("LogLines", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+        const bool followLatestLog = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+        ImGuiListClipper logClipper;
+        logClipper.Begin(static_cast<int>(visibleLogs.size()));
+        while (logClipper.Step()) {
+            for (int lineIndex = logClipper.DisplayStart; lineIndex < logClipper.DisplayEnd; ++lineIndex) {
+                const LogRecord& record = generationLogs.record(visibleLogs[lineIndex]);
+                const std::string_view text = generationLogs.text(record);
+
+                char timestamp[16];
+                formatLogTimestamp(record.timestampMs, timestamp, sizeof(timestamp));
+
+                const ImVec4 color = record.severity == LogSeverity::Error
+                    ? ImVec4(1.0f, 0.4f, 0.3f, 1.0f)
+                    : record.severity == LogSeverity::Warning
+                        ? ImVec4(1.0f, 0.8f, 0.3f, 1.0f)
+                        : ImGui::GetStyle().Colors[ImGuiCol_Text];
+                ImGui::TextColored(
+                    color,
+                    "%s [%s] %.*s",
+                    timestamp,
+                    getLogSeverityTag(record.severity),
+                    static_cast<int>(text.size()),
+                    text.data()
+                );
+            }
+        }
+        logClipper.End();
+
+        if (followLatestLog) {
+            ImGui::SetScrollHereY(1.0f);
         }
+        ImGui::EndChild();
         ImGui::End();
+        frameProfiler.lap(FrameSection::GenerationLogs);
 
         ImGui::Begin("Viewer");
-        if (generatedStages.empty()) {
+        if (generatedBatch.empty()) {
             ImGui::TextUnformatted("Press 'Start Making Stages' to create stages.");
         } else {
-            constexpr float kTileSize = 28.0f;
-            constexpr float kTileGap = 4.0f;
             constexpr float kMapPanelGap = 32.0f;
 
-            currentStageIndex = std::clamp(currentStageIndex, 0, static_cast<int>(generatedStages.size()) - 1);
-            StageData& currentStage = generatedStages[currentStageIndex];
+            const int batchStageCount = generatedBatch.stageCount();
+            currentStageIndex = std::clamp(currentStageIndex, 0, batchStageCount - 1);
 
             if (ImGui::Button("Prev Stage")) {
                 currentStageIndex = std::max(0, currentStageIndex - 1);
             }
             ImGui::SameLine();
             if (ImGui::Button("Next Stage")) {
-                currentStageIndex = std::min(static_cast<int>(generatedStages.size()) - 1, currentStageIndex + 1);
+                currentStageIndex = std::min(batchStageCount - 1, currentStageIndex + 1);
             }
             ImGui::SameLine();
-            ImGui::Text("Stage %d / %zu", currentStageIndex + 1, generatedStages.size());
+            ImGui::Text("Stage %d / %d", currentStageIndex + 1, batchStageCount);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(120.0f);
+            if (ImGui::InputInt("##JumpToStage", &jumpToStageNumber, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue)) {
+                jumpToStageNumber = std::clamp(jumpToStageNumber, 1, batchStageCount);
+                currentStageIndex = jumpToStageNumber - 1;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Go to Stage")) {
+                jumpToStageNumber = std::clamp(jumpToStageNumber, 1, batchStageCount);
+                currentStageIndex = jumpToStageNumber - 1;
+            }
+            ImGui::SameLine();
+            ImGui::Checkbox("Gallery", &showStageGallery);
+
+            if (generatedBatch.canRegenerateStages()) {
+                StageStatusTable& stageStatus = generatedBatch.status;
+                bool locked = stageStatus.isLocked(currentStageIndex);
+                if (ImGui::Checkbox("Lock", &locked)) {
+                    stageStatus.setLocked(currentStageIndex, locked);
+                }
+                ImGui::SameLine();
+                bool selected = stageStatus.isSelected(currentStageIndex);
+                if (ImGui::Checkbox("Select", &selected)) {
+                    stageStatus.setSelected(currentStageIndex, selected);
+                }
+                ImGui::SameLine();
+                if (stageStatus.isFailed(currentStageIndex)) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "This stage keeps vertically adjacent equal numbers.");
+                } else {
+                    ImGui::TextUnformatted("Valid.");
+                }
+                if (stageStatus.revision(currentStageIndex) > 0) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled(
+                        "Regenerated %u time(s)%s",
+                        static_cast<unsigned>(stageStatus.revision(currentStageIndex)),
+                        stageStatus.isDirty(currentStageIndex) ? ", not exported yet." : "."
+                    );
+                }
+            }
+
+            const int currentStageMapCount = generatedBatch.mapCount(currentStageIndex);
+            if (generatedBatch.isPack()) {
+                generatedBatch.selectPackStage(currentStageIndex);
+                ImGui::Text("Stage pack '%s', memory-mapped.", generatedBatch.pack.path().c_str());
+                if (!generatedBatch.packStageChecksumValid) {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "Checksum mismatch: this stage is corrupted.");
+                }
+            }
+            if (generatedBatch.isLazy()) {
+                const bool arranged = generatedBatch.lazyStages.isStageArranged(currentStageIndex);
+                ImGui::Text(
+                    "Generated on demand: %d stage(s) cached, %llu generated so far.%s",
+                    generatedBatch.lazyStages.cachedStageCount(),
+                    static_cast<unsigned long long>(generatedBatch.lazyStages.generatedStageCount()),
+                    arranged ? "" : " This stage keeps vertically adjacent equal numbers."
+                );
+            }
 
             ImGui::Separator();
 
-            auto drawMapPanel = [&](const GeneratedMap& map, int mapNumberInStage) {
+            auto drawMapPanel = [&](const MapView& map, int mapNumberInStage) {
                 const int displayedMapNumber = (mapNumberInStage == 2)
                     ? mapNumberInStage + 100
                     : mapNumberInStage;
@@ -652,63 +1766,253 @@ int AppUI::run() {
                 ImGui::Text("Tile Map (%d x %d)", map.width, map.height);
                 ImGui::Separator();
 
-                for (int row = 0; row < map.height; ++row) {
-                    for (int col = 0; col < map.width; ++col) {
-                        const int tileIndex = row * map.width + col;
-                        const int displayedTileNumber = map.tiles[tileIndex];
-
-                        ImGui::PushID((currentStageIndex * 1000000) + (mapNumberInStage * 100000) + tileIndex);
-                        const std::string tileLabel = std::to_string(displayedTileNumber);
-                        ImGui::Button(tileLabel.c_str(), ImVec2(kTileSize, kTileSize));
-                        ImGui::PopID();
-
-                        if (col + 1 < map.width) {
-                            ImGui::SameLine(0.0f, kTileGap);
-                        }
-                    }
+                ImGui::BeginChild("TileGrid", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+                const int hoveredTileIndex = drawTileGrid("##Tiles", map, tileLabelCache);
+                if (hoveredTileIndex >= 0) {
+                    ImGui::SetTooltip(
+                        "Row %d, Column %d: %d",
+                        hoveredTileIndex / map.width + 1,
+                        hoveredTileIndex % map.width + 1,
+                        static_cast<int>(map.tileAt(static_cast<std::size_t>(hoveredTileIndex)))
+                    );
                 }
+                ImGui::EndChild();
             };
 
-            if (generatedForMultiplayerMode) {
+            if (generatedBatch.isMultiplayerMode) {
                 const float availableWidth = ImGui::GetContentRegionAvail().x;
                 const float panelWidth = std::max(120.0f, (availableWidth - kMapPanelGap) * 0.5f);
 
                 ImGui::BeginChild("MapPanelLeft", ImVec2(panelWidth, 0), true);
-                if (!currentStage.maps.empty()) {
-                    drawMapPanel(currentStage.maps[0], 1);
+                if (currentStageMapCount >= 1) {
+                    drawMapPanel(generatedBatch.map(currentStageIndex, 0), 1);
                 }
                 ImGui::EndChild();
 
                 ImGui::SameLine(0.0f, kMapPanelGap);
 
                 ImGui::BeginChild("MapPanelRight", ImVec2(panelWidth, 0), true);
-                if (currentStage.maps.size() >= 2) {
-                    drawMapPanel(currentStage.maps[1], 2);
+                if (currentStageMapCount >= 2) {
+                    drawMapPanel(generatedBatch.map(currentStageIndex, 1), 2);
                 } else {
                     ImGui::TextUnformatted("No Map");
                 }
                 ImGui::EndChild();
             } else {
-                if (!currentStage.maps.empty()) {
-                    drawMapPanel(currentStage.maps[0], 1);
+                if (currentStageMapCount >= 1) {
+                    drawMapPanel(generatedBatch.map(currentStageIndex, 0), 1);
                 } else {
                     ImGui::TextUnformatted("No Map");
                 }
             }
         }
         ImGui::End();
+        frameProfiler.lap(FrameSection::Viewer);
+
+        if (showParameterSweep) {
+            const ParameterSweepCell* selectedCell = drawParameterSweepWindow(sweepResult, sweepViewState, &showParameterSweep);
+            if (selectedCell != nullptr) {
+                mapWidth = selectedCell->mapWidth;
+                mapHeight = selectedCell->mapHeight;
+                isMultiplayerMode = selectedCell->isMultiplayerMode;
+                generationLogs.append(
+                    "[INFO] Map size set to " + std::to_string(mapWidth) + " x " + std::to_string(mapHeight) + " in " +
+                    std::string(isMultiplayerMode ? "Multi" : "Single") + " mode from the parameter sweep."
+                );
+            }
+        }
+        frameProfiler.lap(FrameSection::ParameterSweep);
+
+        thumbnailCache.beginFrame();
+        if (showStageGallery) {
+            ImGui::SetNextWindowSize(ImVec2(640.0f, 560.0f), ImGuiCond_FirstUseEver);
+            if (ImGui::Begin("Stage Gallery", &showStageGallery)) {
+                if (generatedBatch.empty()) {
+                    ImGui::TextUnformatted("Press 'Start Making Stages' to create stages.");
+                } else {
+                    ImGui::SetNextItemWidth(200.0f);
+                    ImGui::SliderInt("Thumbnail Size", &galleryThumbnailSize, 48, 192);
+                    ImGui::SameLine();
+                    ImGui::TextDisabled(
+                        "%d cached, %llu built",
+                        thumbnailCache.cachedCount(),
+                        static_cast<unsigned long long>(thumbnailCache.builtCount())
+                    );
+                    ImGui::Separator();
+
+                    ImGui::BeginChild("GalleryGrid");
+                    const ImGuiStyle& style = ImGui::GetStyle();
+                    const float thumbnailSide = static_cast<float>(galleryThumbnailSize);
+                    const float cellWidth = thumbnailSide + style.ItemSpacing.x;
+                    const float captionHeight = ImGui::GetTextLineHeightWithSpacing();
+                    const int batchStageCount = generatedBatch.stageCount();
+                    const float gridWidth = ImGui::GetContentRegionAvail().x + style.ItemSpacing.x;
+                    const int columnCount = std::max(1, static_cast<int>(gridWidth / cellWidth));
+                    const int rowCount = (batchStageCount + columnCount - 1) / columnCount;
+                    ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+                    // One clipper item per row of thumbnails; rows off screen
+                    // cost nothing, not even a hash.
+                    ImGuiListClipper galleryClipper;
+                    galleryClipper.Begin(rowCount, thumbnailSide + captionHeight + style.ItemSpacing.y);
+                    while (galleryClipper.Step()) {
+                        for (int row = galleryClipper.DisplayStart; row < galleryClipper.DisplayEnd; ++row) {
+                            const ImVec2 rowStart = ImGui::GetCursorScreenPos();
+                            for (int column = 0; column < columnCount; ++column) {
+                                const int stageIndex = row * columnCount + column;
+                                if (stageIndex >= batchStageCount) {
+                                    break;
+                                }
+
+                                const StageThumbnailLayout layout = generatedBatch.thumbnailLayout(stageIndex);
+                                SDL_Texture* texture = thumbnailCache.thumbnail(
+                                    stageIndex,
+                                    generatedBatch.stageContentHash(stageIndex),
+                                    layout,
+                                    [&] {
+                                        return generatedBatch.readThumbnailTiles(stageIndex, thumbnailTiles);
+                                    }
+                                );
+
+                                // Fit the thumbnail into the square cell, keeping its aspect.
+                                const StageThumbnailSize textureSize = getStageThumbnailSize(layout);
+                                const float scale = textureSize.width > 0
+                                    ? thumbnailSide / static_cast<float>(std::max(textureSize.width, textureSize.height))
+                                    : 0.0f;
+                                const ImVec2 imageSize(
+                                    std::max(1.0f, static_cast<float>(textureSize.width) * scale),
+                                    std::max(1.0f, static_cast<float>(textureSize.height) * scale)
+                                );
+                                const ImVec2 cellMin(rowStart.x + static_cast<float>(column) * cellWidth, rowStart.y);
+                                const ImVec2 imageMin(
+                                    cellMin.x + (thumbnailSide - imageSize.x) * 0.5f,
+                                    cellMin.y + (thumbnailSide - imageSize.y) * 0.5f
+                                );
+
+                                ImGui::PushID(stageIndex);
+                                ImGui::SetCursorScreenPos(imageMin);
+                                if (texture != nullptr) {
+                                    ImGui::Image(reinterpret_cast<ImTextureID>(texture), imageSize);
+                                } else {
+                                    // Built in a later frame.
+                                    ImGui::Dummy(imageSize);
+                                    drawList->AddRectFilled(
+                                        imageMin,
+                                        ImVec2(imageMin.x + imageSize.x, imageMin.y + imageSize.y),
+                                        IM_COL32(50, 50, 50, 255)
+                                    );
+                                }
+                                const bool canSelectStages = generatedBatch.canRegenerateStages();
+                                if (ImGui::IsItemClicked() && canSelectStages && ImGui::GetIO().KeyCtrl) {
+                                    generatedBatch.status.setSelected(stageIndex, !generatedBatch.status.isSelected(stageIndex));
+                                } else if (ImGui::IsItemClicked()) {
+                                    currentStageIndex = stageIndex;
+                                    jumpToStageNumber = stageIndex + 1;
+                                }
+                                if (ImGui::IsItemHovered()) {
+                                    ImGui::SetTooltip(
+                                        "Stage %d%s%s",
+                                        stageIndex + 1,
+                                        canSelectStages && generatedBatch.status.isLocked(stageIndex) ? " (locked)" : "",
+                                        canSelectStages && generatedBatch.status.isSelected(stageIndex) ? " (selected)" : ""
+                                    );
+                                }
+                                if (canSelectStages && generatedBatch.status.isSelected(stageIndex)) {
+                                    drawList->AddRectFilled(
+                                        imageMin,
+                                        ImVec2(imageMin.x + imageSize.x, imageMin.y + imageSize.y),
+                                        IM_COL32(80, 170, 255, 70)
+                                    );
+                                }
+                                if (canSelectStages && generatedBatch.status.isLocked(stageIndex)) {
+                                    drawList->AddRectFilled(
+                                        imageMin,
+                                        ImVec2(imageMin.x + 8.0f, imageMin.y + 8.0f),
+                                        IM_COL32(240, 240, 240, 255)
+                                    );
+                                }
+                                if (stageIndex == currentStageIndex) {
+                                    drawList->AddRect(
+                                        ImVec2(imageMin.x - 2.0f, imageMin.y - 2.0f),
+                                        ImVec2(imageMin.x + imageSize.x + 2.0f, imageMin.y + imageSize.y + 2.0f),
+                                        IM_COL32(255, 210, 80, 255),
+                                        0.0f,
+                                        0,
+                                        2.0f
+                                    );
+                                }
+                                ImGui::SetCursorScreenPos(ImVec2(cellMin.x, cellMin.y + thumbnailSide));
+                                ImGui::Text(
+                                    "%d%s",
+                                    stageIndex + 1,
+                                    canSelectStages && generatedBatch.status.isDirty(stageIndex) ? "*" : ""
+                                );
+                                ImGui::PopID();
+                            }
+
+                            // Claims the whole row for the layout and the clipper.
+                            ImGui::SetCursorScreenPos(rowStart);
+                            ImGui::Dummy(ImVec2(static_cast<float>(columnCount) * cellWidth, thumbnailSide + captionHeight));
+                        }
+                    }
+                    galleryClipper.End();
+                    ImGui::EndChild();
+                }
+            }
+            ImGui::End();
+        }
+        // Keep rendering until the thumbnails in view are all built.
+        if (thumbnailCache.hasDeferredBuilds()) {
+            frameScheduler.onEvent();
+        }
+        frameProfiler.lap(FrameSection::StageGallery);
+
+        if (showPerformanceHud) {
+            drawFrameProfilerWindow(frameProfiler, &showPerformanceHud);
+        }
+        frameProfiler.lap(FrameSection::PerformanceHud);
 
         ImGui::Render();
+        frameProfiler.lap(FrameSection::Render);
+        frameProfiler.setDrawDataStats(collectDrawDataStats(ImGui::GetDrawData()));
 
         SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
         SDL_RenderClear(renderer);
         ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer);
+        frameProfiler.lap(FrameSection::RenderDrawData);
         SDL_RenderPresent(renderer);
+        frameProfiler.lap(FrameSection::Present);
+        frameProfiler.endFrame();
+
+        if (timeToFirstFrameMs == 0.0) {
+            timeToFirstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+            char firstFrameLog[128];
+            std::snprintf(
+                firstFrameLog,
+                sizeof(firstFrameLog),
+                "[INFO] First frame presented %.1f ms after launch (font atlas %.1f ms, %d glyphs).",
+                timeToFirstFrameMs,
+                initialFontBuildMs,
+                fontAtlas.glyphCount()
+            );
+            generationLogs.append(firstFrameLog);
+        }
+
+        const ImGuiIO& io = ImGui::GetIO();
+        const bool interactionPending = ImGui::IsAnyItemActive() ||
+            ImGui::IsMouseDown(ImGuiMouseButton_Left) ||
+            ImGui::IsMouseDown(ImGuiMouseButton_Right);
+        frameScheduler.onFrameRendered(
+            FrameScheduler::Clock::now(),
+            interactionPending,
+            io.WantTextInput ? kAnimationFrameIntervalMs : 0
+        );
     }
 
     ImGui_ImplSDLRenderer2_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
+    thumbnailCache.clear();
 
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
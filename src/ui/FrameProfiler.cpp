@@ -0,0 +1,223 @@
+#include "ui/FrameProfiler.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+float millisecondsBetween(FrameProfiler::Clock::time_point start, FrameProfiler::Clock::time_point end) {
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+// Nearest-rank percentile of an ascending range.
+float percentile(const float* sorted, int count, double fraction) {
+    const int rank = static_cast<int>(std::ceil(fraction * count));
+    return sorted[std::clamp(rank - 1, 0, count - 1)];
+}
+} // namespace
+
+const char* getFrameSectionName(FrameSection section) {
+    switch (section) {
+    case FrameSection::Update:
+        return "Update";
+    case FrameSection::NewFrame:
+        return "NewFrame";
+    case FrameSection::ControlPanel:
+        return "Control Panel";
+    case FrameSection::GenerationLogs:
+        return "Generation Logs";
+    case FrameSection::Viewer:
+        return "Viewer";
+    case FrameSection::ParameterSweep:
+        return "Parameter Sweep";
+    case FrameSection::StageGallery:
+        return "Stage Gallery";
+    case FrameSection::PerformanceHud:
+        return "Performance";
+    case FrameSection::Render:
+        return "ImGui::Render";
+    case FrameSection::RenderDrawData:
+        return "RenderDrawData";
+    case FrameSection::Present:
+        return "Present";
+    case FrameSection::Count:
+        break;
+    }
+    return "Unknown";
+}
+
+DrawDataStats collectDrawDataStats(const ImDrawData* drawData) {
+    DrawDataStats stats;
+    if (drawData == nullptr) {
+        return stats;
+    }
+
+    stats.drawListCount = drawData->CmdListsCount;
+    stats.vertexCount = drawData->TotalVtxCount;
+    stats.indexCount = drawData->TotalIdxCount;
+    for (const ImDrawList* drawList : drawData->CmdLists) {
+        stats.commandCount += drawList->CmdBuffer.Size;
+    }
+    return stats;
+}
+
+void FrameProfiler::beginFrame() {
+    current_ = FrameSample{};
+    frameStart_ = Clock::now();
+    lapStart_ = frameStart_;
+    allocationsAtFrameStart_ = getThreadAllocationCount();
+}
+
+void FrameProfiler::lap(FrameSection section) {
+    const Clock::time_point now = Clock::now();
+    current_.sectionMs[static_cast<std::size_t>(section)] += millisecondsBetween(lapStart_, now);
+    lapStart_ = now;
+}
+
+void FrameProfiler::setDrawDataStats(const DrawDataStats& stats) {
+    current_.drawData = stats;
+}
+
+void FrameProfiler::endFrame() {
+    current_.totalMs = millisecondsBetween(frameStart_, Clock::now());
+    const AllocationCount allocations = getThreadAllocationCount();
+    current_.allocations.count = allocations.count - allocationsAtFrameStart_.count;
+    current_.allocations.bytes = allocations.bytes - allocationsAtFrameStart_.bytes;
+
+    history_[static_cast<std::size_t>(nextFrame_)] = current_;
+    nextFrame_ = (nextFrame_ + 1) % kHistoryFrames;
+    frameCount_ = std::min(frameCount_ + 1, kHistoryFrames);
+}
+
+const FrameProfiler::FrameSample& FrameProfiler::frame(int age) const {
+    const int index = (nextFrame_ - 1 - age + 2 * kHistoryFrames) % kHistoryFrames;
+    return history_[static_cast<std::size_t>(index)];
+}
+
+FrameProfiler::Summary FrameProfiler::summarize() const {
+    Summary summary;
+    summary.frameCount = frameCount_;
+    if (frameCount_ == 0) {
+        return summary;
+    }
+
+    std::uint64_t totalAllocations = 0;
+    std::uint64_t totalAllocatedBytes = 0;
+    for (int age = 0; age < frameCount_; ++age) {
+        const FrameSample& sample = frame(age);
+        sortedFrameMs_[static_cast<std::size_t>(age)] = sample.totalMs;
+
+        const int bin = std::clamp(static_cast<int>(sample.totalMs), 0, kHistogramBins - 1);
+        summary.histogram[static_cast<std::size_t>(bin)] += 1.0f;
+
+        for (int section = 0; section < kFrameSectionCount; ++section) {
+            SectionSummary& sectionSummary = summary.sections[static_cast<std::size_t>(section)];
+            const float sectionMs = sample.sectionMs[static_cast<std::size_t>(section)];
+            sectionSummary.averageMs += sectionMs;
+            sectionSummary.maxMs = std::max(sectionSummary.maxMs, sectionMs);
+        }
+
+        totalAllocations += sample.allocations.count;
+        totalAllocatedBytes += sample.allocations.bytes;
+        summary.maxAllocations = std::max(summary.maxAllocations, sample.allocations.count);
+    }
+
+    for (int section = 0; section < kFrameSectionCount; ++section) {
+        SectionSummary& sectionSummary = summary.sections[static_cast<std::size_t>(section)];
+        sectionSummary.averageMs /= static_cast<float>(frameCount_);
+        sectionSummary.lastMs = frame(0).sectionMs[static_cast<std::size_t>(section)];
+    }
+    summary.averageAllocations = static_cast<double>(totalAllocations) / frameCount_;
+    summary.averageAllocatedBytes = static_cast<double>(totalAllocatedBytes) / frameCount_;
+
+    std::sort(sortedFrameMs_.begin(), sortedFrameMs_.begin() + frameCount_);
+    summary.p50Ms = percentile(sortedFrameMs_.data(), frameCount_, 0.50);
+    summary.p99Ms = percentile(sortedFrameMs_.data(), frameCount_, 0.99);
+    summary.maxMs = sortedFrameMs_[static_cast<std::size_t>(frameCount_ - 1)];
+    return summary;
+}
+
+void drawFrameProfilerWindow(const FrameProfiler& profiler, bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(420.0f, 460.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Performance", open)) {
+        ImGui::End();
+        return;
+    }
+
+    const FrameProfiler::Summary summary = profiler.summarize();
+    if (summary.frameCount == 0) {
+        ImGui::TextUnformatted("No frame recorded yet.");
+        ImGui::End();
+        return;
+    }
+
+    // Frames are only built on input or activity, so these are the times of
+    // frames that were actually rendered, not of wall-clock intervals.
+    ImGui::Text(
+        "Last %d frame(s): p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+        summary.frameCount,
+        summary.p50Ms,
+        summary.p99Ms,
+        summary.maxMs
+    );
+    char histogramOverlay[64];
+    std::snprintf(
+        histogramOverlay,
+        sizeof(histogramOverlay),
+        "frame time, 1 ms bins up to %d+ ms",
+        FrameProfiler::kHistogramBins - 1
+    );
+    ImGui::PlotHistogram(
+        "##FrameTimeHistogram",
+        summary.histogram.data(),
+        FrameProfiler::kHistogramBins,
+        0,
+        histogramOverlay,
+        0.0f,
+        FLT_MAX,
+        ImVec2(-FLT_MIN, 80.0f)
+    );
+
+    if (ImGui::BeginTable("FrameSections", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Section");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+        for (int section = 0; section < kFrameSectionCount; ++section) {
+            const FrameProfiler::SectionSummary& sectionSummary = summary.sections[static_cast<std::size_t>(section)];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(getFrameSectionName(static_cast<FrameSection>(section)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", sectionSummary.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", sectionSummary.averageMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", sectionSummary.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    const FrameProfiler::FrameSample& lastFrame = profiler.frame(0);
+    ImGui::Text(
+        "Draw data: %d list(s), %d command(s), %d vertices, %d indices",
+        lastFrame.drawData.drawListCount,
+        lastFrame.drawData.commandCount,
+        lastFrame.drawData.vertexCount,
+        lastFrame.drawData.indexCount
+    );
+    ImGui::Text(
+        "Heap allocations: %llu last frame (%llu bytes), %.1f avg (%.0f bytes), %llu max",
+        static_cast<unsigned long long>(lastFrame.allocations.count),
+        static_cast<unsigned long long>(lastFrame.allocations.bytes),
+        summary.averageAllocations,
+        summary.averageAllocatedBytes,
+        static_cast<unsigned long long>(summary.maxAllocations)
+    );
+    ImGui::TextDisabled("Allocations count the render thread only (operator new and ImGui).");
+    ImGui::End();
+}
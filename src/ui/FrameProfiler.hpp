@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ui/AllocationCounter.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+struct ImDrawData;
+
+// Consecutive parts of one frame of AppUI::run(), in order.
+enum class FrameSection {
+    Update,          // generation events, font atlas rebuild
+    NewFrame,        // backend and ImGui NewFrame
+    ControlPanel,
+    GenerationLogs,
+    Viewer,
+    ParameterSweep,
+    StageGallery,
+    PerformanceHud,
+    Render,          // ImGui::Render
+    RenderDrawData,  // ImGui_ImplSDLRenderer2_RenderDrawData
+    Present,         // SDL_RenderPresent, including any vsync wait
+    Count,
+};
+
+inline constexpr int kFrameSectionCount = static_cast<int>(FrameSection::Count);
+
+const char* getFrameSectionName(FrameSection section);
+
+struct DrawDataStats {
+    int drawListCount = 0;
+    int commandCount = 0;
+    int vertexCount = 0;
+    int indexCount = 0;
+};
+
+DrawDataStats collectDrawDataStats(const ImDrawData* drawData);
+
+// Times the sections of every rendered frame and keeps the last
+// kHistoryFrames of them in a ring, together with the frame's draw-data
+// counts and render-thread heap allocations. Nothing here allocates after
+// construction, so the profiler does not show up in its own numbers.
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kHistoryFrames = 240;
+    // 1 ms bins; the last one also holds every slower frame.
+    static constexpr int kHistogramBins = 34;
+
+    struct FrameSample {
+        std::array<float, kFrameSectionCount> sectionMs = {};
+        float totalMs = 0.0f;
+        DrawDataStats drawData;
+        AllocationCount allocations;
+    };
+
+    struct SectionSummary {
+        float lastMs = 0.0f;
+        float averageMs = 0.0f;
+        float maxMs = 0.0f;
+    };
+
+    struct Summary {
+        int frameCount = 0;
+        float p50Ms = 0.0f;
+        float p99Ms = 0.0f;
+        float maxMs = 0.0f;
+        std::array<float, kHistogramBins> histogram = {};
+        std::array<SectionSummary, kFrameSectionCount> sections = {};
+        double averageAllocations = 0.0;
+        std::uint64_t maxAllocations = 0;
+        double averageAllocatedBytes = 0.0;
+    };
+
+    void beginFrame();
+    // Charges the time since the previous lap (or beginFrame) to section.
+    void lap(FrameSection section);
+    void setDrawDataStats(const DrawDataStats& stats);
+    void endFrame();
+
+    int frameCount() const {
+        return frameCount_;
+    }
+
+    // age 0 is the last completed frame.
+    const FrameSample& frame(int age) const;
+
+    Summary summarize() const;
+
+private:
+    std::array<FrameSample, kHistoryFrames> history_ = {};
+    int nextFrame_ = 0;
+    int frameCount_ = 0;
+
+    FrameSample current_;
+    Clock::time_point frameStart_;
+    Clock::time_point lapStart_;
+    AllocationCount allocationsAtFrameStart_;
+
+    // Sorted copy of the frame times, reused by summarize().
+    mutable std::array<float, kHistoryFrames> sortedFrameMs_ = {};
+};
+
+// The "Performance" window: frame-time histogram with p50/p99, per-section
+// times, draw-list counts and allocations per frame.
+void drawFrameProfilerWindow(const FrameProfiler& profiler, bool* open);
@@ -0,0 +1,48 @@
+#include "ui/FrameScheduler.hpp"
+
+#include <algorithm>
+
+int FrameScheduler::waitTimeoutMs(Clock::time_point now) const {
+    if (interactionPending_ || pendingFrames_ > 0) {
+        return 0;
+    }
+    if (!animationDeadline_) {
+        return -1;
+    }
+
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*animationDeadline_ - now);
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, remaining.count()));
+}
+
+void FrameScheduler::onEvent() {
+    pendingFrames_ = std::max(pendingFrames_, kFramesAfterEvent);
+}
+
+bool FrameScheduler::shouldRenderFrame(Clock::time_point now) const {
+    return interactionPending_ || pendingFrames_ > 0 || (animationDeadline_ && now >= *animationDeadline_);
+}
+
+void FrameScheduler::onFrameRendered(Clock::time_point now, bool interactionPending, int animationIntervalMs) {
+    if (pendingFrames_ > 0) {
+        --pendingFrames_;
+    }
+    interactionPending_ = interactionPending;
+    animationDeadline_.reset();
+    if (animationIntervalMs > 0) {
+        animationDeadline_ = now + std::chrono::milliseconds(animationIntervalMs);
+    }
+
+    recentFrames_.push_back(now);
+    dropFramesBefore(now - std::chrono::seconds(1));
+}
+
+int FrameScheduler::effectiveFrameRate(Clock::time_point now) {
+    dropFramesBefore(now - std::chrono::seconds(1));
+    return static_cast<int>(recentFrames_.size());
+}
+
+void FrameScheduler::dropFramesBefore(Clock::time_point windowStart) {
+    while (!recentFrames_.empty() && recentFrames_.front() <= windowStart) {
+        recentFrames_.pop_front();
+    }
+}
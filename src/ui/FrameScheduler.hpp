@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <optional>
+
+// Decides when the main loop has to build a frame. Input and wake-up events
+// buy a few frames so ImGui can settle hover and layout state; an active
+// interaction (a held button, a drag) keeps frames coming at vsync rate; a
+// pending animation asks for one frame after a delay. Otherwise the loop may
+// block in SDL_WaitEventTimeout until the next event.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A timeout for SDL_WaitEventTimeout: 0 to poll, -1 to wait indefinitely.
+    int waitTimeoutMs(Clock::time_point now) const;
+
+    void onEvent();
+    bool shouldRenderFrame(Clock::time_point now) const;
+
+    // interactionPending keeps rendering every frame. animationIntervalMs > 0
+    // schedules one more frame that far in the future (e.g. a blinking cursor).
+    void onFrameRendered(Clock::time_point now, bool interactionPending, int animationIntervalMs);
+
+    // Frames rendered during the last second.
+    int effectiveFrameRate(Clock::time_point now);
+
+private:
+    static constexpr int kFramesAfterEvent = 3;
+
+    void dropFramesBefore(Clock::time_point windowStart);
+
+    int pendingFrames_ = kFramesAfterEvent;
+    bool interactionPending_ = false;
+    std::optional<Clock::time_point> animationDeadline_;
+    std::deque<Clock::time_point> recentFrames_;
+};
@@ -0,0 +1,187 @@
+#include "ui/KoreanFontAtlas.hpp"
+
+#include <backends/imgui_impl_sdlrenderer2.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+// Baked at startup. Hangul syllables (0xAC00-0xD7A3, ~11k glyphs) are not:
+// they are added one by one as they are needed.
+constexpr ImWchar kBaseGlyphRanges[] = {
+    0x0020, 0x00FF,
+    0x3131, 0x3163,
+    0,
+};
+
+bool readFontFile(const std::string& path, std::vector<char>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+// Decodes the UTF-8 sequence at text[index] and advances index past it.
+// Malformed bytes decode as 0 and advance by one.
+std::uint32_t decodeUtf8(std::string_view text, std::size_t& index) {
+    const unsigned char lead = static_cast<unsigned char>(text[index]);
+    int length = 0;
+    std::uint32_t codepoint = 0;
+    if (lead < 0x80) {
+        ++index;
+        return lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint = lead & 0x07;
+    } else {
+        ++index;
+        return 0;
+    }
+
+    if (index + length > text.size()) {
+        ++index;
+        return 0;
+    }
+    for (int offset = 1; offset < length; ++offset) {
+        const unsigned char continuation = static_cast<unsigned char>(text[index + offset]);
+        if ((continuation & 0xC0) != 0x80) {
+            ++index;
+            return 0;
+        }
+        codepoint = (codepoint << 6) | (continuation & 0x3F);
+    }
+    index += length;
+    return codepoint;
+}
+} // namespace
+
+bool KoreanFontAtlas::load(float sizePixels) {
+    sizePixels_ = sizePixels;
+    fontData_.clear();
+    fontPath_.clear();
+
+    const std::vector<std::string> candidates = {
+#if defined(_WIN32)
+        "C:/Windows/Fonts/malgun.ttf",
+        "C:/Windows/Fonts/NanumGothic.ttf",
+#elif defined(__APPLE__)
+        "/System/Library/Fonts/AppleSDGothicNeo.ttc",
+        "/Library/Fonts/NanumGothic.ttf",
+#else
+        "/usr/share/fonts/truetype/nanum/NanumGothic.ttf",
+        "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
+        "/usr/share/fonts/truetype/noto/NotoSansCJK-Regular.ttc",
+#endif
+    };
+
+    for (const auto& path : candidates) {
+        if (std::filesystem::exists(path) && readFontFile(path, fontData_)) {
+            fontPath_ = path;
+            break;
+        }
+    }
+
+    requestedGlyphs_.Clear();
+    requestedGlyphs_.AddRanges(kBaseGlyphRanges);
+    buildAtlas();
+    rebuildPending_ = false;
+    return isKoreanFontLoaded();
+}
+
+bool KoreanFontAtlas::isKoreanFontLoaded() const {
+    return !fontPath_.empty();
+}
+
+const std::string& KoreanFontAtlas::fontPath() const {
+    return fontPath_;
+}
+
+bool KoreanFontAtlas::requestGlyphs(std::string_view utf8Text) {
+    if (!isKoreanFontLoaded()) {
+        return false;
+    }
+
+    std::size_t index = 0;
+    while (index < utf8Text.size()) {
+        const std::uint32_t codepoint = decodeUtf8(utf8Text, index);
+        // ImWchar is 16-bit; anything outside the BMP cannot be baked anyway.
+        if (codepoint < 0x80 || codepoint > 0xFFFF || requestedGlyphs_.GetBit(codepoint)) {
+            continue;
+        }
+
+        requestedGlyphs_.SetBit(codepoint);
+        rebuildPending_ = true;
+    }
+    return rebuildPending_;
+}
+
+bool KoreanFontAtlas::rebuildIfNeeded() {
+    if (!rebuildPending_) {
+        return false;
+    }
+
+    rebuildPending_ = false;
+    buildAtlas();
+    ImGui_ImplSDLRenderer2_DestroyFontsTexture();
+    ImGui_ImplSDLRenderer2_CreateFontsTexture();
+    return true;
+}
+
+int KoreanFontAtlas::glyphCount() const {
+    return glyphCount_;
+}
+
+double KoreanFontAtlas::lastBuildMs() const {
+    return lastBuildMs_;
+}
+
+void KoreanFontAtlas::buildAtlas() {
+    const auto buildStart = std::chrono::steady_clock::now();
+
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    atlas->Clear();
+
+    glyphRanges_.clear();
+    glyphCount_ = 0;
+    if (isKoreanFontLoaded()) {
+        requestedGlyphs_.BuildRanges(&glyphRanges_);
+        for (int i = 0; i + 1 < glyphRanges_.Size && glyphRanges_[i] != 0; i += 2) {
+            glyphCount_ += glyphRanges_[i + 1] - glyphRanges_[i] + 1;
+        }
+
+        // The atlas keeps pointing at fontData_ instead of taking a copy.
+        ImFontConfig config;
+        config.FontDataOwnedByAtlas = false;
+        const ImFont* font = atlas->AddFontFromMemoryTTF(
+            fontData_.data(),
+            static_cast<int>(fontData_.size()),
+            sizePixels_,
+            &config,
+            glyphRanges_.Data
+        );
+        if (font == nullptr) {
+            fontData_.clear();
+            fontPath_.clear();
+            glyphCount_ = 0;
+        }
+    }
+    if (!isKoreanFontLoaded()) {
+        atlas->AddFontDefault();
+    }
+    atlas->Build();
+
+    lastBuildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+}
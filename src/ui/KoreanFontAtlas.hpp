@@ -0,0 +1,45 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// UI font with Hangul glyphs baked on demand. Startup only rasterizes
+// Latin-1 and the compatibility jamo; syllables are added to the atlas the
+// first time they show up in text passed to requestGlyphs(), and the atlas
+// and its texture are rebuilt before the next frame. The font file is read
+// once and kept in memory for those rebuilds.
+class KoreanFontAtlas {
+public:
+    // Loads the first available system Korean font, or ImGui's default font
+    // when none is found. Call before the renderer backend is initialized.
+    bool load(float sizePixels);
+
+    bool isKoreanFontLoaded() const;
+    const std::string& fontPath() const;
+
+    // Queues any characters of utf8Text that are not baked yet. Returns true
+    // when the atlas has to be rebuilt.
+    bool requestGlyphs(std::string_view utf8Text);
+
+    // Rebuilds the atlas and the renderer's font texture if glyphs were
+    // requested. Call between frames, before ImGui_ImplSDLRenderer2_NewFrame.
+    bool rebuildIfNeeded();
+
+    int glyphCount() const;
+    double lastBuildMs() const;
+
+private:
+    void buildAtlas();
+
+    std::vector<char> fontData_;
+    std::string fontPath_;
+    float sizePixels_ = 18.0f;
+    ImFontGlyphRangesBuilder requestedGlyphs_;
+    ImVector<ImWchar> glyphRanges_;
+    bool rebuildPending_ = false;
+    int glyphCount_ = 0;
+    double lastBuildMs_ = 0.0;
+};
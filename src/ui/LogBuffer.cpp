@@ -0,0 +1,221 @@
+#include "ui/LogBuffer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace {
+struct SeverityPrefix {
+    LogSeverity severity;
+    std::string_view prefix;
+};
+
+constexpr SeverityPrefix kSeverityPrefixes[] = {
+    {LogSeverity::Info, "[INFO] "},
+    {LogSeverity::Warning, "[WARN] "},
+    {LogSeverity::Error, "[ERROR] "},
+};
+
+char toLowerAscii(char ch) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+}
+
+// lowerCaseNeedle must already be lower case and non-empty.
+bool containsIgnoringCase(std::string_view haystack, std::string_view lowerCaseNeedle) {
+    if (lowerCaseNeedle.size() > haystack.size()) {
+        return false;
+    }
+
+    const char first = lowerCaseNeedle.front();
+    const std::size_t lastStart = haystack.size() - lowerCaseNeedle.size();
+    for (std::size_t start = 0; start <= lastStart; ++start) {
+        if (toLowerAscii(haystack[start]) != first) {
+            continue;
+        }
+
+        std::size_t matched = 1;
+        while (matched < lowerCaseNeedle.size() && toLowerAscii(haystack[start + matched]) == lowerCaseNeedle[matched]) {
+            ++matched;
+        }
+        if (matched == lowerCaseNeedle.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+const char* getLogSeverityTag(LogSeverity severity) {
+    switch (severity) {
+    case LogSeverity::Info:
+        return "INFO";
+    case LogSeverity::Warning:
+        return "WARN";
+    case LogSeverity::Error:
+        return "ERROR";
+    }
+    return "INFO";
+}
+
+void formatLogTimestamp(std::int64_t timestampMs, char* buffer, std::size_t bufferSize) {
+    const std::time_t seconds = static_cast<std::time_t>(timestampMs / 1000);
+    const int milliseconds = static_cast<int>(timestampMs % 1000);
+    const std::tm* localTime = std::localtime(&seconds);
+    if (localTime == nullptr) {
+        std::snprintf(buffer, bufferSize, "--:--:--.---");
+        return;
+    }
+
+    std::snprintf(
+        buffer,
+        bufferSize,
+        "%02d:%02d:%02d.%03d",
+        localTime->tm_hour,
+        localTime->tm_min,
+        localTime->tm_sec,
+        milliseconds
+    );
+}
+
+LogBuffer::LogBuffer(std::size_t recordCapacity, std::size_t arenaBytes)
+    : records_(std::max<std::size_t>(1, recordCapacity)),
+      recordArenaBytes_(records_.size(), 0),
+      arena_(std::make_unique<char[]>(std::max<std::size_t>(64, arenaBytes))),
+      arenaBytes_(std::max<std::size_t>(64, arenaBytes)) {}
+
+void LogBuffer::append(LogSeverity severity, std::string_view text) {
+    // A quarter of the arena per line keeps one huge line from flushing
+    // the whole history.
+    text = text.substr(0, arenaBytes_ / 4);
+
+    if (size() == records_.size()) {
+        dropOldest();
+    }
+
+    // Text never wraps around the end of the arena; a line that does not fit
+    // in the remaining tail starts over at offset 0 and also holds the tail.
+    const std::size_t padding = (arenaHead_ + text.size() > arenaBytes_) ? arenaBytes_ - arenaHead_ : 0;
+    const std::size_t reservedBytes = padding + text.size();
+    while (arenaUsedBytes_ + reservedBytes > arenaBytes_) {
+        dropOldest();
+    }
+
+    const std::size_t textOffset = padding > 0 ? 0 : arenaHead_;
+    if (!text.empty()) {
+        std::memcpy(arena_.get() + textOffset, text.data(), text.size());
+    }
+    arenaHead_ = (textOffset + text.size()) % arenaBytes_;
+    arenaUsedBytes_ += reservedBytes;
+
+    const std::size_t slot = static_cast<std::size_t>(endSequence_ % records_.size());
+    LogRecord& record = records_[slot];
+    record.sequence = endSequence_;
+    record.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    record.textOffset = static_cast<std::uint32_t>(textOffset);
+    record.textLength = static_cast<std::uint32_t>(text.size());
+    record.severity = severity;
+    recordArenaBytes_[slot] = static_cast<std::uint32_t>(reservedBytes);
+    ++endSequence_;
+}
+
+void LogBuffer::append(std::string_view line) {
+    for (const SeverityPrefix& entry : kSeverityPrefixes) {
+        if (line.substr(0, entry.prefix.size()) == entry.prefix) {
+            append(entry.severity, line.substr(entry.prefix.size()));
+            return;
+        }
+    }
+    append(LogSeverity::Info, line);
+}
+
+void LogBuffer::clear() {
+    droppedCount_ = 0;
+    firstSequence_ = endSequence_;
+    arenaHead_ = 0;
+    arenaUsedBytes_ = 0;
+}
+
+std::size_t LogBuffer::size() const {
+    return static_cast<std::size_t>(endSequence_ - firstSequence_);
+}
+
+std::uint64_t LogBuffer::firstSequence() const {
+    return firstSequence_;
+}
+
+std::uint64_t LogBuffer::endSequence() const {
+    return endSequence_;
+}
+
+std::uint64_t LogBuffer::droppedCount() const {
+    return droppedCount_;
+}
+
+const LogRecord& LogBuffer::record(std::uint64_t sequence) const {
+    return records_[static_cast<std::size_t>(sequence % records_.size())];
+}
+
+std::string_view LogBuffer::text(const LogRecord& record) const {
+    return std::string_view(arena_.get() + record.textOffset, record.textLength);
+}
+
+void LogBuffer::dropOldest() {
+    const std::size_t slot = static_cast<std::size_t>(firstSequence_ % records_.size());
+    arenaUsedBytes_ -= recordArenaBytes_[slot];
+    ++firstSequence_;
+    ++droppedCount_;
+}
+
+void LogFilter::setSeverityMask(unsigned severityMask) {
+    if (severityMask != severityMask_) {
+        severityMask_ = severityMask;
+        dirty_ = true;
+    }
+}
+
+void LogFilter::setQuery(std::string_view query) {
+    std::string lowerCaseQuery(query);
+    std::transform(lowerCaseQuery.begin(), lowerCaseQuery.end(), lowerCaseQuery.begin(), toLowerAscii);
+    if (lowerCaseQuery != lowerCaseQuery_) {
+        lowerCaseQuery_ = std::move(lowerCaseQuery);
+        dirty_ = true;
+    }
+}
+
+const std::vector<std::uint64_t>& LogFilter::update(const LogBuffer& buffer) {
+    if (dirty_) {
+        matchingSequences_.clear();
+        scannedEndSequence_ = buffer.firstSequence();
+        dirty_ = false;
+    }
+
+    // Forget records the buffer has dropped since the last update.
+    const auto firstLive = std::lower_bound(matchingSequences_.begin(), matchingSequences_.end(), buffer.firstSequence());
+    matchingSequences_.erase(matchingSequences_.begin(), firstLive);
+    scannedEndSequence_ = std::max(scannedEndSequence_, buffer.firstSequence());
+
+    for (std::uint64_t sequence = scannedEndSequence_; sequence < buffer.endSequence(); ++sequence) {
+        if (matches(buffer, buffer.record(sequence))) {
+            matchingSequences_.push_back(sequence);
+        }
+    }
+    scannedEndSequence_ = buffer.endSequence();
+
+    return matchingSequences_;
+}
+
+bool LogFilter::matches(const LogBuffer& buffer, const LogRecord& record) const {
+    if ((severityMask_ & severityBit(record.severity)) == 0) {
+        return false;
+    }
+    if (lowerCaseQuery_.empty()) {
+        return true;
+    }
+
+    return containsIgnoringCase(buffer.text(record), lowerCaseQuery_);
+}
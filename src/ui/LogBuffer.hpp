@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class LogSeverity : std::uint8_t {
+    Info,
+    Warning,
+    Error,
+};
+
+const char* getLogSeverityTag(LogSeverity severity);
+
+// Local wall-clock time as "HH:MM:SS.mmm".
+void formatLogTimestamp(std::int64_t timestampMs, char* buffer, std::size_t bufferSize);
+
+struct LogRecord {
+    std::uint64_t sequence = 0;
+    std::int64_t timestampMs = 0; // system_clock, milliseconds since the epoch
+    std::uint32_t textOffset = 0;
+    std::uint32_t textLength = 0;
+    LogSeverity severity = LogSeverity::Info;
+};
+
+// Fixed-capacity log store. Records live in a ring of recordCapacity entries
+// and their text in one circular character arena of arenaBytes, so memory is
+// allocated once and never grows; when either fills up the oldest records are
+// dropped. Every record gets an increasing sequence number, and the live
+// records are exactly [firstSequence(), endSequence()).
+class LogBuffer {
+public:
+    explicit LogBuffer(std::size_t recordCapacity = 16384, std::size_t arenaBytes = std::size_t{2} << 20);
+
+    void append(LogSeverity severity, std::string_view text);
+
+    // Takes the "[INFO] ", "[WARN] " or "[ERROR] " prefix used by the
+    // generation logs as the severity and stores the rest of the line.
+    void append(std::string_view line);
+
+    void clear();
+
+    std::size_t size() const;
+    std::uint64_t firstSequence() const;
+    std::uint64_t endSequence() const;
+    std::uint64_t droppedCount() const;
+
+    // sequence must be in [firstSequence(), endSequence()).
+    const LogRecord& record(std::uint64_t sequence) const;
+    std::string_view text(const LogRecord& record) const;
+
+private:
+    void dropOldest();
+
+    std::vector<LogRecord> records_;
+    // Arena bytes each record holds, including any skipped tail before it.
+    std::vector<std::uint32_t> recordArenaBytes_;
+    std::unique_ptr<char[]> arena_;
+    std::size_t arenaBytes_ = 0;
+    std::size_t arenaHead_ = 0;
+    std::size_t arenaUsedBytes_ = 0;
+    std::uint64_t firstSequence_ = 0;
+    std::uint64_t endSequence_ = 0;
+    std::uint64_t droppedCount_ = 0;
+};
+
+// Incrementally maintained list of the records that pass a severity mask and
+// a case-insensitive substring query. update() only scans records appended
+// since the previous call unless the filter itself changed.
+class LogFilter {
+public:
+    static constexpr unsigned kAllSeverities = 0b111;
+
+    static unsigned severityBit(LogSeverity severity) {
+        return 1u << static_cast<unsigned>(severity);
+    }
+
+    void setSeverityMask(unsigned severityMask);
+    void setQuery(std::string_view query);
+
+    // Returns the sequence numbers of the matching live records, oldest first.
+    const std::vector<std::uint64_t>& update(const LogBuffer& buffer);
+
+private:
+    bool matches(const LogBuffer& buffer, const LogRecord& record) const;
+
+    unsigned severityMask_ = kAllSeverities;
+    std::string lowerCaseQuery_;
+    bool dirty_ = true;
+    std::uint64_t scannedEndSequence_ = 0;
+    std::vector<std::uint64_t> matchingSequences_;
+};
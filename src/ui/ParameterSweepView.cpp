@@ -0,0 +1,182 @@
+#include "ui/ParameterSweepView.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+// Slowest and fastest sampled cell, so time is shaded relative to the sweep.
+struct TimeRange {
+    double minSeconds = 0.0;
+    double maxSeconds = 0.0;
+};
+
+TimeRange getTimeRange(const ParameterSweepResult& result) {
+    TimeRange range;
+    bool first = true;
+    for (const ParameterSweepCell& cell : result.cells) {
+        if (cell.sampledStageCount == 0) {
+            continue;
+        }
+        range.minSeconds = first ? cell.secondsPerStage : std::min(range.minSeconds, cell.secondsPerStage);
+        range.maxSeconds = first ? cell.secondsPerStage : std::max(range.maxSeconds, cell.secondsPerStage);
+        first = false;
+    }
+    return range;
+}
+
+// 0 is the worst value of the metric and 1 the best.
+float getCellScore(const ParameterSweepCell& cell, ParameterSweepMetric metric, const TimeRange& timeRange) {
+    switch (metric) {
+    case ParameterSweepMetric::AcceptanceRate:
+        return static_cast<float>(cell.acceptanceRate());
+    case ParameterSweepMetric::TimePerStage: {
+        const double span = timeRange.maxSeconds - timeRange.minSeconds;
+        return span > 0.0 ? static_cast<float>((timeRange.maxSeconds - cell.secondsPerStage) / span) : 1.0f;
+    }
+    case ParameterSweepMetric::FailureRate:
+        return 1.0f - static_cast<float>(cell.failureRate());
+    }
+    return 0.0f;
+}
+
+// Red through yellow to green; impossible layouts are grey.
+ImU32 getCellColor(const ParameterSweepCell& cell, float score) {
+    if (!cell.arrangementPossible) {
+        return IM_COL32(90, 90, 90, 160);
+    }
+    const float clamped = std::clamp(score, 0.0f, 1.0f);
+    const int red = static_cast<int>(220.0f * std::min(1.0f, 2.0f * (1.0f - clamped)));
+    const int green = static_cast<int>(180.0f * std::min(1.0f, 2.0f * clamped));
+    return IM_COL32(red, green, 40, 160);
+}
+
+void formatCellValue(const ParameterSweepCell& cell, ParameterSweepMetric metric, char* buffer, std::size_t bufferSize) {
+    switch (metric) {
+    case ParameterSweepMetric::AcceptanceRate:
+        std::snprintf(buffer, bufferSize, "%.1f%%", cell.acceptanceRate() * 100.0);
+        return;
+    case ParameterSweepMetric::TimePerStage:
+        std::snprintf(buffer, bufferSize, "%.2f us", cell.secondsPerStage * 1'000'000.0);
+        return;
+    case ParameterSweepMetric::FailureRate:
+        std::snprintf(buffer, bufferSize, "%.1f%%", cell.failureRate() * 100.0);
+        return;
+    }
+}
+
+void drawCellTooltip(const ParameterSweepCell& cell) {
+    ImGui::BeginTooltip();
+    ImGui::Text("%d x %d, %s mode", cell.mapWidth, cell.mapHeight, cell.isMultiplayerMode ? "Multi" : "Single");
+    if (!cell.arrangementPossible) {
+        ImGui::TextUnformatted("Impossible layout: shuffled without avoiding vertical matches.");
+    }
+    ImGui::Text("%d stage(s) sampled, %.2f us per stage", cell.sampledStageCount, cell.secondsPerStage * 1'000'000.0);
+    ImGui::Text(
+        "Accepted as shuffled: %llu (%.1f%%)",
+        static_cast<unsigned long long>(cell.validAfterShuffleCount),
+        cell.acceptanceRate() * 100.0
+    );
+    ImGui::Text("Repaired by swaps: %llu", static_cast<unsigned long long>(cell.repairedCount));
+    ImGui::Text("Rebuilt by the placer: %llu", static_cast<unsigned long long>(cell.placedCount));
+    ImGui::Text(
+        "Left with vertical matches: %llu (%.1f%%)",
+        static_cast<unsigned long long>(cell.failedCount),
+        cell.failureRate() * 100.0
+    );
+    ImGui::TextDisabled("Click to use this size and mode.");
+    ImGui::EndTooltip();
+}
+} // namespace
+
+const ParameterSweepCell* drawParameterSweepWindow(
+    const ParameterSweepResult& result,
+    ParameterSweepViewState& state,
+    bool* open
+) {
+    ImGui::SetNextWindowSize(ImVec2(560.0f, 520.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Parameter Sweep", open)) {
+        ImGui::End();
+        return nullptr;
+    }
+
+    if (result.cells.empty()) {
+        ImGui::TextUnformatted("Press 'Run Parameter Sweep' in the Control Panel.");
+        ImGui::End();
+        return nullptr;
+    }
+
+    const ParameterSweepSettings& settings = result.settings;
+    ImGui::Text(
+        "%zu cell(s), %d stage(s) each, master seed %llu, %.2f s%s",
+        result.cells.size(),
+        settings.samplesPerCell,
+        static_cast<unsigned long long>(settings.masterSeed),
+        result.wallSeconds,
+        result.cancelled ? " (cancelled)" : ""
+    );
+
+    static const char* const kMetricNames[] = {"Accepted as shuffled", "Time per stage", "Left with vertical matches"};
+    int metricIndex = static_cast<int>(state.metric);
+    ImGui::SetNextItemWidth(240.0f);
+    if (ImGui::Combo("Metric", &metricIndex, kMetricNames, IM_ARRAYSIZE(kMetricNames))) {
+        state.metric = static_cast<ParameterSweepMetric>(metricIndex);
+    }
+
+    const TimeRange timeRange = getTimeRange(result);
+    const int columnCount = settings.maxMapWidth - settings.minMapWidth + 2;
+    const ParameterSweepCell* clickedCell = nullptr;
+    for (const bool isMultiplayerMode : {false, true}) {
+        if (!(isMultiplayerMode ? settings.includeMultiMode : settings.includeSingleMode)) {
+            continue;
+        }
+
+        ImGui::Separator();
+        ImGui::Text("%s Mode (rows: height, columns: width)", isMultiplayerMode ? "Multi" : "Single");
+        ImGui::PushID(isMultiplayerMode ? 1 : 0);
+        const ImGuiTableFlags tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollX;
+        if (ImGui::BeginTable("SweepHeatmap", columnCount, tableFlags)) {
+            ImGui::TableSetupColumn("H \\ W");
+            for (int mapWidth = settings.minMapWidth; mapWidth <= settings.maxMapWidth; ++mapWidth) {
+                char header[16];
+                std::snprintf(header, sizeof(header), "%d", mapWidth);
+                ImGui::TableSetupColumn(header);
+            }
+            ImGui::TableHeadersRow();
+
+            for (int mapHeight = settings.minMapHeight; mapHeight <= settings.maxMapHeight; ++mapHeight) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", mapHeight);
+                for (int mapWidth = settings.minMapWidth; mapWidth <= settings.maxMapWidth; ++mapWidth) {
+                    ImGui::TableNextColumn();
+                    const ParameterSweepCell* cell = result.findCell(mapWidth, mapHeight, isMultiplayerMode);
+                    if (cell == nullptr || cell->sampledStageCount == 0) {
+                        ImGui::TextDisabled("-");
+                        continue;
+                    }
+
+                    const ImU32 cellColor = getCellColor(*cell, getCellScore(*cell, state.metric, timeRange));
+                    ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, cellColor);
+                    char label[32];
+                    formatCellValue(*cell, state.metric, label, sizeof(label));
+                    ImGui::PushID(mapHeight * (settings.maxMapWidth + 1) + mapWidth);
+                    if (ImGui::Selectable(label)) {
+                        clickedCell = cell;
+                    }
+                    ImGui::PopID();
+                    if (ImGui::IsItemHovered()) {
+                        drawCellTooltip(*cell);
+                    }
+                }
+            }
+            ImGui::EndTable();
+        }
+        ImGui::PopID();
+    }
+
+    ImGui::TextDisabled("Grey cells cannot avoid vertical matches at all.");
+    ImGui::End();
+    return clickedCell;
+}
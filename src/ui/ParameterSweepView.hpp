@@ -0,0 +1,22 @@
+#pragma once
+
+#include "core/ParameterSweep.hpp"
+
+enum class ParameterSweepMetric {
+    AcceptanceRate,
+    TimePerStage,
+    FailureRate,
+};
+
+struct ParameterSweepViewState {
+    ParameterSweepMetric metric = ParameterSweepMetric::AcceptanceRate;
+};
+
+// The "Parameter Sweep" window: one heatmap per mode of the chosen metric,
+// heights as rows and widths as columns, with every count in the tooltip of
+// a cell. Returns the cell clicked this frame, or nullptr.
+const ParameterSweepCell* drawParameterSweepWindow(
+    const ParameterSweepResult& result,
+    ParameterSweepViewState& state,
+    bool* open
+);
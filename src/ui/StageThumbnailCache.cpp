@@ -0,0 +1,209 @@
+#include "ui/StageThumbnailCache.hpp"
+
+#include "core/StageGenerator.hpp"
+#include "core/StageRandom.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+
+namespace {
+constexpr int kMaxTilePixels = 6;
+constexpr std::uint32_t kBackgroundColor = 0xFF202020u;
+constexpr std::uint32_t kInvalidStageColor = 0xFFE04030u;
+
+int getLayoutColumns(const StageThumbnailLayout& layout) {
+    return layout.mapCount * layout.mapWidth + std::max(0, layout.mapCount - 1);
+}
+
+// Every channel stays in 70..229, clear of the background and of white.
+std::uint32_t getTileColor(Tile tile) {
+    const std::uint64_t hash = splitMix64(tile);
+    auto channel = [hash](int shift) {
+        return 70u + static_cast<std::uint32_t>((hash >> shift) & 0xFFu) * 160u / 256u;
+    };
+    return 0xFF000000u | (channel(0) << 16) | (channel(8) << 8) | channel(16);
+}
+} // namespace
+
+StageThumbnailSize getStageThumbnailSize(const StageThumbnailLayout& layout) {
+    const int columns = getLayoutColumns(layout);
+    const int rows = layout.mapHeight;
+    if (layout.mapCount <= 0 || layout.mapWidth <= 0 || rows <= 0) {
+        return {};
+    }
+
+    const int largestSide = std::max(columns, rows);
+    if (largestSide <= StageThumbnailCache::kMaxSide) {
+        const int tilePixels = std::min(kMaxTilePixels, StageThumbnailCache::kMaxSide / largestSide);
+        return StageThumbnailSize{columns * tilePixels, rows * tilePixels};
+    }
+    return StageThumbnailSize{
+        std::max(1, static_cast<int>(static_cast<std::int64_t>(columns) * StageThumbnailCache::kMaxSide / largestSide)),
+        std::max(1, static_cast<int>(static_cast<std::int64_t>(rows) * StageThumbnailCache::kMaxSide / largestSide)),
+    };
+}
+
+StageThumbnailCache::StageThumbnailCache(SDL_Renderer* renderer, int capacity)
+    : renderer_(renderer),
+      slots_(static_cast<std::size_t>(std::max(1, capacity))) {
+    stageSlots_.reserve(slots_.size());
+    pixels_.reserve(static_cast<std::size_t>(kMaxSide) * kMaxSide);
+}
+
+StageThumbnailCache::~StageThumbnailCache() {
+    clear();
+}
+
+void StageThumbnailCache::beginFrame(int maxBuilds) {
+    buildBudget_ = maxBuilds;
+    deferredBuilds_ = false;
+}
+
+SDL_Texture* StageThumbnailCache::thumbnail(
+    int stageIndex,
+    std::uint64_t contentHash,
+    const StageThumbnailLayout& layout,
+    const std::function<const Tile*()>& loadTiles
+) {
+    if (getStageThumbnailSize(layout).width == 0) {
+        return nullptr;
+    }
+
+    ++useClock_;
+    const auto found = stageSlots_.find(stageIndex);
+    if (found != stageSlots_.end()) {
+        Slot& slot = slots_[static_cast<std::size_t>(found->second)];
+        if (slot.contentHash == contentHash && slot.layout == layout) {
+            slot.lastUse = useClock_;
+            return slot.texture;
+        }
+    }
+
+    if (buildBudget_ <= 0) {
+        deferredBuilds_ = true;
+        return nullptr;
+    }
+    --buildBudget_;
+
+    const Tile* tiles = loadTiles();
+    if (tiles == nullptr) {
+        return nullptr;
+    }
+    Slot& slot = slots_[static_cast<std::size_t>(acquireSlot(stageIndex))];
+    if (!build(slot, layout, tiles)) {
+        stageSlots_.erase(stageIndex);
+        slot.stageIndex = -1;
+        slot.lastUse = 0;
+        return nullptr;
+    }
+    slot.contentHash = contentHash;
+    slot.layout = layout;
+    slot.lastUse = useClock_;
+    ++builtCount_;
+    return slot.texture;
+}
+
+void StageThumbnailCache::clear() {
+    for (Slot& slot : slots_) {
+        if (slot.texture != nullptr) {
+            SDL_DestroyTexture(slot.texture);
+        }
+        slot = Slot{};
+    }
+    stageSlots_.clear();
+}
+
+int StageThumbnailCache::acquireSlot(int stageIndex) {
+    const auto found = stageSlots_.find(stageIndex);
+    if (found != stageSlots_.end()) {
+        return found->second;
+    }
+
+    // Only scanned on a miss; hits go through stageSlots_.
+    std::size_t victim = 0;
+    for (std::size_t slotIndex = 0; slotIndex < slots_.size(); ++slotIndex) {
+        if (slots_[slotIndex].lastUse < slots_[victim].lastUse) {
+            victim = slotIndex;
+        }
+    }
+
+    Slot& slot = slots_[victim];
+    if (slot.stageIndex >= 0) {
+        stageSlots_.erase(slot.stageIndex);
+    }
+    slot.stageIndex = stageIndex;
+    stageSlots_[stageIndex] = static_cast<int>(victim);
+    return static_cast<int>(victim);
+}
+
+bool StageThumbnailCache::build(Slot& slot, const StageThumbnailLayout& layout, const Tile* tiles) {
+    const StageThumbnailSize size = getStageThumbnailSize(layout);
+    if (size.width == 0) {
+        return false;
+    }
+
+    const int columns = getLayoutColumns(layout);
+    const int rows = layout.mapHeight;
+    const std::size_t mapTileCount = static_cast<std::size_t>(layout.mapWidth) * layout.mapHeight;
+    // Tiles at least three pixels wide get a one-pixel gap to their neighbours.
+    const bool drawGaps = size.width >= 3 * columns && size.height >= 3 * rows;
+
+    pixels_.assign(static_cast<std::size_t>(size.width) * size.height, kBackgroundColor);
+    for (int y = 0; y < size.height; ++y) {
+        const int row = y * rows / size.height;
+        if (drawGaps && (y + 1) * rows / size.height != row) {
+            continue;
+        }
+
+        std::uint32_t* pixelRow = pixels_.data() + static_cast<std::size_t>(y) * size.width;
+        for (int x = 0; x < size.width; ++x) {
+            const int column = x * columns / size.width;
+            if (drawGaps && (x + 1) * columns / size.width != column) {
+                continue;
+            }
+
+            const int mapIndex = column / (layout.mapWidth + 1);
+            const int mapColumn = column % (layout.mapWidth + 1);
+            if (mapColumn == layout.mapWidth) {
+                continue;
+            }
+            const std::size_t tileIndex = mapIndex * mapTileCount + static_cast<std::size_t>(row) * layout.mapWidth + mapColumn;
+            pixelRow[x] = getTileColor(tiles[tileIndex]);
+        }
+    }
+
+    bool valid = true;
+    for (int mapIndex = 0; mapIndex < layout.mapCount && valid; ++mapIndex) {
+        MapView map;
+        map.width = layout.mapWidth;
+        map.height = layout.mapHeight;
+        map.tiles = tiles + mapIndex * mapTileCount;
+        valid = !hasVerticalMatchingTiles(map);
+    }
+    if (!valid) {
+        for (int x = 0; x < size.width; ++x) {
+            pixels_[static_cast<std::size_t>(x)] = kInvalidStageColor;
+            pixels_[static_cast<std::size_t>(size.height - 1) * size.width + x] = kInvalidStageColor;
+        }
+        for (int y = 0; y < size.height; ++y) {
+            pixels_[static_cast<std::size_t>(y) * size.width] = kInvalidStageColor;
+            pixels_[static_cast<std::size_t>(y) * size.width + size.width - 1] = kInvalidStageColor;
+        }
+    }
+
+    if (slot.texture != nullptr && (slot.textureSize.width != size.width || slot.textureSize.height != size.height)) {
+        SDL_DestroyTexture(slot.texture);
+        slot.texture = nullptr;
+    }
+    if (slot.texture == nullptr) {
+        slot.texture = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, size.width, size.height);
+        if (slot.texture == nullptr) {
+            return false;
+        }
+        // Tiles stay crisp blocks when the gallery scales thumbnails up.
+        SDL_SetTextureScaleMode(slot.texture, SDL_ScaleModeNearest);
+        slot.textureSize = size;
+    }
+    return SDL_UpdateTexture(slot.texture, nullptr, pixels_.data(), size.width * static_cast<int>(sizeof(std::uint32_t))) == 0;
+}
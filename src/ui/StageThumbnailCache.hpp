@@ -0,0 +1,100 @@
+#pragma once
+
+#include "core/StageStore.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+struct SDL_Renderer;
+struct SDL_Texture;
+
+// What a stage thumbnail shows: its maps side by side, one tile apart.
+struct StageThumbnailLayout {
+    int mapWidth = 0;
+    int mapHeight = 0;
+    int mapCount = 0;
+
+    bool operator==(const StageThumbnailLayout& other) const = default;
+};
+
+struct StageThumbnailSize {
+    int width = 0;
+    int height = 0;
+};
+
+// Texture size for layout: a few pixels per tile for small maps, one sampled
+// tile per pixel once a side would exceed kMaxSide.
+StageThumbnailSize getStageThumbnailSize(const StageThumbnailLayout& layout);
+
+// Stage thumbnails rasterized once on the CPU and uploaded into textures of
+// the app's SDL_Renderer. A thumbnail is keyed by its stage index and a hash
+// of the stage's content, so it is rebuilt only when the stage it shows
+// changes; the least recently used one is replaced when the cache is full.
+// Builds per frame are capped, so scrolling through a large batch never
+// stalls a frame on hundreds of uploads.
+class StageThumbnailCache {
+public:
+    static constexpr int kMaxSide = 96;
+    static constexpr int kDefaultCapacity = 512;
+    static constexpr int kDefaultBuildsPerFrame = 48;
+
+    explicit StageThumbnailCache(SDL_Renderer* renderer, int capacity = kDefaultCapacity);
+    ~StageThumbnailCache();
+    StageThumbnailCache(const StageThumbnailCache&) = delete;
+    StageThumbnailCache& operator=(const StageThumbnailCache&) = delete;
+
+    // Starts a frame with a budget of maxBuilds thumbnail builds.
+    void beginFrame(int maxBuilds = kDefaultBuildsPerFrame);
+
+    // The thumbnail of stageIndex, built from loadTiles() (layout.mapCount
+    // maps stacked on top of each other) unless the cached one has the same
+    // contentHash and layout. nullptr while this frame's budget is spent or
+    // if the texture could not be created.
+    SDL_Texture* thumbnail(
+        int stageIndex,
+        std::uint64_t contentHash,
+        const StageThumbnailLayout& layout,
+        const std::function<const Tile*()>& loadTiles
+    );
+
+    // True if a thumbnail was left unbuilt this frame for lack of budget.
+    bool hasDeferredBuilds() const {
+        return deferredBuilds_;
+    }
+
+    // Destroys every texture. Must run before the renderer is destroyed.
+    void clear();
+
+    int cachedCount() const {
+        return static_cast<int>(stageSlots_.size());
+    }
+
+    std::uint64_t builtCount() const {
+        return builtCount_;
+    }
+
+private:
+    struct Slot {
+        int stageIndex = -1;
+        std::uint64_t contentHash = 0;
+        StageThumbnailLayout layout;
+        std::uint64_t lastUse = 0;
+        SDL_Texture* texture = nullptr;
+        StageThumbnailSize textureSize;
+    };
+
+    int acquireSlot(int stageIndex);
+    bool build(Slot& slot, const StageThumbnailLayout& layout, const Tile* tiles);
+
+    SDL_Renderer* renderer_ = nullptr;
+    std::vector<Slot> slots_;
+    std::unordered_map<int, int> stageSlots_;
+    // ARGB8888 pixels of the thumbnail being built, reused across builds.
+    std::vector<std::uint32_t> pixels_;
+    std::uint64_t useClock_ = 0;
+    std::uint64_t builtCount_ = 0;
+    int buildBudget_ = 0;
+    bool deferredBuilds_ = false;
+};
@@ -0,0 +1,125 @@
+#include "ui/TileGridRenderer.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+std::string_view TileLabelCache::label(Tile tile) {
+    ensureCapacity(tile);
+
+    char* slot = slots_.data() + static_cast<std::size_t>(tile) * kSlotSize;
+    if (slot[0] == 0) {
+        char* const end = std::to_chars(slot + 1, slot + kSlotSize, tile).ptr;
+        slot[0] = static_cast<char>(end - (slot + 1));
+    }
+    return std::string_view(slot + 1, static_cast<std::size_t>(slot[0]));
+}
+
+float TileLabelCache::labelWidth(Tile tile) {
+    const ImFont* font = ImGui::GetFont();
+    const float fontSize = ImGui::GetFontSize();
+    if (font != measuredFont_ || fontSize != measuredFontSize_) {
+        std::fill(widths_.begin(), widths_.end(), kUnmeasuredWidth);
+        measuredFont_ = font;
+        measuredFontSize_ = fontSize;
+    }
+
+    const std::string_view text = label(tile);
+    float& width = widths_[tile];
+    if (width == kUnmeasuredWidth) {
+        width = ImGui::CalcTextSize(text.data(), text.data() + text.size()).x;
+    }
+    return width;
+}
+
+void TileLabelCache::ensureCapacity(Tile tile) {
+    const std::size_t labelCount = static_cast<std::size_t>(tile) + 1;
+    if (widths_.size() < labelCount) {
+        slots_.resize(labelCount * kSlotSize, 0);
+        widths_.resize(labelCount, kUnmeasuredWidth);
+    }
+}
+
+int drawTileGrid(const char* id, const MapView& map, TileLabelCache& labelCache, const TileGridStyle& style) {
+    if (map.width <= 0 || map.height <= 0) {
+        return -1;
+    }
+
+    const float pitch = style.tileSize + style.tileGap;
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const ImVec2 gridSize(map.width * pitch - style.tileGap, map.height * pitch - style.tileGap);
+
+    // One item for the whole grid: it gives the window its scroll extent and
+    // the hover state, without a widget (or an ID) per tile.
+    ImGui::InvisibleButton(id, gridSize);
+    const bool gridHovered = ImGui::IsItemHovered();
+    const bool gridActive = ImGui::IsItemActive();
+
+    int hoveredTileIndex = -1;
+    if (gridHovered) {
+        const ImVec2 mousePosition = ImGui::GetIO().MousePos;
+        const float localX = mousePosition.x - origin.x;
+        const float localY = mousePosition.y - origin.y;
+        const int col = static_cast<int>(localX / pitch);
+        const int row = static_cast<int>(localY / pitch);
+
+        // The gaps between tiles do not belong to any tile.
+        const bool insideTile = localX - col * pitch < style.tileSize && localY - row * pitch < style.tileSize;
+        if (col >= 0 && col < map.width && row >= 0 && row < map.height && insideTile) {
+            hoveredTileIndex = row * map.width + col;
+        }
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const ImVec2 clipMin = drawList->GetClipRectMin();
+    const ImVec2 clipMax = drawList->GetClipRectMax();
+
+    auto visibleRange = [pitch](float clipBegin, float clipEnd, float gridOrigin, int cellCount, int& first, int& last) {
+        first = std::clamp(static_cast<int>(std::floor((clipBegin - gridOrigin) / pitch)), 0, cellCount);
+        last = std::clamp(static_cast<int>(std::ceil((clipEnd - gridOrigin) / pitch)), 0, cellCount);
+    };
+
+    int firstCol = 0;
+    int lastCol = 0;
+    int firstRow = 0;
+    int lastRow = 0;
+    visibleRange(clipMin.x, clipMax.x, origin.x, map.width, firstCol, lastCol);
+    visibleRange(clipMin.y, clipMax.y, origin.y, map.height, firstRow, lastRow);
+
+    const ImGuiStyle& imguiStyle = ImGui::GetStyle();
+    const ImU32 tileColor = ImGui::GetColorU32(ImGuiCol_Button);
+    const ImU32 hoveredTileColor = ImGui::GetColorU32(gridActive ? ImGuiCol_ButtonActive : ImGuiCol_ButtonHovered);
+    const ImU32 textColor = ImGui::GetColorU32(ImGuiCol_Text);
+    const float textOffsetY = (style.tileSize - ImGui::GetFontSize()) * 0.5f;
+
+    for (int row = firstRow; row < lastRow; ++row) {
+        const float top = origin.y + row * pitch;
+        const std::size_t rowStart = static_cast<std::size_t>(row) * map.width;
+
+        for (int col = firstCol; col < lastCol; ++col) {
+            const float left = origin.x + col * pitch;
+            const Tile tile = map.tileAt(rowStart + static_cast<std::size_t>(col));
+            const bool isHovered = row * map.width + col == hoveredTileIndex;
+
+            drawList->AddRectFilled(
+                ImVec2(left, top),
+                ImVec2(left + style.tileSize, top + style.tileSize),
+                isHovered ? hoveredTileColor : tileColor,
+                imguiStyle.FrameRounding
+            );
+
+            const std::string_view text = labelCache.label(tile);
+            const float textOffsetX = (style.tileSize - labelCache.labelWidth(tile)) * 0.5f;
+            drawList->AddText(
+                ImVec2(left + textOffsetX, top + textOffsetY),
+                textColor,
+                text.data(),
+                text.data() + text.size()
+            );
+        }
+    }
+
+    return hoveredTileIndex;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core/StageStore.hpp"
+
+#include <string_view>
+#include <vector>
+
+struct ImFont;
+
+// Decimal labels for tile numbers, formatted once and reused every frame.
+// Label widths are measured lazily and re-measured when the font changes.
+class TileLabelCache {
+public:
+    std::string_view label(Tile tile);
+    float labelWidth(Tile tile);
+
+private:
+    static constexpr int kSlotSize = 8;
+    static constexpr float kUnmeasuredWidth = -1.0f;
+
+    void ensureCapacity(Tile tile);
+
+    // Slot t holds the label of tile t: a length byte followed by the digits.
+    std::vector<char> slots_;
+    std::vector<float> widths_;
+    const ImFont* measuredFont_ = nullptr;
+    float measuredFontSize_ = 0.0f;
+};
+
+struct TileGridStyle {
+    float tileSize = 28.0f;
+    float tileGap = 4.0f;
+};
+
+// Draws a map as a grid of button-styled tiles straight into the current
+// window's draw list. The whole grid is laid out as a single item so the
+// window scrolls over it, but only rows and columns inside the visible clip
+// rect are drawn, so the cost per frame follows the visible area rather than
+// the map size. Returns the index of the hovered tile, or -1.
+int drawTileGrid(const char* id, const MapView& map, TileLabelCache& labelCache, const TileGridStyle& style = {});